@@ -0,0 +1,87 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include "../include/Xecutor.hpp"
+#include "../include/StealingXecutor.hpp"
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+// bursts of short jobs separated by idle gaps, long enough for workers to go back to sleep
+// (or, with a short timeout, to expire) before the next burst arrives
+constexpr int Bursts = 200;
+constexpr int BurstSize = 64;
+constexpr auto Gap = 5ms;
+
+struct Latency
+{
+    double p50;
+    double p99;
+    double max;
+};
+
+Latency run_bursts(Crotine::Executor& executor)
+{
+    std::vector<double> samples(Bursts * BurstSize);
+    for(int burst = 0; burst < Bursts; ++burst)
+    {
+        std::atomic_int done = 0;
+        for(int i = 0; i < BurstSize; ++i)
+        {
+            auto& sample = samples[burst * BurstSize + i];
+            auto enqueued = Clock::now();
+            executor.execute([&sample, &done, enqueued]()
+            {
+                sample = std::chrono::duration<double, std::micro>(Clock::now() - enqueued).count();
+                if(done.fetch_add(1) + 1 == BurstSize)
+                {
+                    done.notify_all();
+                }
+            });
+        }
+        for(auto current = done.load(); current != BurstSize; current = done.load())
+        {
+            done.wait(current);
+        }
+        std::this_thread::sleep_for(Gap);
+    }
+    std::sort(samples.begin(), samples.end());
+    return { samples[samples.size() / 2], samples[samples.size() * 99 / 100], samples.back() };
+}
+
+void report(const char* name, Crotine::Executor& executor)
+{
+    auto latency = run_bursts(executor);
+    std::cout << std::left << std::setw(36) << name << std::fixed << std::setprecision(1)
+              << latency.p50 << "\t" << latency.p99 << "\t" << latency.max << "\n";
+}
+
+int main()
+{
+    unsigned int threads = std::min(8u, std::max(2u, std::thread::hardware_concurrency()));
+    std::cout << "enqueue-to-start latency in us, " << Bursts << " bursts of " << BurstSize << " jobs, " << threads << " workers\n";
+    std::cout << std::left << std::setw(36) << "executor" << "p50\tp99\tmax\n";
+    {
+        // workers expire during every gap, each burst pays for thread creation again
+        Crotine::Xecutor pool(threads, 1ms);
+        report("Xecutor, 1ms timeout", pool);
+    }
+    {
+        Crotine::Xecutor pool(threads);
+        report("Xecutor, default timeout", pool);
+    }
+    {
+        Crotine::Xecutor pool(threads, 5000ms, threads);
+        report("Xecutor, all workers persistent", pool);
+    }
+    {
+        Crotine::StealingXecutor pool(threads);
+        report("StealingXecutor", pool);
+    }
+    return 0;
+}
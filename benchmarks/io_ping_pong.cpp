@@ -0,0 +1,91 @@
+#include <chrono>
+#include <thread>
+#include <iostream>
+
+#include <sys/socket.h>
+
+#include "../include/Task.hpp"
+#include "../include/IoExecutor.hpp"
+
+// one message bounces between both ends of a socketpair Rounds times
+constexpr int Rounds = 20000;
+constexpr std::size_t MessageSize = 64;
+
+Crotine::Task<void> bounce(Crotine::IoExecutor& io, int fd, bool starts)
+{
+    std::byte buffer[MessageSize] = {};
+    for (int i = 0; i < Rounds; ++i)
+    {
+        if (starts)
+        {
+            co_await io.send(fd, buffer);
+            co_await io.recv(fd, buffer, MSG_WAITALL);
+        }
+        else
+        {
+            co_await io.recv(fd, buffer, MSG_WAITALL);
+            co_await io.send(fd, buffer);
+        }
+    }
+}
+
+double run_io(Crotine::IoExecutor::Backend backend)
+{
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    Crotine::IoExecutor io(backend);
+    auto start = std::chrono::steady_clock::now();
+    auto ping = bounce(io, fds[0], true);
+    auto pong = bounce(io, fds[1], false);
+    // both ends live on the loop thread, no OS thread is parked in a syscall
+    ping.set_execution_ctx(io);
+    pong.set_execution_ctx(io);
+    pong.execute_async();
+    ping.execute_async();
+    ping.getPromise().Wait();
+    pong.getPromise().Wait();
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return elapsed;
+}
+
+double run_blocking_threads()
+{
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    auto start = std::chrono::steady_clock::now();
+    std::thread pong([fd = fds[1]]()
+    {
+        char buffer[MessageSize];
+        for (int i = 0; i < Rounds; ++i)
+        {
+            ::recv(fd, buffer, MessageSize, MSG_WAITALL);
+            ::send(fd, buffer, MessageSize, 0);
+        }
+    });
+    char buffer[MessageSize] = {};
+    for (int i = 0; i < Rounds; ++i)
+    {
+        ::send(fds[0], buffer, MessageSize, 0);
+        ::recv(fds[0], buffer, MessageSize, MSG_WAITALL);
+    }
+    pong.join();
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return elapsed;
+}
+
+int main()
+{
+    std::cout << "mode\tround trips\ttime(ms)\n";
+    std::cout << "blocking threads\t" << Rounds << "\t" << run_blocking_threads() << "\n";
+    std::cout << "epoll\t" << Rounds << "\t" << run_io(Crotine::IoExecutor::Backend::Epoll) << "\n";
+    Crotine::IoExecutor probe;
+    if (probe.backend() == Crotine::IoExecutor::Backend::IoUring)
+    {
+        std::cout << "io_uring\t" << Rounds << "\t" << run_io(Crotine::IoExecutor::Backend::IoUring) << "\n";
+    }
+    return 0;
+}
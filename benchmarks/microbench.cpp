@@ -0,0 +1,628 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <coroutine>
+#include <stop_token>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/RunLoop.hpp"
+#include "../include/Strand.hpp"
+#include "../include/AsyncScope.hpp"
+#include "../include/Generator.hpp"
+#include "../include/AsyncGenerator.hpp"
+#include "../include/BlockChannel.hpp"
+#include "../include/Cancellation.hpp"
+
+// microbenchmarks of the hot paths, one JSON document in the google benchmark format on stdout
+// (or --out file) so runs can be diffed with the usual tooling, a readable table goes to stderr
+//
+// usage: microbench [--filter substring] [--repetitions n] [--scale factor] [--out file]
+//   --repetitions  runs of every benchmark, the median is reported (default 5)
+//   --scale        multiplies the iteration counts, e.g. 0.01 for a smoke run
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::string filter;
+    int repetitions = 5;
+    double scale = 1.0;
+    std::string out;
+};
+
+struct Result
+{
+    std::string name;
+    std::size_t iterations = 0;
+    int repetitions = 0;
+    // per iteration, median / fastest / slowest repetition
+    double ns = 0;
+    double min_ns = 0;
+    double max_ns = 0;
+};
+
+// runs everything on the calling thread, isolates the coroutine machinery from any queueing
+class InlineExecutor : public Crotine::Executor
+{
+    public:
+        void execute(Crotine::Job func) override
+        {
+            func();
+        }
+};
+
+template <typename T>
+void keep(T&& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// registers as the waiter of a task that has not started yet and then starts it through symmetric transfer,
+// the awaiting coroutine is resumed from the task's final suspension, the pending await path
+// Move picks what co_await std::move(task) yields over what co_await task yields
+template <typename T, bool Move = false>
+struct StartAndAwait
+{
+    Crotine::Task<T>& task;
+    typename Crotine::Task<T>::template BasicAwaiter<Move> awaiter;
+    StartAndAwait(Crotine::Task<T>& task) : task(task), awaiter(task.getPromise())
+    {}
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+        if (awaiter.await_suspend(handle) == handle)
+        {
+            return handle;
+        }
+        return std::coroutine_handle<typename Crotine::Task<T>::PromiseType>::from_promise(task.getPromise());
+    }
+    decltype(auto) await_resume()
+    {
+        return awaiter.await_resume();
+    }
+};
+
+Crotine::Task<int> leaf(int value)
+{
+    co_return value;
+}
+
+// drives a coroutine lambda to completion on the calling thread, the lambda outlives its frame
+template <typename Body>
+void run_inline(InlineExecutor& executor, Body body)
+{
+    auto task = body();
+    task.set_execution_ctx(executor);
+    task.execute_async();
+    task.getPromise().getWaitedValue();
+}
+
+Crotine::Task<int> chain(Crotine::Executor& executor, int depth)
+{
+    if (depth == 0)
+    {
+        co_return 0;
+    }
+    auto child = chain(executor, depth - 1);
+    child.set_execution_ctx(executor);
+    co_return co_await StartAndAwait<int>{child} + 1;
+}
+
+// same chain through the executor queue, every level is started with execute_async like user code does
+Crotine::Task<int> queued_chain(Crotine::Executor& executor, int depth)
+{
+    if (depth == 0)
+    {
+        co_return 0;
+    }
+    auto child = queued_chain(executor, depth - 1);
+    child.set_execution_ctx(executor);
+    child.execute_async();
+    co_return co_await child + 1;
+}
+
+Crotine::Generator<std::size_t> sequence(std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        co_yield i;
+    }
+}
+
+Crotine::AsyncGenerator<std::size_t> async_sequence(std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        co_yield i;
+    }
+}
+
+// a large result handed up a chain of tasks, by copy, by move and by reference
+using Buffer = std::vector<int>;
+
+Crotine::Task<Buffer> pass_copy(Crotine::Executor& executor, Buffer& source, int hops)
+{
+    if (hops == 0)
+    {
+        co_return std::move(source);
+    }
+    auto child = pass_copy(executor, source, hops - 1);
+    child.set_execution_ctx(executor);
+    Buffer buffer = co_await StartAndAwait<Buffer>{child};
+    co_return buffer;
+}
+
+Crotine::Task<Buffer> pass_move(Crotine::Executor& executor, Buffer& source, int hops)
+{
+    if (hops == 0)
+    {
+        co_return std::move(source);
+    }
+    auto child = pass_move(executor, source, hops - 1);
+    child.set_execution_ctx(executor);
+    co_return co_await StartAndAwait<Buffer, true>{child};
+}
+
+Crotine::Task<const Buffer&> pass_reference(Crotine::Executor& executor, const Buffer& source, int hops)
+{
+    if (hops == 0)
+    {
+        co_return source;
+    }
+    auto child = pass_reference(executor, source, hops - 1);
+    child.set_execution_ctx(executor);
+    co_return co_await StartAndAwait<const Buffer&>{child};
+}
+
+class Suite
+{
+    private:
+        Options _options;
+        std::vector<Result> _results;
+    public:
+        explicit Suite(Options options) : _options(std::move(options))
+        {}
+        auto iterations(std::size_t count) const -> std::size_t
+        {
+            return std::max<std::size_t>(1, static_cast<std::size_t>(static_cast<double>(count) * _options.scale));
+        }
+        // body runs the given number of iterations, timed as a whole
+        void run(const std::string& name, std::size_t count, const std::function<void(std::size_t)>& body)
+        {
+            if (!_options.filter.empty() && name.find(_options.filter) == std::string::npos)
+            {
+                return;
+            }
+            auto total = iterations(count);
+            std::vector<double> samples;
+            for (int i = 0; i < _options.repetitions; ++i)
+            {
+                auto start = Clock::now();
+                body(total);
+                auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+                samples.push_back(elapsed / static_cast<double>(total));
+            }
+            std::sort(samples.begin(), samples.end());
+            Result result{name, total, _options.repetitions, samples[samples.size() / 2], samples.front(), samples.back()};
+            std::fprintf(stderr, "%-48s %12zu it %14.1f ns/it  [%.1f .. %.1f]\n", name.c_str(), total, result.ns, result.min_ns, result.max_ns);
+            _results.push_back(result);
+        }
+        void report() const
+        {
+            std::ostringstream json;
+            json << "{\n  \"context\": {\n"
+                 << "    \"library\": \"crotine\",\n"
+                 << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+                 << "    \"repetitions\": " << _options.repetitions << ",\n"
+                 << "    \"scale\": " << _options.scale << "\n"
+                 << "  },\n  \"benchmarks\": [";
+            for (std::size_t i = 0; i < _results.size(); ++i)
+            {
+                auto& result = _results[i];
+                json << (i ? ",\n" : "\n")
+                     << "    {\"name\": \"" << result.name << "\", \"run_type\": \"iteration\""
+                     << ", \"iterations\": " << result.iterations << ", \"repetitions\": " << result.repetitions
+                     << ", \"real_time\": " << result.ns << ", \"min_time\": " << result.min_ns << ", \"max_time\": " << result.max_ns
+                     << ", \"items_per_second\": " << (result.ns > 0 ? 1e9 / result.ns : 0.0) << ", \"time_unit\": \"ns\"}";
+            }
+            json << "\n  ]\n}\n";
+            if (_options.out.empty())
+            {
+                std::cout << json.str();
+            }
+            else
+            {
+                std::ofstream(_options.out) << json.str();
+            }
+        }
+};
+
+void task_benchmarks(Suite& suite)
+{
+    InlineExecutor inline_executor;
+
+    // frame allocation and destruction of a task that never runs
+    suite.run("task/create_destroy", 2'000'000, [](std::size_t iterations)
+    {
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            auto task = leaf(static_cast<int>(i));
+            keep(task);
+        }
+    });
+
+    // create, run to completion on the calling thread, read the value, destroy
+    suite.run("task/create_run_destroy", 2'000'000, [&inline_executor](std::size_t iterations)
+    {
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            auto task = leaf(static_cast<int>(i));
+            task.set_execution_ctx(inline_executor);
+            task.execute_async();
+            auto value = task.getPromise().getWaitedValue();
+            keep(value);
+        }
+    });
+
+    // fire and forget into a scope, the frame frees itself and only the scope's counter tracks it
+    suite.run("scope/spawn_run", 2'000'000, [&inline_executor](std::size_t iterations)
+    {
+        Crotine::AsyncScope scope(inline_executor);
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            scope.spawn(leaf(static_cast<int>(i)));
+        }
+        scope.wait();
+    });
+
+    // the task is already resolved, await_ready short-circuits the suspension
+    suite.run("await/ready", 10'000'000, [&inline_executor](std::size_t iterations)
+    {
+        run_inline(inline_executor, [&inline_executor, iterations]() -> Crotine::Task<void>
+        {
+            auto ready = leaf(1);
+            ready.set_execution_ctx(inline_executor);
+            ready.execute_async();
+            long sum = 0;
+            for (std::size_t i = 0; i < iterations; ++i)
+            {
+                sum += co_await ready;
+            }
+            keep(sum);
+        });
+    });
+
+    // the awaiter registers on an unstarted child and is resumed from its final suspension, includes the child frame
+    suite.run("await/pending", 2'000'000, [&inline_executor](std::size_t iterations)
+    {
+        run_inline(inline_executor, [&inline_executor, iterations]() -> Crotine::Task<void>
+        {
+            long sum = 0;
+            for (std::size_t i = 0; i < iterations; ++i)
+            {
+                auto child = leaf(static_cast<int>(i));
+                child.set_execution_ctx(inline_executor);
+                sum += co_await StartAndAwait<int>{child};
+            }
+            keep(sum);
+        });
+    });
+
+    // per level cost of a chain of awaiting tasks, completion travels back up through symmetric transfer
+    constexpr int Depth = 10000;
+    suite.run("await/chain_inline/depth:10000", 200, [&inline_executor](std::size_t iterations)
+    {
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            auto task = chain(inline_executor, Depth);
+            task.set_execution_ctx(inline_executor);
+            task.execute_async();
+            auto value = task.getPromise().getWaitedValue();
+            keep(value);
+        }
+    });
+    suite.run("await/chain_xecutor/depth:10000", 50, [](std::size_t iterations)
+    {
+        Crotine::Xecutor pool(1, std::chrono::milliseconds(5000), 1);
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            auto task = queued_chain(pool, Depth);
+            task.set_execution_ctx(pool);
+            task.execute_async();
+            auto value = task.getPromise().getWaitedValue();
+            keep(value);
+        }
+    });
+}
+
+void generator_benchmarks(Suite& suite)
+{
+    InlineExecutor inline_executor;
+
+    // one resume and one suspension per element
+    suite.run("generator/yield", 10'000'000, [](std::size_t iterations)
+    {
+        std::size_t sum = 0;
+        for (auto value : sequence(iterations))
+        {
+            sum += value;
+        }
+        keep(sum);
+    });
+
+    // consumer and body hand over through symmetric transfer on a shared executor
+    suite.run("async_generator/yield", 10'000'000, [&inline_executor](std::size_t iterations)
+    {
+        run_inline(inline_executor, [iterations]() -> Crotine::Task<void>
+        {
+            auto stream = async_sequence(iterations);
+            std::size_t sum = 0;
+            while (auto* value = co_await stream.next())
+            {
+                sum += *value;
+            }
+            keep(sum);
+        });
+    });
+}
+
+void cancellation_benchmarks(Suite& suite)
+{
+    InlineExecutor inline_executor;
+
+    // the explicit check in a hot loop, without a stop token and with one nobody stops
+    for (bool with_token : { false, true })
+    {
+        suite.run(std::string("cancel/throw_if_cancelled/token:") + (with_token ? "1" : "0"), 10'000'000, [&inline_executor, with_token](std::size_t iterations)
+        {
+            std::stop_source stop;
+            auto task = [](std::size_t iterations) -> Crotine::Task<void>
+            {
+                for (std::size_t i = 0; i < iterations; ++i)
+                {
+                    co_await Crotine::throw_if_cancelled{};
+                }
+            }(iterations);
+            task.set_execution_ctx(inline_executor);
+            if (with_token)
+            {
+                task.set_stop_token(stop.get_token());
+            }
+            task.execute_async();
+            task.getPromise().getWaitedValue();
+        });
+    }
+}
+
+void result_benchmarks(Suite& suite)
+{
+    InlineExecutor inline_executor;
+    constexpr int Hops = 4;
+    Buffer source(1 << 20, 1);
+
+    // every hop copies the 4 MB vector once, the source is refilled from the result
+    suite.run("result/vector_4mb/hops:4/copy", 100, [&](std::size_t iterations)
+    {
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            auto task = pass_copy(inline_executor, source, Hops);
+            task.set_execution_ctx(inline_executor);
+            task.execute_async();
+            source = std::move(task.getPromise().getWaitedValue());
+        }
+    });
+    suite.run("result/vector_4mb/hops:4/move", 100, [&](std::size_t iterations)
+    {
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            auto task = pass_move(inline_executor, source, Hops);
+            task.set_execution_ctx(inline_executor);
+            task.execute_async();
+            source = std::move(task.getPromise().getWaitedValue());
+        }
+    });
+    suite.run("result/vector_4mb/hops:4/reference", 100, [&](std::size_t iterations)
+    {
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            auto task = pass_reference(inline_executor, source, Hops);
+            task.set_execution_ctx(inline_executor);
+            task.execute_async();
+            keep(task.getPromise().getWaitedValue());
+        }
+    });
+}
+
+void executor_benchmarks(Suite& suite)
+{
+    // a blocked caller starts a task on a warm pool and waits for its value
+    suite.run("xecutor/execute_async_round_trip", 50'000, [](std::size_t iterations)
+    {
+        Crotine::Xecutor pool(1, std::chrono::milliseconds(5000), 1);
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            auto task = leaf(static_cast<int>(i));
+            task.set_execution_ctx(pool);
+            task.execute_async();
+            auto value = task.getPromise().getWaitedValue();
+            keep(value);
+        }
+    });
+
+    // the same round trip driven by the calling thread, no worker to hand over to
+    suite.run("run_loop/sync_wait", 1'000'000, [](std::size_t iterations)
+    {
+        Crotine::RunLoop loop;
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            keep(Crotine::sync_wait(loop, leaf(static_cast<int>(i))));
+        }
+    });
+
+    // post and run empty jobs in batches of 64 on a warm loop
+    suite.run("run_loop/post_poll", 5'000'000, [](std::size_t iterations)
+    {
+        Crotine::RunLoop loop;
+        std::size_t done = 0;
+        for (std::size_t i = 0; i < iterations; i += 64)
+        {
+            for (std::size_t j = 0; j < 64; ++j)
+            {
+                loop.execute([&done]() { ++done; });
+            }
+            loop.poll();
+        }
+        keep(static_cast<int>(done));
+    });
+
+    // one producer floods the pool with empty jobs, the time per job until all of them ran
+    for (unsigned int threads : {1u, 2u, 4u, 8u})
+    {
+        suite.run("xecutor/throughput/threads:" + std::to_string(threads), 500'000, [threads](std::size_t iterations)
+        {
+            Crotine::Xecutor pool(threads, std::chrono::milliseconds(5000), threads);
+            std::atomic_size_t done = 0;
+            for (std::size_t i = 0; i < iterations; ++i)
+            {
+                pool.execute([&done]()
+                {
+                    done.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+            while (done.load() != iterations)
+            {
+                std::this_thread::yield();
+            }
+        });
+    }
+}
+
+void strand_benchmarks(Suite& suite)
+{
+    // producers posting increments of a plain counter through one strand, the time per job until all of them ran
+    for (unsigned int producers : {1u, 4u})
+    {
+        suite.run("strand/throughput/producers:" + std::to_string(producers), 500'000, [producers](std::size_t iterations)
+        {
+            Crotine::Xecutor pool(4, std::chrono::milliseconds(5000), 4);
+            Crotine::Strand strand(pool);
+            std::size_t counter = 0;
+            std::atomic_size_t done = 0;
+            std::vector<std::thread> threads;
+            for (unsigned int p = 0; p < producers; ++p)
+            {
+                threads.emplace_back([&, p]()
+                {
+                    for (std::size_t i = p; i < iterations; i += producers)
+                    {
+                        strand.execute([&]()
+                        {
+                            if (++counter == iterations)
+                            {
+                                done.store(1, std::memory_order_release);
+                            }
+                        });
+                    }
+                });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            while (done.load(std::memory_order_acquire) == 0)
+            {
+                std::this_thread::yield();
+            }
+        });
+    }
+}
+
+void channel_benchmarks(Suite& suite)
+{
+    // producers and consumers hammering one channel, the time per item moved through it
+    for (unsigned int pairs : {1u, 2u, 4u})
+    {
+        suite.run("block_channel/put_take/pairs:" + std::to_string(pairs), 1'000'000, [pairs](std::size_t iterations)
+        {
+            Crotine::BlockChannel<std::size_t> channel;
+            auto share = iterations / pairs;
+            std::vector<std::thread> threads;
+            for (unsigned int p = 0; p < pairs; ++p)
+            {
+                threads.emplace_back([&channel, share]()
+                {
+                    for (std::size_t i = 0; i < share; ++i)
+                    {
+                        channel.put(i);
+                    }
+                });
+                threads.emplace_back([&channel, share]()
+                {
+                    std::size_t sum = 0;
+                    for (std::size_t i = 0; i < share; ++i)
+                    {
+                        sum += *channel.take();
+                    }
+                    keep(sum);
+                });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        });
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (i + 1 < argc && argument == "--filter")
+        {
+            options.filter = argv[++i];
+        }
+        else if (i + 1 < argc && argument == "--repetitions")
+        {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (i + 1 < argc && argument == "--scale")
+        {
+            options.scale = std::atof(argv[++i]);
+        }
+        else if (i + 1 < argc && argument == "--out")
+        {
+            options.out = argv[++i];
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--filter substring] [--repetitions n] [--scale factor] [--out file]\n";
+            return 2;
+        }
+    }
+    Suite suite(options);
+    task_benchmarks(suite);
+    generator_benchmarks(suite);
+    cancellation_benchmarks(suite);
+    result_benchmarks(suite);
+    executor_benchmarks(suite);
+    strand_benchmarks(suite);
+    channel_benchmarks(suite);
+    suite.report();
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <numeric>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#ifdef CROTINE_HAVE_STD_PAR
+#include <execution>
+#endif
+
+#include "../include/Xecutor.hpp"
+#include "../include/Parallel.hpp"
+
+// a cheap map (sum of squares) and an expensive one (a few transcendental calls per element) over the same data,
+// serial loop vs Crotine::parallel_* on an Xecutor vs std::execution::par when the standard library has a backend
+constexpr std::size_t Elements = std::size_t{1} << 22;
+constexpr int Rounds = 5;
+
+double light(double value)
+{
+    return value * value;
+}
+
+double heavy(double value)
+{
+    return std::sqrt(std::sin(value) * std::sin(value) + std::cos(value) * std::cos(value) + value);
+}
+
+// best of Rounds, in milliseconds
+template <typename F>
+double measure(F&& run, double& sink)
+{
+    double best = 1e300;
+    for (int round = 0; round < Rounds; ++round)
+    {
+        auto start = std::chrono::steady_clock::now();
+        sink += run();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+template <typename Map>
+void compare(const char* name, Map map, const std::vector<double>& data, Crotine::Executor& pool, double& sink)
+{
+    auto serial = measure([&]()
+    {
+        double sum = 0;
+        for (auto value : data)
+        {
+            sum += map(value);
+        }
+        return sum;
+    }, sink);
+    auto crotine = measure([&]() { return Crotine::parallel_reduce(pool, data, 0.0, std::plus<>{}, map).get(); }, sink);
+    std::cout << name << "\t" << serial << "\t" << crotine;
+#ifdef CROTINE_HAVE_STD_PAR
+    auto standard = measure([&]() { return std::transform_reduce(std::execution::par, data.begin(), data.end(), 0.0, std::plus<>{}, map); }, sink);
+    std::cout << "\t" << standard;
+#else
+    std::cout << "\t-";
+#endif
+    std::cout << "\n";
+}
+
+int main()
+{
+    std::vector<double> data(Elements);
+    std::iota(data.begin(), data.end(), 0.0);
+    double sink = 0;
+    Crotine::Xecutor pool(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::cout << Elements << " elements, " << pool.getWorkerCount() << " workers\n";
+    std::cout << "reduce\tserial(ms)\tCrotine(ms)\tstd::execution::par(ms)\n";
+    compare("light", light, data, pool, sink);
+    compare("heavy", heavy, data, pool, sink);
+
+    std::vector<double> output(Elements);
+    auto transform = measure([&]()
+    {
+        Crotine::parallel_transform(pool, data, output, heavy).get();
+        return output.back();
+    }, sink);
+    auto serial_transform = measure([&]()
+    {
+        std::transform(data.begin(), data.end(), output.begin(), heavy);
+        return output.back();
+    }, sink);
+    std::cout << "transform\t" << serial_transform << "\t" << transform;
+#ifdef CROTINE_HAVE_STD_PAR
+    auto standard_transform = measure([&]()
+    {
+        std::transform(std::execution::par, data.begin(), data.end(), output.begin(), heavy);
+        return output.back();
+    }, sink);
+    std::cout << "\t" << standard_transform;
+#else
+    std::cout << "\t-";
+#endif
+    std::cout << "\n";
+
+    // keeps the work from being optimized away
+    return sink == 0.5 ? 1 : 0;
+}
@@ -0,0 +1,78 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include "../include/Xecutor.hpp"
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+// interactive requests trickle in while the pool is flooded with background compaction work
+constexpr int FloodJobs = 40000;
+constexpr auto FloodJobCost = 25us;
+constexpr int Requests = 400;
+constexpr auto RequestGap = 500us;
+
+void burn(std::chrono::microseconds cost)
+{
+    auto until = Clock::now() + cost;
+    while (Clock::now() < until)
+    {}
+}
+
+void run(const char* name, Crotine::Priority flood_priority, Crotine::Priority request_priority)
+{
+    unsigned int threads = std::max(2u, std::thread::hardware_concurrency());
+    Crotine::Xecutor pool(threads, 5000ms, threads);
+    std::atomic_int flood_done = 0;
+    std::vector<Crotine::Job> flood;
+    for (int i = 0; i < FloodJobs; ++i)
+    {
+        flood.push_back([&flood_done]()
+        {
+            burn(FloodJobCost);
+            flood_done.fetch_add(1);
+        });
+    }
+    pool.execute_batch(flood, flood_priority);
+
+    std::vector<double> latencies(Requests);
+    std::atomic_int answered = 0;
+    for (int i = 0; i < Requests; ++i)
+    {
+        auto sent = Clock::now();
+        pool.execute_with_priority([&latencies, &answered, sent, i]()
+        {
+            latencies[i] = std::chrono::duration<double, std::micro>(Clock::now() - sent).count();
+            answered.fetch_add(1);
+        }, request_priority);
+        std::this_thread::sleep_for(RequestGap);
+    }
+    while (answered.load() != Requests)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+    auto flood_lane = pool.getLaneStats(flood_priority);
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << std::left << std::setw(44) << name << std::fixed << std::setprecision(1)
+              << latencies[Requests / 2] << "\t" << latencies[Requests * 99 / 100] << "\t"
+              << flood_lane.peak_depth << "\t" << flood_lane.depth << "\n";
+    // drain the flood before the pool goes away so every run starts from an empty pool
+    while (flood_done.load() != FloodJobs)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+int main()
+{
+    std::cout << "request latency in us under a flood of " << FloodJobs << " background jobs\n";
+    std::cout << std::left << std::setw(44) << "setup" << "p50\tp99\tflood peak depth\tflood depth at end\n";
+    run("everything Normal", Crotine::Priority::Normal, Crotine::Priority::Normal);
+    run("flood Background, requests Critical", Crotine::Priority::Background, Crotine::Priority::Critical);
+    return 0;
+}
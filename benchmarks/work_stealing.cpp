@@ -0,0 +1,59 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+#include "../include/Xecutor.hpp"
+#include "../include/StealingXecutor.hpp"
+
+// every node of the tree posts its children back to the same executor,
+// which is the fan-out pattern that hammers the single shared Xecutor queue
+constexpr unsigned int TreeDepth = 14;
+constexpr unsigned int Roots = 8;
+constexpr std::size_t TotalNodes = Roots * ((std::size_t{1} << (TreeDepth + 1)) - 1);
+
+void spawn(Crotine::Executor& executor, unsigned int depth, std::atomic_size_t& finished)
+{
+    if(depth < TreeDepth)
+    {
+        executor.execute([&executor, depth, &finished]() { spawn(executor, depth + 1, finished); });
+        executor.execute([&executor, depth, &finished]() { spawn(executor, depth + 1, finished); });
+    }
+    if(finished.fetch_add(1) + 1 == TotalNodes)
+    {
+        finished.notify_all();
+    }
+}
+
+double run_fan_out(Crotine::Executor& executor)
+{
+    std::atomic_size_t finished = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int i = 0; i < Roots; ++i)
+    {
+        executor.execute([&executor, &finished]() { spawn(executor, 0, finished); });
+    }
+    for(auto done = finished.load(); done != TotalNodes; done = finished.load())
+    {
+        finished.wait(done);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    std::cout << "threads\tXecutor(ms)\tStealingXecutor(ms)\n";
+    for(unsigned int threads : {1u, 4u, 16u, 64u})
+    {
+        double shared_ms = 0, stealing_ms = 0;
+        {
+            Crotine::Xecutor pool(threads);
+            shared_ms = run_fan_out(pool);
+        }
+        {
+            Crotine::StealingXecutor pool(threads);
+            stealing_ms = run_fan_out(pool);
+        }
+        std::cout << threads << "\t" << shared_ms << "\t" << stealing_ms << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,523 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <cstddef>
+#include <utility>
+#include <optional>
+#include <coroutine>
+#include <stop_token>
+
+#include "PromiseBase.hpp"
+#include "Cancellation.hpp"
+
+namespace Crotine
+{
+    // channel between coroutines, co_await ch.send(v) / co_await ch.receive() suspend instead of blocking a thread
+    // a waiting peer gets the value handed over directly; if it runs on the executor of this thread it takes the
+    // thread over through symmetric transfer and the side that did not wait goes back to its executor, so a long
+    // pipeline never stacks its stages on one thread; a peer on another executor is posted there
+    // capacity 0 makes every send a rendezvous with a receiver
+    // a sender or receiver still waiting when a stop is requested for its coroutine leaves the queue and throws
+    // OperationCancelled, one that already got its value handed over completes normally
+    template <typename T>
+    class AsyncChannel
+    {
+        public:
+            static constexpr std::size_t Unbounded = static_cast<std::size_t>(-1);
+        private:
+            // without guaranteed tail calls (unoptimized GCC, sanitizers) every transfer nests on the stack,
+            // so every TransferBudget-th hand over on a thread posts the peer and lets the chain unwind
+            static constexpr unsigned int TransferBudget = 64;
+            inline static thread_local unsigned int _transfers = 0;
+        private:
+            // intrusive node embedded in the awaiter of a suspended sender or receiver
+            struct Waiter
+            {
+                Waiter* next = nullptr;
+                std::coroutine_handle<> handle = nullptr;
+                // the value a sender offers, or the value a receiver got
+                std::optional<T> item;
+                bool closed = false;
+                // both guarded by the channel mutex
+                bool cancelled = false;
+                bool stop_requested = false;
+            };
+            struct WaiterQueue
+            {
+                Waiter* head = nullptr;
+                Waiter* tail = nullptr;
+                public:
+                    void push(Waiter& waiter) noexcept;
+                    auto pop() noexcept -> Waiter*;
+                    auto take_all() noexcept -> Waiter*;
+                    // false if the waiter is not queued (any more)
+                    bool remove(Waiter& waiter) noexcept;
+            };
+            struct OnStop
+            {
+                AsyncChannel* channel;
+                WaiterQueue* queue;
+                Waiter* waiter;
+                void operator()() const noexcept;
+            };
+        private:
+            const std::size_t _capacity;
+            std::mutex _mutex;
+            std::deque<T> _buffer;
+            WaiterQueue _senders;
+            WaiterQueue _receivers;
+            bool _closed = false;
+        private:
+            // both with the mutex held, false if the waiter has to queue up; peer is set to a queued waiter it served
+            bool try_give(Waiter& sender, std::coroutine_handle<>& peer);
+            bool try_get(Waiter& receiver, std::coroutine_handle<>& peer);
+            // posts a peer that belongs to another executor, true if the caller can just go on
+            static bool post_if_foreign(std::coroutine_handle<> peer);
+            // what a suspended self continues with, self is posted unless it is queued; it never resumes inline
+            // from await_suspend, a build without guaranteed tail calls would grow the stack with every such resume
+            static auto hand_over(std::coroutine_handle<> self, std::coroutine_handle<> peer) -> std::coroutine_handle<>;
+            void cancel(WaiterQueue& queue, Waiter& waiter) noexcept;
+        public:
+            class SendAwaiter
+            {
+                private:
+                    AsyncChannel& _channel;
+                    Waiter _waiter;
+                    std::optional<std::stop_callback<OnStop>> _on_stop;
+                    // served in await_ready, gets this thread once we are suspended
+                    std::coroutine_handle<> _peer = nullptr;
+                public:
+                    SendAwaiter(AsyncChannel& channel, T value);
+                    SendAwaiter(const SendAwaiter&) = delete;
+                public:
+                    // completes right here unless we have to wait or a peer takes over
+                    bool await_ready();
+                    auto await_suspend(std::coroutine_handle<> handle) -> std::coroutine_handle<>;
+                    // false if the channel was closed before the value got through
+                    bool await_resume() const;
+            };
+            class ReceiveAwaiter
+            {
+                private:
+                    AsyncChannel& _channel;
+                    Waiter _waiter;
+                    std::optional<std::stop_callback<OnStop>> _on_stop;
+                    // served in await_ready, gets this thread once we are suspended
+                    std::coroutine_handle<> _peer = nullptr;
+                public:
+                    ReceiveAwaiter(AsyncChannel& channel);
+                    ReceiveAwaiter(const ReceiveAwaiter&) = delete;
+                public:
+                    // completes right here unless we have to wait or a peer takes over
+                    bool await_ready();
+                    auto await_suspend(std::coroutine_handle<> handle) -> std::coroutine_handle<>;
+                    // std::nullopt once the channel is closed and drained
+                    auto await_resume() -> std::optional<T>;
+            };
+        public:
+            explicit AsyncChannel(std::size_t capacity = Unbounded);
+            AsyncChannel(const AsyncChannel&) = delete;
+            ~AsyncChannel() = default;
+        public:
+            auto send(T value) -> SendAwaiter;
+            auto receive() -> ReceiveAwaiter;
+        public:
+            // non suspending variants for code outside of coroutines
+            bool try_send(T value);
+            auto try_receive() -> std::optional<T>;
+        public:
+            // wakes every suspended sender and receiver, values already buffered can still be received
+            void close();
+            bool isClosed();
+    };
+}
+
+template <typename T>
+inline void Crotine::AsyncChannel<T>::WaiterQueue::push(Waiter& waiter) noexcept
+{
+    waiter.next = nullptr;
+    if (tail)
+    {
+        tail->next = &waiter;
+    }
+    else
+    {
+        head = &waiter;
+    }
+    tail = &waiter;
+}
+
+template <typename T>
+inline auto Crotine::AsyncChannel<T>::WaiterQueue::pop() noexcept -> Waiter*
+{
+    auto* waiter = head;
+    if (waiter)
+    {
+        head = waiter->next;
+        if (!head)
+        {
+            tail = nullptr;
+        }
+    }
+    return waiter;
+}
+
+template <typename T>
+inline auto Crotine::AsyncChannel<T>::WaiterQueue::take_all() noexcept -> Waiter*
+{
+    tail = nullptr;
+    return std::exchange(head, nullptr);
+}
+
+template <typename T>
+inline bool Crotine::AsyncChannel<T>::WaiterQueue::remove(Waiter& waiter) noexcept
+{
+    // linear, but only a cancelled waiter takes this path
+    Waiter* previous = nullptr;
+    for (auto* current = head; current; previous = current, current = current->next)
+    {
+        if (current != &waiter)
+        {
+            continue;
+        }
+        (previous ? previous->next : head) = current->next;
+        if (tail == current)
+        {
+            tail = previous;
+        }
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+inline void Crotine::AsyncChannel<T>::OnStop::operator()() const noexcept
+{
+    channel->cancel(*queue, *waiter);
+}
+
+template <typename T>
+inline Crotine::AsyncChannel<T>::AsyncChannel(std::size_t capacity) : _capacity(capacity)
+{}
+
+template <typename T>
+inline bool Crotine::AsyncChannel<T>::try_give(Waiter& sender, std::coroutine_handle<>& peer)
+{
+    if (_closed)
+    {
+        sender.closed = true;
+        return true;
+    }
+    if (auto* receiver = _receivers.pop(); receiver)
+    {
+        receiver->item.emplace(std::move(*sender.item));
+        peer = receiver->handle;
+        return true;
+    }
+    if (_buffer.size() < _capacity)
+    {
+        _buffer.push_back(std::move(*sender.item));
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+inline bool Crotine::AsyncChannel<T>::try_get(Waiter& receiver, std::coroutine_handle<>& peer)
+{
+    if (!_buffer.empty())
+    {
+        receiver.item.emplace(std::move(_buffer.front()));
+        _buffer.pop_front();
+        // a slot just became free, the oldest blocked sender fills it
+        if (auto* sender = _senders.pop(); sender)
+        {
+            _buffer.push_back(std::move(*sender->item));
+            peer = sender->handle;
+        }
+        return true;
+    }
+    if (auto* sender = _senders.pop(); sender)
+    {
+        receiver.item.emplace(std::move(*sender->item));
+        peer = sender->handle;
+        return true;
+    }
+    return _closed;
+}
+
+template <typename T>
+inline bool Crotine::AsyncChannel<T>::post_if_foreign(std::coroutine_handle<> peer)
+{
+    if (&PromiseBase::execution_ctx_of(peer) == Executor::getCurrentExecutor())
+    {
+        return false;
+    }
+    PromiseBase::resume_on_ctx(peer);
+    return true;
+}
+
+template <typename T>
+inline auto Crotine::AsyncChannel<T>::hand_over(std::coroutine_handle<> self, std::coroutine_handle<> peer) -> std::coroutine_handle<>
+{
+    // decided up front, self may be running elsewhere as soon as it is posted
+    bool transfer = peer && &PromiseBase::execution_ctx_of(peer) == &PromiseBase::execution_ctx_of(self) && ++_transfers % TransferBudget != 0;
+    if (peer && !transfer)
+    {
+        PromiseBase::resume_on_ctx(peer);
+    }
+    PromiseBase::resume_on_ctx(self);
+    return transfer ? peer : std::noop_coroutine();
+}
+
+template <typename T>
+inline void Crotine::AsyncChannel<T>::cancel(WaiterQueue& queue, Waiter& waiter) noexcept
+{
+    std::coroutine_handle<> handle = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!queue.remove(waiter))
+        {
+            // not queued yet, await_suspend gives up instead of queueing it; or already served, then this is a no-op
+            waiter.stop_requested = true;
+            return;
+        }
+        waiter.cancelled = true;
+        handle = waiter.handle;
+    }
+    PromiseBase::resume_on_ctx(handle);
+}
+
+template <typename T>
+inline auto Crotine::AsyncChannel<T>::send(T value) -> SendAwaiter
+{
+    return { *this, std::move(value) };
+}
+
+template <typename T>
+inline auto Crotine::AsyncChannel<T>::receive() -> ReceiveAwaiter
+{
+    return { *this };
+}
+
+template <typename T>
+inline bool Crotine::AsyncChannel<T>::try_send(T value)
+{
+    std::coroutine_handle<> peer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_closed)
+        {
+            return false;
+        }
+        if (auto* receiver = _receivers.pop(); receiver)
+        {
+            receiver->item.emplace(std::move(value));
+            peer = receiver->handle;
+        }
+        else if (_buffer.size() < _capacity)
+        {
+            _buffer.push_back(std::move(value));
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    PromiseBase::resume_on_ctx(peer);
+    return true;
+}
+
+template <typename T>
+inline std::optional<T> Crotine::AsyncChannel<T>::try_receive()
+{
+    std::optional<T> item;
+    std::coroutine_handle<> peer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_buffer.empty())
+        {
+            item.emplace(std::move(_buffer.front()));
+            _buffer.pop_front();
+            if (auto* sender = _senders.pop(); sender)
+            {
+                _buffer.push_back(std::move(*sender->item));
+                peer = sender->handle;
+            }
+        }
+        else if (auto* sender = _senders.pop(); sender)
+        {
+            item.emplace(std::move(*sender->item));
+            peer = sender->handle;
+        }
+    }
+    if (peer)
+    {
+        PromiseBase::resume_on_ctx(peer);
+    }
+    return item;
+}
+
+template <typename T>
+inline void Crotine::AsyncChannel<T>::close()
+{
+    Waiter* senders = nullptr;
+    Waiter* receivers = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closed = true;
+        senders = _senders.take_all();
+        receivers = _receivers.take_all();
+        for (auto* sender = senders; sender; sender = sender->next)
+        {
+            sender->closed = true;
+        }
+    }
+    // a node is gone as soon as its coroutine resumes, read next first
+    for (auto* list : { senders, receivers })
+    {
+        while (list)
+        {
+            auto* next = list->next;
+            PromiseBase::resume_on_ctx(list->handle);
+            list = next;
+        }
+    }
+}
+
+template <typename T>
+inline bool Crotine::AsyncChannel<T>::isClosed()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _closed;
+}
+
+template <typename T>
+inline Crotine::AsyncChannel<T>::SendAwaiter::SendAwaiter(AsyncChannel& channel, T value) : _channel(channel)
+{
+    _waiter.item.emplace(std::move(value));
+}
+
+template <typename T>
+inline bool Crotine::AsyncChannel<T>::SendAwaiter::await_ready()
+{
+    std::coroutine_handle<> peer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_channel._mutex);
+        if (!_channel.try_give(_waiter, peer))
+        {
+            return false;
+        }
+    }
+    if (!peer || post_if_foreign(peer))
+    {
+        return true;
+    }
+    _peer = peer;
+    return false;
+}
+
+template <typename T>
+inline auto Crotine::AsyncChannel<T>::SendAwaiter::await_suspend(std::coroutine_handle<> handle) -> std::coroutine_handle<>
+{
+    if (_peer)
+    {
+        return hand_over(handle, _peer);
+    }
+    auto& stop_token = PromiseBase::stop_token_of(handle);
+    if (stop_token.stop_possible())
+    {
+        // registered outside the lock, the callback takes it
+        _on_stop.emplace(stop_token, OnStop{ &_channel, &_channel._senders, &_waiter });
+    }
+    std::coroutine_handle<> peer = nullptr;
+    {
+        // the channel may have changed since await_ready
+        std::lock_guard<std::mutex> lock(_channel._mutex);
+        if (!_channel.try_give(_waiter, peer))
+        {
+            if (!_waiter.stop_requested)
+            {
+                // full, the receiver that makes room takes the value out of our node
+                _waiter.handle = handle;
+                _channel._senders.push(_waiter);
+                return std::noop_coroutine();
+            }
+            _waiter.cancelled = true;
+        }
+    }
+    return hand_over(handle, peer);
+}
+
+template <typename T>
+inline bool Crotine::AsyncChannel<T>::SendAwaiter::await_resume() const
+{
+    if (_waiter.cancelled)
+    {
+        throw OperationCancelled();
+    }
+    return !_waiter.closed;
+}
+
+template <typename T>
+inline Crotine::AsyncChannel<T>::ReceiveAwaiter::ReceiveAwaiter(AsyncChannel& channel) : _channel(channel)
+{}
+
+template <typename T>
+inline bool Crotine::AsyncChannel<T>::ReceiveAwaiter::await_ready()
+{
+    std::coroutine_handle<> peer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_channel._mutex);
+        if (!_channel.try_get(_waiter, peer))
+        {
+            return false;
+        }
+    }
+    if (!peer || post_if_foreign(peer))
+    {
+        return true;
+    }
+    _peer = peer;
+    return false;
+}
+
+template <typename T>
+inline auto Crotine::AsyncChannel<T>::ReceiveAwaiter::await_suspend(std::coroutine_handle<> handle) -> std::coroutine_handle<>
+{
+    if (_peer)
+    {
+        return hand_over(handle, _peer);
+    }
+    auto& stop_token = PromiseBase::stop_token_of(handle);
+    if (stop_token.stop_possible())
+    {
+        _on_stop.emplace(stop_token, OnStop{ &_channel, &_channel._receivers, &_waiter });
+    }
+    std::coroutine_handle<> peer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_channel._mutex);
+        if (!_channel.try_get(_waiter, peer))
+        {
+            if (!_waiter.stop_requested)
+            {
+                _waiter.handle = handle;
+                _channel._receivers.push(_waiter);
+                return std::noop_coroutine();
+            }
+            _waiter.cancelled = true;
+        }
+    }
+    return hand_over(handle, peer);
+}
+
+template <typename T>
+inline std::optional<T> Crotine::AsyncChannel<T>::ReceiveAwaiter::await_resume()
+{
+    if (_waiter.cancelled)
+    {
+        throw OperationCancelled();
+    }
+    return std::move(_waiter.item);
+}
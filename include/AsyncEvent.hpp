@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+
+#include "utils/AsyncWaiter.hpp"
+
+namespace Crotine
+{
+    // event coroutines can co_await, set() releases every waiter at once
+    // stays set until reset() (manual reset), never resetting it makes a one-shot event
+    class AsyncEvent
+    {
+        private:
+            // set_tag() while set, otherwise the stack of suspended waiters
+            std::atomic<void*> _state;
+        private:
+            auto set_tag() noexcept -> void*;
+        public:
+            class Awaiter
+            {
+                private:
+                    AsyncEvent& _event;
+                    AsyncWaiter _waiter;
+                public:
+                    Awaiter(AsyncEvent& event);
+                public:
+                    bool await_ready() const noexcept;
+                    bool await_suspend(std::coroutine_handle<> handle) noexcept;
+                    void await_resume() const noexcept;
+            };
+        public:
+            explicit AsyncEvent(bool set = false);
+            AsyncEvent(const AsyncEvent&) = delete;
+            ~AsyncEvent() = default;
+        public:
+            void set();
+            void reset() noexcept;
+            bool isSet() const noexcept;
+        public:
+            auto operator co_await() noexcept -> Awaiter;
+    };
+}
+
+inline Crotine::AsyncEvent::AsyncEvent(bool set) : _state(set ? set_tag() : nullptr)
+{}
+
+inline void* Crotine::AsyncEvent::set_tag() noexcept
+{
+    // the event itself is never a waiter node, so its address marks the set state
+    return this;
+}
+
+inline void Crotine::AsyncEvent::set()
+{
+    auto* previous = _state.exchange(set_tag(), std::memory_order_acq_rel);
+    if (previous != set_tag())
+    {
+        resume_waiters(static_cast<AsyncWaiter*>(previous));
+    }
+}
+
+inline void Crotine::AsyncEvent::reset() noexcept
+{
+    void* expected = set_tag();
+    _state.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed);
+}
+
+inline bool Crotine::AsyncEvent::isSet() const noexcept
+{
+    return _state.load(std::memory_order_acquire) == const_cast<AsyncEvent*>(this)->set_tag();
+}
+
+inline Crotine::AsyncEvent::Awaiter Crotine::AsyncEvent::operator co_await() noexcept
+{
+    return { *this };
+}
+
+inline Crotine::AsyncEvent::Awaiter::Awaiter(AsyncEvent& event) : _event(event)
+{}
+
+inline bool Crotine::AsyncEvent::Awaiter::await_ready() const noexcept
+{
+    return _event.isSet();
+}
+
+inline bool Crotine::AsyncEvent::Awaiter::await_suspend(std::coroutine_handle<> handle) noexcept
+{
+    _waiter.handle = handle;
+    // fails if the event got set in the meantime, then we simply keep running
+    return push_waiter(_event._state, _waiter, _event.set_tag());
+}
+
+inline void Crotine::AsyncEvent::Awaiter::await_resume() const noexcept
+{}
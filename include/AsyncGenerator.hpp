@@ -0,0 +1,303 @@
+#pragma once
+#include <memory>
+#include <cstddef>
+#include <utility>
+#include <optional>
+#include <exception>
+#include <coroutine>
+#include <type_traits>
+
+#include "PromiseBase.hpp"
+#include "utils/FramePool.hpp"
+
+namespace Crotine
+{
+    // lazy asynchronous sequence, the body may co_await anything a Task can (tasks, timers, channels, io)
+    //   while (auto* item = co_await generator.next()) { use(*item); }
+    // next() runs the body up to its next co_yield and returns a pointer to the yielded object, nullptr at the end,
+    // so exactly one element is in flight and nothing is copied (same reference rules as Generator<T>)
+    // the body runs on its own execution context in its own priority lane, left unset it inherits the consumer's
+    // (and its stop token) on the first next(); the handoff is a direct symmetric transfer while both sides share an executor
+    // one next() at a time, and the generator must not be destroyed while a next() is pending
+    template <typename T>
+    class AsyncGenerator
+    {
+        public:
+            using value_type = std::remove_cvref_t<T>;
+            using reference = std::conditional_t<std::is_reference_v<T>, T, T&>;
+            using pointer = std::add_pointer_t<reference>;
+        public:
+            class PromiseType : public PromiseBase
+            {
+                private:
+                    // suspends the body and hands control back to the consumer waiting in next()
+                    class HandBack
+                    {
+                        private:
+                            PromiseType& _promise;
+                        public:
+                            HandBack(PromiseType& promise) noexcept;
+                        public:
+                            bool await_ready() const noexcept;
+                            auto await_suspend(std::coroutine_handle<>) noexcept -> std::coroutine_handle<>;
+                            void await_resume() const noexcept;
+                    };
+                private:
+                    pointer _current = nullptr;
+                    std::optional<value_type> _copy;
+                    std::exception_ptr _exception;
+                    std::coroutine_handle<> _consumer = nullptr;
+                public:
+                    auto get_return_object() -> AsyncGenerator;
+                    auto initial_suspend() const noexcept -> std::suspend_always;
+                    auto final_suspend() noexcept -> HandBack;
+                    void unhandled_exception() noexcept;
+                    void return_void() noexcept;
+                public:
+                    auto yield_value(std::remove_reference_t<reference>& value) noexcept -> HandBack;
+                    auto yield_value(std::remove_reference_t<reference>&& value) noexcept -> HandBack;
+                    auto yield_value(const value_type& value) -> HandBack
+                        requires (!std::is_reference_v<T> && !std::is_const_v<T>);
+#ifndef CROTINE_DISABLE_FRAME_POOL
+                public:
+                    static auto operator new(std::size_t size) -> void*;
+                    static void operator delete(void* ptr, std::size_t size) noexcept;
+#endif
+                public:
+                    // parks the consumer and returns the coroutine to run next, the body or nothing
+                    auto resume_for(std::coroutine_handle<> consumer) noexcept -> std::coroutine_handle<>;
+                    auto take_current() -> pointer;
+            };
+            using promise_type = PromiseType;
+            using Handle = std::coroutine_handle<PromiseType>;
+        public:
+            class NextAwaiter
+            {
+                private:
+                    Handle _handle;
+                public:
+                    NextAwaiter(Handle handle) noexcept;
+                public:
+                    bool await_ready() const noexcept;
+                    auto await_suspend(std::coroutine_handle<> handle) noexcept -> std::coroutine_handle<>;
+                    auto await_resume() -> pointer;
+            };
+        private:
+            Handle _handle;
+        public:
+            explicit AsyncGenerator(Handle handle) noexcept;
+            AsyncGenerator(const AsyncGenerator&) = delete;
+            AsyncGenerator(AsyncGenerator&& other) noexcept;
+            ~AsyncGenerator();
+        public:
+            AsyncGenerator& operator=(const AsyncGenerator&) = delete;
+            AsyncGenerator& operator=(AsyncGenerator&& other) noexcept;
+        public:
+            // pointer to the next element, valid until the following next(), nullptr once the body returned
+            auto next() -> NextAwaiter;
+            void set_execution_ctx(Executor& ctx);
+            void set_priority(Priority priority);
+    };
+}
+
+template <typename T>
+inline Crotine::AsyncGenerator<T>::PromiseType::HandBack::HandBack(PromiseType& promise) noexcept : _promise(promise)
+{}
+
+template <typename T>
+inline bool Crotine::AsyncGenerator<T>::PromiseType::HandBack::await_ready() const noexcept
+{
+    return false;
+}
+
+template <typename T>
+inline std::coroutine_handle<> Crotine::AsyncGenerator<T>::PromiseType::HandBack::await_suspend(std::coroutine_handle<>) noexcept
+{
+    auto consumer = std::exchange(_promise._consumer, nullptr);
+    if (!consumer)
+    {
+        return std::noop_coroutine();
+    }
+    if (&PromiseBase::execution_ctx_of(consumer) == &_promise.get_execution_ctx())
+    {
+        return consumer;
+    }
+    // the consumer may call next() again before we return, the promise is not touched after this
+    PromiseBase::resume_on_ctx(consumer);
+    return std::noop_coroutine();
+}
+
+template <typename T>
+inline void Crotine::AsyncGenerator<T>::PromiseType::HandBack::await_resume() const noexcept
+{}
+
+template <typename T>
+inline Crotine::AsyncGenerator<T> Crotine::AsyncGenerator<T>::PromiseType::get_return_object()
+{
+    return AsyncGenerator(Handle::from_promise(*this));
+}
+
+template <typename T>
+inline std::suspend_always Crotine::AsyncGenerator<T>::PromiseType::initial_suspend() const noexcept
+{
+    return {};
+}
+
+template <typename T>
+inline typename Crotine::AsyncGenerator<T>::PromiseType::HandBack Crotine::AsyncGenerator<T>::PromiseType::final_suspend() noexcept
+{
+    _current = nullptr;
+    return { *this };
+}
+
+template <typename T>
+inline void Crotine::AsyncGenerator<T>::PromiseType::unhandled_exception() noexcept
+{
+    _exception = std::current_exception();
+}
+
+template <typename T>
+inline void Crotine::AsyncGenerator<T>::PromiseType::return_void() noexcept
+{}
+
+template <typename T>
+inline typename Crotine::AsyncGenerator<T>::PromiseType::HandBack Crotine::AsyncGenerator<T>::PromiseType::yield_value(std::remove_reference_t<reference>& value) noexcept
+{
+    _current = std::addressof(value);
+    return { *this };
+}
+
+template <typename T>
+inline typename Crotine::AsyncGenerator<T>::PromiseType::HandBack Crotine::AsyncGenerator<T>::PromiseType::yield_value(std::remove_reference_t<reference>&& value) noexcept
+{
+    _current = std::addressof(value);
+    return { *this };
+}
+
+template <typename T>
+inline typename Crotine::AsyncGenerator<T>::PromiseType::HandBack Crotine::AsyncGenerator<T>::PromiseType::yield_value(const value_type& value)
+    requires (!std::is_reference_v<T> && !std::is_const_v<T>)
+{
+    _current = std::addressof(_copy.emplace(value));
+    return { *this };
+}
+
+#ifndef CROTINE_DISABLE_FRAME_POOL
+template <typename T>
+inline void* Crotine::AsyncGenerator<T>::PromiseType::operator new(std::size_t size)
+{
+    return FramePool::allocate(size);
+}
+
+template <typename T>
+inline void Crotine::AsyncGenerator<T>::PromiseType::operator delete(void* ptr, std::size_t size) noexcept
+{
+    FramePool::deallocate(ptr, size);
+}
+#endif
+
+template <typename T>
+inline std::coroutine_handle<> Crotine::AsyncGenerator<T>::PromiseType::resume_for(std::coroutine_handle<> consumer) noexcept
+{
+    auto& consumer_ctx = PromiseBase::execution_ctx_of(consumer);
+    if (&get_execution_ctx() == &Executor::getDefaultExecutor())
+    {
+        // like a child started by a combinator, an unplaced body runs where its consumer runs
+        set_execution_ctx(consumer_ctx);
+        set_priority(PromiseBase::priority_of(consumer));
+    }
+    if (!get_stop_token().stop_possible())
+    {
+        // so the body's sleeps and channel waits give up together with its consumer
+        set_stop_token(PromiseBase::stop_token_of(consumer));
+    }
+    _consumer = consumer;
+    auto body = Handle::from_promise(*this);
+    if (&get_execution_ctx() == &consumer_ctx)
+    {
+        return body;
+    }
+    PromiseBase::resume_on_ctx(body);
+    return std::noop_coroutine();
+}
+
+template <typename T>
+inline typename Crotine::AsyncGenerator<T>::pointer Crotine::AsyncGenerator<T>::PromiseType::take_current()
+{
+    if (_exception)
+    {
+        std::rethrow_exception(std::exchange(_exception, nullptr));
+    }
+    return _current;
+}
+
+template <typename T>
+inline Crotine::AsyncGenerator<T>::NextAwaiter::NextAwaiter(Handle handle) noexcept : _handle(handle)
+{}
+
+template <typename T>
+inline bool Crotine::AsyncGenerator<T>::NextAwaiter::await_ready() const noexcept
+{
+    return !_handle || _handle.done();
+}
+
+template <typename T>
+inline std::coroutine_handle<> Crotine::AsyncGenerator<T>::NextAwaiter::await_suspend(std::coroutine_handle<> handle) noexcept
+{
+    return _handle.promise().resume_for(handle);
+}
+
+template <typename T>
+inline typename Crotine::AsyncGenerator<T>::pointer Crotine::AsyncGenerator<T>::NextAwaiter::await_resume()
+{
+    return _handle ? _handle.promise().take_current() : nullptr;
+}
+
+template <typename T>
+inline Crotine::AsyncGenerator<T>::AsyncGenerator(Handle handle) noexcept : _handle(handle)
+{}
+
+template <typename T>
+inline Crotine::AsyncGenerator<T>::AsyncGenerator(AsyncGenerator&& other) noexcept : _handle(std::exchange(other._handle, nullptr))
+{}
+
+template <typename T>
+inline Crotine::AsyncGenerator<T>::~AsyncGenerator()
+{
+    if (_handle)
+    {
+        _handle.destroy();
+    }
+}
+
+template <typename T>
+inline Crotine::AsyncGenerator<T>& Crotine::AsyncGenerator<T>::operator=(AsyncGenerator&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (_handle)
+        {
+            _handle.destroy();
+        }
+        _handle = std::exchange(other._handle, nullptr);
+    }
+    return *this;
+}
+
+template <typename T>
+inline typename Crotine::AsyncGenerator<T>::NextAwaiter Crotine::AsyncGenerator<T>::next()
+{
+    return { _handle };
+}
+
+template <typename T>
+inline void Crotine::AsyncGenerator<T>::set_execution_ctx(Executor& ctx)
+{
+    _handle.promise().set_execution_ctx(ctx);
+}
+
+template <typename T>
+inline void Crotine::AsyncGenerator<T>::set_priority(Priority priority)
+{
+    _handle.promise().set_priority(priority);
+}
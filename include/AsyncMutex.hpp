@@ -0,0 +1,122 @@
+#pragma once
+#include <utility>
+#include <coroutine>
+
+#include "AsyncSemaphore.hpp"
+
+namespace Crotine
+{
+    // mutual exclusion for coroutines, a waiting coroutine suspends instead of blocking its thread
+    // unlock() hands the lock straight to the oldest waiter, which resumes on its own executor
+    // auto guard = co_await mutex.scoped_lock(); unlocks when guard goes out of scope
+    class AsyncMutex
+    {
+        private:
+            AsyncSemaphore _permit{1};
+        public:
+            class LockGuard
+            {
+                private:
+                    AsyncMutex* _mutex;
+                public:
+                    explicit LockGuard(AsyncMutex& mutex) noexcept;
+                    LockGuard(const LockGuard&) = delete;
+                    LockGuard(LockGuard&& other) noexcept;
+                    ~LockGuard();
+                public:
+                    LockGuard& operator=(const LockGuard&) = delete;
+                    LockGuard& operator=(LockGuard&& other) noexcept;
+                public:
+                    void unlock();
+            };
+            class ScopedLockAwaiter
+            {
+                private:
+                    AsyncMutex& _mutex;
+                    AsyncSemaphore::Awaiter _acquire;
+                public:
+                    ScopedLockAwaiter(AsyncMutex& mutex);
+                public:
+                    bool await_ready() const noexcept;
+                    bool await_suspend(std::coroutine_handle<> handle);
+                    auto await_resume() noexcept -> LockGuard;
+            };
+        public:
+            AsyncMutex() = default;
+            AsyncMutex(const AsyncMutex&) = delete;
+            ~AsyncMutex() = default;
+        public:
+            // co_await mutex.lock(), pair it with unlock()
+            auto lock() noexcept -> AsyncSemaphore::Awaiter;
+            auto scoped_lock() noexcept -> ScopedLockAwaiter;
+            bool try_lock() noexcept;
+            void unlock();
+    };
+}
+
+inline auto Crotine::AsyncMutex::lock() noexcept -> AsyncSemaphore::Awaiter
+{
+    return _permit.acquire();
+}
+
+inline auto Crotine::AsyncMutex::scoped_lock() noexcept -> ScopedLockAwaiter
+{
+    return { *this };
+}
+
+inline bool Crotine::AsyncMutex::try_lock() noexcept
+{
+    return _permit.try_acquire();
+}
+
+inline void Crotine::AsyncMutex::unlock()
+{
+    _permit.release();
+}
+
+inline Crotine::AsyncMutex::LockGuard::LockGuard(AsyncMutex& mutex) noexcept : _mutex(&mutex)
+{}
+
+inline Crotine::AsyncMutex::LockGuard::LockGuard(LockGuard&& other) noexcept : _mutex(std::exchange(other._mutex, nullptr))
+{}
+
+inline Crotine::AsyncMutex::LockGuard::~LockGuard()
+{
+    unlock();
+}
+
+inline Crotine::AsyncMutex::LockGuard& Crotine::AsyncMutex::LockGuard::operator=(LockGuard&& other) noexcept
+{
+    if (this != &other)
+    {
+        unlock();
+        _mutex = std::exchange(other._mutex, nullptr);
+    }
+    return *this;
+}
+
+inline void Crotine::AsyncMutex::LockGuard::unlock()
+{
+    if (_mutex)
+    {
+        std::exchange(_mutex, nullptr)->unlock();
+    }
+}
+
+inline Crotine::AsyncMutex::ScopedLockAwaiter::ScopedLockAwaiter(AsyncMutex& mutex) : _mutex(mutex), _acquire(mutex._permit.acquire())
+{}
+
+inline bool Crotine::AsyncMutex::ScopedLockAwaiter::await_ready() const noexcept
+{
+    return _acquire.await_ready();
+}
+
+inline bool Crotine::AsyncMutex::ScopedLockAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    return _acquire.await_suspend(handle);
+}
+
+inline Crotine::AsyncMutex::LockGuard Crotine::AsyncMutex::ScopedLockAwaiter::await_resume() noexcept
+{
+    return LockGuard(_mutex);
+}
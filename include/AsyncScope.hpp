@@ -0,0 +1,258 @@
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <coroutine>
+#include <stdexcept>
+#include <stop_token>
+#include <condition_variable>
+
+#include "Task.hpp"
+#include "Cancellation.hpp"
+#include "utils/FramePool.hpp"
+#include "utils/AsyncWaiter.hpp"
+
+namespace Crotine
+{
+    // structured replacement for detach(): every task spawned into the scope is tracked until it finished
+    //   AsyncScope scope(pool);
+    //   for (auto& connection : connections) { scope.spawn(serve(connection)); }
+    //   co_await scope.join();   // or scope.wait() from a plain thread
+    // spawned tasks run detached, their frames free themselves as they finish, the scope only counts them
+    // (one atomic counter, the bookkeeping node of a task is recycled through FramePool)
+    // children on the default executor run on the scope's executor and children without a stop token get the
+    // scope's, so request_stop() cancels everything still running
+    // join() / wait() close the scope, tasks may still spawn siblings until the last one finished
+    // the destructor waits for the spawned tasks as well, so do not let a scope die on a thread its own tasks need
+    class AsyncScope
+    {
+        private:
+            // waiter node of one spawned task, its callback runs inside the task's completion
+            template <typename T>
+            struct SpawnWaiter : TaskWaiter
+            {
+                AsyncScope* scope;
+                typename Task<T>::PromiseType* promise;
+                SpawnWaiter(AsyncScope& scope, typename Task<T>::PromiseType& promise) : scope(&scope), promise(&promise) {}
+#ifndef CROTINE_DISABLE_FRAME_POOL
+                static auto operator new(std::size_t size) -> void*;
+                static void operator delete(void* ptr, std::size_t size) noexcept;
+#endif
+            };
+        public:
+            class JoinAwaiter
+            {
+                private:
+                    AsyncScope& _scope;
+                    AsyncWaiter _waiter;
+                public:
+                    JoinAwaiter(AsyncScope& scope);
+                public:
+                    bool await_ready() const noexcept;
+                    bool await_suspend(std::coroutine_handle<> handle);
+                    // rethrows the first exception a spawned task failed with
+                    void await_resume() const;
+            };
+        private:
+            Executor& _executor;
+            // spawned tasks still running, plus one held by the scope until it is closed
+            std::atomic_size_t _count = 1;
+            std::atomic_bool _closed = false;
+            std::atomic_bool _failed = false;
+            std::exception_ptr _exception;
+            std::stop_source _stop;
+            // handed to every spawned task, kept so spawning does not create a token of its own each time
+            std::stop_token _stop_token = _stop.get_token();
+        private:
+            // only the last arrival takes the lock
+            std::mutex _mutex;
+            std::condition_variable _finished;
+            bool _done = false;
+            AsyncWaiter* _joiners = nullptr;
+        private:
+            template <typename T>
+            static void on_task_done(TaskWaiter& waiter) noexcept;
+            void fail(const std::exception_ptr& exception) noexcept;
+            void arrive();
+            void close();
+            bool add_joiner(AsyncWaiter& waiter);
+            void rethrow_if_failed() const;
+        public:
+            explicit AsyncScope(Executor& executor = Executor::getDefaultExecutor());
+            AsyncScope(const AsyncScope&) = delete;
+            ~AsyncScope();
+        public:
+            // starts task (which must not be started yet) and takes it over, throws std::logic_error once the scope finished
+            template <typename T>
+            void spawn(Task<T> task);
+            // resumes after every spawned task finished
+            auto join() -> JoinAwaiter;
+            // blocking join for code outside of coroutines
+            void wait();
+            void request_stop() noexcept;
+            auto get_stop_token() const noexcept -> std::stop_token;
+            // spawned tasks that have not finished yet
+            auto pending() const noexcept -> std::size_t;
+    };
+}
+
+#ifndef CROTINE_DISABLE_FRAME_POOL
+template <typename T>
+inline void* Crotine::AsyncScope::SpawnWaiter<T>::operator new(std::size_t size)
+{
+    return FramePool::allocate(size);
+}
+
+template <typename T>
+inline void Crotine::AsyncScope::SpawnWaiter<T>::operator delete(void* ptr, std::size_t size) noexcept
+{
+    FramePool::deallocate(ptr, size);
+}
+#endif
+
+inline Crotine::AsyncScope::AsyncScope(Executor& executor) : _executor(executor)
+{}
+
+inline Crotine::AsyncScope::~AsyncScope()
+{
+    close();
+    std::unique_lock<std::mutex> lock(_mutex);
+    _finished.wait(lock, [this]() { return _done; });
+}
+
+template <typename T>
+inline void Crotine::AsyncScope::on_task_done(TaskWaiter& waiter) noexcept
+{
+    // runs before the task publishes its result, the task's frame frees itself right after
+    auto* node = static_cast<SpawnWaiter<T>*>(&waiter);
+    auto* scope = node->scope;
+    if (auto& exception = node->promise->getException(); exception)
+    {
+        scope->fail(exception);
+    }
+    delete node;
+    scope->arrive();
+}
+
+inline void Crotine::AsyncScope::fail(const std::exception_ptr& exception) noexcept
+{
+    if (!_failed.exchange(true, std::memory_order_acq_rel))
+    {
+        _exception = exception;
+    }
+}
+
+inline void Crotine::AsyncScope::arrive()
+{
+    if (_count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+        return;
+    }
+    AsyncWaiter* joiners = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _done = true;
+        joiners = std::exchange(_joiners, nullptr);
+        // notified under the mutex, a blocked wait() may destroy the scope as soon as it gets the lock
+        _finished.notify_all();
+    }
+    resume_waiters(joiners);
+}
+
+inline void Crotine::AsyncScope::close()
+{
+    if (!_closed.exchange(true, std::memory_order_acq_rel))
+    {
+        arrive();
+    }
+}
+
+inline bool Crotine::AsyncScope::add_joiner(AsyncWaiter& waiter)
+{
+    close();
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_done)
+    {
+        return false;
+    }
+    waiter.next = _joiners;
+    _joiners = &waiter;
+    return true;
+}
+
+inline void Crotine::AsyncScope::rethrow_if_failed() const
+{
+    if (_failed.load(std::memory_order_acquire))
+    {
+        std::rethrow_exception(_exception);
+    }
+}
+
+template <typename T>
+inline void Crotine::AsyncScope::spawn(Task<T> task)
+{
+    if (_count.fetch_add(1, std::memory_order_relaxed) == 0)
+    {
+        _count.fetch_sub(1, std::memory_order_relaxed);
+        throw std::logic_error("AsyncScope already finished");
+    }
+    auto& promise = task.getPromise();
+    promise.inherit(_executor, Priority::Normal, _stop_token);
+    auto* node = new SpawnWaiter<T>(*this, promise);
+    node->callback = &on_task_done<T>;
+    // the task has not run yet, registering can not fail
+    promise.addWaiter(*node);
+    task.execute_detached();
+}
+
+inline Crotine::AsyncScope::JoinAwaiter Crotine::AsyncScope::join()
+{
+    return { *this };
+}
+
+inline void Crotine::AsyncScope::wait()
+{
+    close();
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _finished.wait(lock, [this]() { return _done; });
+    }
+    rethrow_if_failed();
+}
+
+inline void Crotine::AsyncScope::request_stop() noexcept
+{
+    _stop.request_stop();
+}
+
+inline std::stop_token Crotine::AsyncScope::get_stop_token() const noexcept
+{
+    return _stop_token;
+}
+
+inline std::size_t Crotine::AsyncScope::pending() const noexcept
+{
+    auto count = _count.load(std::memory_order_acquire);
+    return _closed.load(std::memory_order_acquire) ? count : count - 1;
+}
+
+inline Crotine::AsyncScope::JoinAwaiter::JoinAwaiter(AsyncScope& scope) : _scope(scope)
+{}
+
+inline bool Crotine::AsyncScope::JoinAwaiter::await_ready() const noexcept
+{
+    return false;
+}
+
+inline bool Crotine::AsyncScope::JoinAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    // once registered the last task may resume us right away, only locals from here on
+    _waiter.handle = handle;
+    return _scope.add_joiner(_waiter);
+}
+
+inline void Crotine::AsyncScope::JoinAwaiter::await_resume() const
+{
+    _scope.rethrow_if_failed();
+}
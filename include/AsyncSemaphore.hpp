@@ -0,0 +1,176 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <coroutine>
+
+#include "utils/AsyncWaiter.hpp"
+
+namespace Crotine
+{
+    // counting semaphore for coroutines, e.g. to cap how many tasks hit a backend at once
+    // acquiring a free permit is a single atomic decrement; without one the coroutine suspends
+    // and a later release() hands its permit straight to the oldest waiter, resumed on its own executor
+    class AsyncSemaphore
+    {
+        private:
+            // free permits, negative while coroutines are committed to wait
+            std::atomic<std::ptrdiff_t> _permits;
+            // permits released to waiters that were not handed out yet
+            std::atomic<std::ptrdiff_t> _owed = 0;
+            // lock-free stack new waiters push onto
+            std::atomic<void*> _incoming = nullptr;
+            // waiters in arrival order, only touched by the thread holding _dispatching
+            std::atomic<AsyncWaiter*> _ready = nullptr;
+            std::atomic_bool _dispatching = false;
+        private:
+            // dispatch() and the waiter's own await_suspend race to let go of it, the second one resumes the coroutine
+            // until then the coroutine stays suspended and the semaphore alive for its await_suspend
+            struct Waiter : AsyncWaiter
+            {
+                std::atomic_bool handed = false;
+            };
+        private:
+            void dispatch();
+            auto next_waiter() noexcept -> AsyncWaiter*;
+        public:
+            class Awaiter
+            {
+                private:
+                    AsyncSemaphore& _semaphore;
+                    Waiter _waiter;
+                public:
+                    Awaiter(AsyncSemaphore& semaphore);
+                public:
+                    bool await_ready() const noexcept;
+                    bool await_suspend(std::coroutine_handle<> handle);
+                    void await_resume() const noexcept;
+            };
+        public:
+            explicit AsyncSemaphore(std::ptrdiff_t permits);
+            AsyncSemaphore(const AsyncSemaphore&) = delete;
+            ~AsyncSemaphore() = default;
+        public:
+            // co_await semaphore.acquire()
+            auto acquire() noexcept -> Awaiter;
+            bool try_acquire() noexcept;
+            void release(std::ptrdiff_t count = 1);
+            auto available() const noexcept -> std::ptrdiff_t;
+    };
+}
+
+inline Crotine::AsyncSemaphore::AsyncSemaphore(std::ptrdiff_t permits) : _permits(permits)
+{}
+
+inline auto Crotine::AsyncSemaphore::acquire() noexcept -> Awaiter
+{
+    return { *this };
+}
+
+inline bool Crotine::AsyncSemaphore::try_acquire() noexcept
+{
+    auto permits = _permits.load(std::memory_order_relaxed);
+    while (permits > 0)
+    {
+        if (_permits.compare_exchange_weak(permits, permits - 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void Crotine::AsyncSemaphore::release(std::ptrdiff_t count)
+{
+    auto previous = _permits.fetch_add(count, std::memory_order_acq_rel);
+    if (previous < 0)
+    {
+        // -previous coroutines are waiting (or about to), they get first pick
+        _owed.fetch_add(previous + count < 0 ? count : -previous);
+        dispatch();
+    }
+}
+
+inline std::ptrdiff_t Crotine::AsyncSemaphore::available() const noexcept
+{
+    auto permits = _permits.load(std::memory_order_relaxed);
+    return permits < 0 ? 0 : permits;
+}
+
+inline Crotine::AsyncWaiter* Crotine::AsyncSemaphore::next_waiter() noexcept
+{
+    auto* waiter = _ready.load(std::memory_order_relaxed);
+    if (!waiter)
+    {
+        waiter = reverse_waiters(static_cast<AsyncWaiter*>(_incoming.exchange(nullptr)));
+    }
+    if (waiter)
+    {
+        _ready.store(waiter->next, std::memory_order_relaxed);
+    }
+    return waiter;
+}
+
+inline void Crotine::AsyncSemaphore::dispatch()
+{
+    // one thread at a time pairs owed permits with waiters, everybody else leaves the work to it
+    // a waiter may still be between its decrement and its push, it calls dispatch() itself once pushed
+    AsyncWaiter* woken = nullptr;
+    auto** tail = &woken;
+    while (!_dispatching.exchange(true))
+    {
+        while (_owed.load() > 0)
+        {
+            auto* waiter = next_waiter();
+            if (!waiter)
+            {
+                break;
+            }
+            _owed.fetch_sub(1);
+            *tail = waiter;
+            tail = &waiter->next;
+        }
+        _dispatching.store(false);
+        // a permit or a waiter may have shown up after we looked, without anybody else getting the flag
+        if (_owed.load() == 0 || (_ready.load() == nullptr && _incoming.load() == nullptr))
+        {
+            break;
+        }
+    }
+    *tail = nullptr;
+    // a resumed coroutine may be the last user and destroy us, only the waiter nodes are touched from here
+    while (woken)
+    {
+        auto* next = woken->next;
+        if (static_cast<Waiter*>(woken)->handed.exchange(true))
+        {
+            PromiseBase::resume_on_ctx(woken->handle);
+        }
+        woken = next;
+    }
+}
+
+inline Crotine::AsyncSemaphore::Awaiter::Awaiter(AsyncSemaphore& semaphore) : _semaphore(semaphore)
+{}
+
+inline bool Crotine::AsyncSemaphore::Awaiter::await_ready() const noexcept
+{
+    return _semaphore.try_acquire();
+}
+
+inline bool Crotine::AsyncSemaphore::Awaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    auto& semaphore = _semaphore;
+    if (semaphore._permits.fetch_sub(1, std::memory_order_acq_rel) > 0)
+    {
+        return false;
+    }
+    // committed to wait, the permit arrives through dispatch()
+    _waiter.handle = handle;
+    push_waiter(semaphore._incoming, _waiter);
+    semaphore.dispatch();
+    // a dispatch() that already handed us the permit left resuming to us, carry on without suspending
+    return !_waiter.handed.exchange(true);
+}
+
+inline void Crotine::AsyncSemaphore::Awaiter::await_resume() const noexcept
+{}
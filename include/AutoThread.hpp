@@ -1,46 +1,103 @@
 #pragma once
+#include <mutex>
 #include <thread>
 #include <memory>
 #include <chrono>
-#include <functional>
-#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <optional>
+#include <algorithm>
 
+#include "Executor.hpp"
 #include "WaitGroup.hpp"
 #include "BlockChannel.hpp"
+#include "utils/Parker.hpp"
+#include "utils/Metrics.hpp"
 
 namespace Crotine
 {
+    // idle side of a pool's workers: a worker without work spins, then yields, then sleeps on its own Parker
+    // producers wake exactly one sleeper, and only while no worker is spinning that would pick the job up anyway
+    // a spinner that finds work wakes the next sleeper if it was the last one looking, so bursts fan out
+    class IdleWorkers
+    {
+        private:
+            static constexpr unsigned int SpinCount = 64;
+            static constexpr unsigned int YieldCount = 4;
+        private:
+            // busy spinning only pays off when the producer runs on another core
+            unsigned int _spin_count = std::thread::hardware_concurrency() > 1 ? SpinCount : 0;
+            std::unique_ptr<Parker[]> _parkers;
+            std::mutex _mutex;
+            // sleeping worker indices, the most recently parked (warmest cache) is woken first
+            std::vector<std::size_t> _parked;
+            std::atomic_uint _parked_count = 0;
+            std::atomic_uint _spinning = 0;
+            std::atomic_bool _closed = false;
+        private:
+            static void cpu_relax() noexcept;
+            bool unregister(std::size_t index);
+            // unregister for a worker about to expire, it stops counting as idle under the same lock
+            bool retire(std::size_t index, std::atomic_uint& idle_threads);
+        public:
+            explicit IdleWorkers(std::size_t workers);
+            IdleWorkers(const IdleWorkers&) = delete;
+            ~IdleWorkers() = default;
+        public:
+            // called after jobs became visible in the channel, wakes sleepers for those the spinners do not cover
+            void notify(std::size_t jobs = 1);
+            void wake_one();
+            // wakes every sleeper, wait() returns nothing from now on once the worker is idle
+            void close();
+            bool isClosed() const noexcept;
+            // next job for worker index, nullopt once closed or when a non persistent worker timed out
+            // the worker is no longer counted in idle_threads once nullopt is returned
+            template<typename Channel>
+            auto wait(Channel& tasks, std::size_t index, std::atomic_uint& idle_threads, bool persistent, std::chrono::milliseconds timeout) -> std::optional<QueuedJob>;
+    };
+
+    template<typename Channel = BlockChannel<QueuedJob>>
     class AutoThread
     {
         public:
             struct thread_context
             {
-                BlockChannel<std::function<void()>>& tasks;
+                Channel& tasks;
+                Executor& owner;
+                std::size_t worker_index;
+                // workers not currently running a task, maintained here so tasks need no wrapping
+                std::atomic_uint& idle_threads;
+                IdleWorkers& idle;
+                ExecutorMetrics& metrics;
+                // persistent workers never expire, the others exit after timeout without work
+                bool persistent;
                 std::chrono::milliseconds timeout;
-                std::function<void()> expire_callback;
+                Job expire_callback;
                 public:
-                    thread_context(BlockChannel<std::function<void()>>& task_channel , std::chrono::milliseconds timeout , std::function<void()> expire_callback)
-                        : tasks(task_channel) , timeout(timeout) , expire_callback(expire_callback) {}
+                    thread_context(Channel& task_channel , Executor& owner , std::size_t worker_index , std::atomic_uint& idle_threads , IdleWorkers& idle , ExecutorMetrics& metrics , bool persistent , std::chrono::milliseconds timeout , Job expire_callback)
+                        : tasks(task_channel) , owner(owner) , worker_index(worker_index) , idle_threads(idle_threads) , idle(idle) , metrics(metrics) , persistent(persistent) , timeout(timeout) , expire_callback(std::move(expire_callback)) {}
             };
         public:
             AutoThread(thread_context context);
             ~AutoThread() = default;
     };
 
-    AutoThread::AutoThread(thread_context context)
+    template<typename Channel>
+    AutoThread<Channel>::AutoThread(thread_context context)
     {
-        std::thread([context]() mutable
+        std::thread([context = std::move(context)]() mutable
         {
-            while(true)
+            Executor::ThreadBinding binding(context.owner , context.worker_index);
+            ExecutorMetrics::Binding metrics_binding(context.metrics , context.worker_index);
+            while(auto task = context.idle.wait(context.tasks , context.worker_index , context.idle_threads , context.persistent , context.timeout))
             {
-                if(auto task = context.tasks.try_take_for(context.timeout); task)
-                {
-                    (*task)();
-                    // going out of scope will destroy the task
-                    // task destruction is necessary for some tasks
-                }
-                else
-                    break;
+                context.idle_threads.fetch_sub(1);
+                auto started = ExecutorMetrics::job_started(*task);
+                (*task)();
+                ExecutorMetrics::job_finished(started);
+                context.idle_threads.fetch_add(1);
+                // going out of scope will destroy the task
+                // task destruction is necessary for some tasks
             }
             if(context.expire_callback)
             {
@@ -48,4 +105,183 @@ namespace Crotine
             }
         }).detach();
     }
-}
\ No newline at end of file
+}
+
+inline Crotine::IdleWorkers::IdleWorkers(std::size_t workers) : _parkers(std::make_unique<Parker[]>(workers))
+{
+    _parked.reserve(workers);
+}
+
+inline void Crotine::IdleWorkers::cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+inline bool Crotine::IdleWorkers::unregister(std::size_t index)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto found = std::find(_parked.begin(), _parked.end(), index);
+    if(found == _parked.end())
+    {
+        return false;
+    }
+    _parked.erase(found);
+    _parked_count.fetch_sub(1);
+    return true;
+}
+
+inline bool Crotine::IdleWorkers::retire(std::size_t index, std::atomic_uint& idle_threads)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto found = std::find(_parked.begin(), _parked.end(), index);
+    if(found == _parked.end())
+    {
+        return false;
+    }
+    _parked.erase(found);
+    _parked_count.fetch_sub(1);
+    idle_threads.fetch_sub(1);
+    return true;
+}
+
+inline void Crotine::IdleWorkers::notify(std::size_t jobs)
+{
+    // pairs with the fence in wait(), either we see the sleeper or it sees the job
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto spinning = _spinning.load();
+    if(jobs <= spinning || _parked_count.load() == 0)
+    {
+        return;
+    }
+    if(jobs - spinning == 1)
+    {
+        wake_one();
+        return;
+    }
+    std::vector<std::size_t> woken;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto count = std::min(jobs - spinning, _parked.size());
+        woken.assign(_parked.end() - count, _parked.end());
+        _parked.resize(_parked.size() - count);
+        _parked_count.fetch_sub(static_cast<unsigned int>(count));
+    }
+    for(auto index : woken)
+    {
+        _parkers[index].unpark();
+    }
+}
+
+inline void Crotine::IdleWorkers::wake_one()
+{
+    std::size_t index;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_parked.empty())
+        {
+            return;
+        }
+        index = _parked.back();
+        _parked.pop_back();
+        _parked_count.fetch_sub(1);
+    }
+    _parkers[index].unpark();
+}
+
+inline bool Crotine::IdleWorkers::isClosed() const noexcept
+{
+    return _closed.load();
+}
+
+inline void Crotine::IdleWorkers::close()
+{
+    std::vector<std::size_t> parked;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closed.store(true);
+        parked.swap(_parked);
+        _parked_count.store(0);
+    }
+    for(auto index : parked)
+    {
+        _parkers[index].unpark();
+    }
+}
+
+template<typename Channel>
+inline auto Crotine::IdleWorkers::wait(Channel& tasks, std::size_t index, std::atomic_uint& idle_threads, bool persistent, std::chrono::milliseconds timeout) -> std::optional<QueuedJob>
+{
+    auto& parker = _parkers[index];
+    while(!_closed.load())
+    {
+        // short busy phase, a job arriving now starts without any syscall on either side
+        _spinning.fetch_add(1);
+        for(unsigned int i = 0; i < _spin_count + YieldCount; ++i)
+        {
+            if(auto task = tasks.try_take(); task)
+            {
+                if(_spinning.fetch_sub(1) == 1)
+                {
+                    notify();
+                }
+                return task;
+            }
+            if(i < _spin_count)
+            {
+                cpu_relax();
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        _spinning.fetch_sub(1);
+
+        parker.prepare();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if(_closed.load())
+            {
+                break;
+            }
+            _parked.push_back(index);
+            _parked_count.fetch_add(1);
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(auto task = tasks.try_take(); task)
+        {
+            // a producer that already picked us meant its wake-up for a job, hand it to the next sleeper
+            if(!unregister(index))
+            {
+                wake_one();
+            }
+            return task;
+        }
+        ExecutorMetrics::parked();
+        auto woken = persistent ? parker.park() : parker.park_for(timeout);
+        if(!woken)
+        {
+            // not listed anymore means a producer picked us in the meantime, its job is ours
+            if(!retire(index, idle_threads))
+            {
+                continue;
+            }
+            // a producer that still counted us idle has put its job by now, one that did not starts its own thread
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(auto task = tasks.try_take(); task)
+            {
+                idle_threads.fetch_add(1);
+                return task;
+            }
+            return std::nullopt;
+        }
+        // a wake-up meant for an earlier round can end this one early, so we may still be listed
+        unregister(index);
+    }
+    idle_threads.fetch_sub(1);
+    return std::nullopt;
+}
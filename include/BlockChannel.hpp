@@ -1,5 +1,9 @@
+#pragma once
 #include <queue>
+#include <span>
 #include <mutex>
+#include <chrono>
+#include <optional>
 #include <condition_variable>
 
 namespace Crotine
@@ -9,51 +13,91 @@ namespace Crotine
     {
         private:
             bool _closed = false;
+            // threads blocked in take / try_take_for, pool workers only use try_take and never count here
+            std::size_t _waiting = 0;
         private:
            std::queue<T> _queue;
            std::mutex _mutex;
            std::condition_variable _notifier;
+        private:
+            // called with the lock held, nobody can see the item and destroy the channel before the signal is out
+            void wake(std::size_t count)
+            {
+                if(_waiting == 0)
+                {
+                    return;
+                }
+                if(count > 1)
+                    _notifier.notify_all();
+                else
+                    _notifier.notify_one();
+            }
+            template<typename Wait>
+            std::optional<T> wait_for_item(std::unique_lock<std::mutex>& lock, Wait&& wait)
+            {
+                ++_waiting;
+                bool ready = wait(lock, [this] { return !_queue.empty() or _closed; });
+                --_waiting;
+                if(ready && !_closed)
+                {
+                    auto item = std::move(_queue.front());
+                    _queue.pop();
+                    return item;
+                }
+                return std::nullopt;
+            }
         public:
             BlockChannel() = default;
             ~BlockChannel() = default;
         public:
             void put(const T& item)
             {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _queue.push(item);
+                wake(1);
+            }
+            void put(T&& item)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _queue.push(std::move(item));
+                wake(1);
+            }
+            // moves every item in under one lock
+            void put_batch(std::span<T> items)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                for(auto& item : items)
                 {
-                    std::lock_guard<std::mutex> lock(_mutex);
-                    _queue.push(item);
+                    _queue.push(std::move(item));
                 }
-                _notifier.notify_one();
+                wake(items.size());
             }
             std::optional<T> take()
             {
                 std::unique_lock<std::mutex> _lock(_mutex);
-                _notifier.wait(_lock, [this] { return !_queue.empty() or _closed; });
-                if(!_closed)
+                return wait_for_item(_lock, [this](auto& lock, auto predicate) { _notifier.wait(lock, predicate); return true; });
+            }
+            // never blocks on an empty queue, pool workers do their own waiting
+            std::optional<T> try_take()
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if(_queue.empty())
                 {
-                    auto item = std::move(_queue.front());
-                    _queue.pop();
-                    return item;
+                    return std::nullopt;
                 }
-                return std::nullopt;
+                auto item = std::move(_queue.front());
+                _queue.pop();
+                return item;
             }
             std::optional<T> try_take_for(const std::chrono::milliseconds& timeout)
             {
                 std::unique_lock<std::mutex> _lock(_mutex);
-                if(_notifier.wait_for(_lock, timeout, [this] { return !_queue.empty() or _closed; }) && !_closed)
-                {
-                    auto item = std::move(_queue.front());
-                    _queue.pop();
-                    return item;
-                }
-                return std::nullopt;
+                return wait_for_item(_lock, [this, timeout](auto& lock, auto predicate) { return _notifier.wait_for(lock, timeout, predicate); });
             }
             void close()
             {
-                {
-                    std::lock_guard<std::mutex> lock(_mutex);
-                    _closed = true;
-                }
+                std::lock_guard<std::mutex> lock(_mutex);
+                _closed = true;
                 _notifier.notify_all();
             }
     };
@@ -0,0 +1,124 @@
+#pragma once
+#include <optional>
+#include <utility>
+#include <coroutine>
+#include <stdexcept>
+#include <stop_token>
+
+#include "PromiseBase.hpp"
+
+namespace Crotine
+{
+    // cooperative cancellation, built on std::stop_token:
+    //   task.set_stop_token(source.get_token()) before starting it, children started or awaited from it inherit the token
+    //   sleeps, channel operations and io give up early once a stop is requested and throw OperationCancelled
+    //   (io reports -ECANCELED instead), everything else keeps running until it checks
+    //   co_await Crotine::throw_if_cancelled{} is the explicit check, a single load when nobody can stop the coroutine
+    class OperationCancelled : public std::runtime_error
+    {
+        public:
+            OperationCancelled() : std::runtime_error("Operation cancelled") {}
+    };
+
+    // stop source whose stops also follow the ones of a parent token, used where a combinator cancels its children
+    // on its own (when_any losers, a timed out task) and must still pass on the parent's cancellation
+    class LinkedStopSource
+    {
+        private:
+            struct Forward
+            {
+                std::stop_source source;
+                void operator()() const noexcept
+                {
+                    source.request_stop();
+                }
+            };
+        private:
+            std::stop_source _source;
+            std::optional<std::stop_callback<Forward>> _link;
+        public:
+            LinkedStopSource() = default;
+            LinkedStopSource(const LinkedStopSource&) = delete;
+        public:
+            // a stop requested on parent, now or later, is forwarded to this source
+            void link(const std::stop_token& parent);
+            bool request_stop() noexcept;
+            auto get_token() const noexcept -> std::stop_token;
+    };
+
+    // reads the stop token of the awaiting coroutine without suspending, like get_Execution_Context
+    class get_stop_token
+    {
+        private:
+            const std::stop_token* _token = nullptr;
+        public:
+            bool await_ready() const noexcept;
+            bool await_suspend(std::coroutine_handle<> handle) noexcept;
+            // the token stays valid for as long as the coroutine runs
+            auto await_resume() const noexcept -> const std::stop_token&;
+    };
+
+    // throws OperationCancelled if a stop was requested for the awaiting coroutine, otherwise just continues
+    class throw_if_cancelled
+    {
+        private:
+            bool _cancelled = false;
+        public:
+            bool await_ready() const noexcept;
+            bool await_suspend(std::coroutine_handle<> handle) noexcept;
+            void await_resume() const;
+    };
+}
+
+inline void Crotine::LinkedStopSource::link(const std::stop_token& parent)
+{
+    if (parent.stop_possible())
+    {
+        _link.emplace(parent, Forward{ _source });
+    }
+}
+
+inline bool Crotine::LinkedStopSource::request_stop() noexcept
+{
+    return _source.request_stop();
+}
+
+inline std::stop_token Crotine::LinkedStopSource::get_token() const noexcept
+{
+    return _source.get_token();
+}
+
+inline bool Crotine::get_stop_token::await_ready() const noexcept
+{
+    return false;
+}
+
+inline bool Crotine::get_stop_token::await_suspend(std::coroutine_handle<> handle) noexcept
+{
+    _token = &PromiseBase::stop_token_of(handle);
+    return false;
+}
+
+inline const std::stop_token& Crotine::get_stop_token::await_resume() const noexcept
+{
+    return *_token;
+}
+
+inline bool Crotine::throw_if_cancelled::await_ready() const noexcept
+{
+    return false;
+}
+
+inline bool Crotine::throw_if_cancelled::await_suspend(std::coroutine_handle<> handle) noexcept
+{
+    _cancelled = PromiseBase::stop_token_of(handle).stop_requested();
+    return false;
+}
+
+inline void Crotine::throw_if_cancelled::await_resume() const
+{
+    if (_cancelled)
+    {
+        throw OperationCancelled();
+    }
+}
@@ -0,0 +1,506 @@
+#pragma once
+#include <array>
+#include <tuple>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <variant>
+#include <coroutine>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Task.hpp"
+#include "Cancellation.hpp"
+
+namespace Crotine
+{
+    // what awaiting a Task<T> through a combinator yields, void children report std::monostate
+    // and Task<T&> children a std::reference_wrapper
+    template <typename T>
+    using TaskValue = std::conditional_t<std::is_void_v<T>, std::monostate,
+        std::conditional_t<std::is_reference_v<T>, std::reference_wrapper<std::remove_reference_t<T>>, T>>;
+
+    // moves the result out of a finished child, the combinator owns the child and is its only reader
+    template <typename T>
+    auto take_value(Task<T>& task) -> TaskValue<T>;
+
+    // waiter node of one child, all of them live in the aggregate state of the combinator
+    struct ChildWaiter : TaskWaiter
+    {
+        void* state = nullptr;
+        std::size_t index = 0;
+    };
+
+    // starts the children of a combinator on behalf of the parent coroutine
+    // children still on the default executor inherit the parent's context, children at Normal priority its priority,
+    // children without a stop token the parent's one (or the token the combinator hands out instead),
+    // the first child sharing the parent's context is run inline by symmetric transfer, the others are posted
+    class ChildLauncher
+    {
+        private:
+            Executor& _parent_ctx;
+            Priority _parent_priority;
+            std::stop_token _stop_token;
+            std::coroutine_handle<> _inline_child = nullptr;
+        public:
+            ChildLauncher(std::coroutine_handle<> parent);
+            ChildLauncher(std::coroutine_handle<> parent, std::stop_token stop_token);
+        public:
+            template <typename T>
+            void adopt(Task<T>& task);
+            template <typename T>
+            void launch(Task<T>& task);
+            // same as launch() for each task, children sharing the parent's context and priority go out in one execute_batch
+            template <typename T>
+            void launch_all(std::vector<Task<T>>& tasks);
+            auto inlineChild() const noexcept -> std::coroutine_handle<>;
+    };
+
+    // co_await Crotine::when_all(tasks...) starts the tasks and resumes once, after the last one finished
+    // the awaiter itself is the aggregate state, no allocation beyond the children's frames
+    template <typename... Ts>
+    class WhenAllAwaiter
+    {
+        private:
+            std::tuple<Task<Ts>...> _tasks;
+            std::array<ChildWaiter, sizeof...(Ts)> _waiters;
+            // one count per child plus one held by await_suspend until every child has been launched
+            std::atomic_size_t _remaining = sizeof...(Ts) + 1;
+            std::coroutine_handle<> _parent = nullptr;
+        private:
+            static auto on_child_done(TaskWaiter& waiter) noexcept -> std::coroutine_handle<>;
+        public:
+            WhenAllAwaiter(Task<Ts>... tasks);
+            WhenAllAwaiter(const WhenAllAwaiter&) = delete;
+        public:
+            bool await_ready() const noexcept;
+            auto await_suspend(std::coroutine_handle<> handle) -> std::coroutine_handle<>;
+            // rethrows the exception of the first failed child in argument order
+            auto await_resume() -> std::tuple<TaskValue<Ts>...>;
+    };
+
+    template <typename T>
+    class WhenAllRangeAwaiter
+    {
+        private:
+            std::vector<Task<T>> _tasks;
+            std::vector<ChildWaiter> _waiters;
+            std::atomic_size_t _remaining;
+            std::coroutine_handle<> _parent = nullptr;
+        private:
+            static auto on_child_done(TaskWaiter& waiter) noexcept -> std::coroutine_handle<>;
+        public:
+            WhenAllRangeAwaiter(std::vector<Task<T>> tasks);
+            WhenAllRangeAwaiter(const WhenAllRangeAwaiter&) = delete;
+        public:
+            bool await_ready() const noexcept;
+            auto await_suspend(std::coroutine_handle<> handle) -> std::coroutine_handle<>;
+            auto await_resume() -> std::vector<TaskValue<T>>;
+    };
+
+    // co_await Crotine::when_any(...) resumes as soon as the first task finished and yields its index and result
+    // the losers get a stop request and keep running in the background until they notice it, they own the shared
+    // state together with the parent and the last one to let go of it frees every child frame at once
+    template <typename T>
+    struct WhenAnySlot
+    {
+        Task<T> task;
+        ChildWaiter waiter;
+        WhenAnySlot(Task<T> task) : task(std::move(task)) {}
+    };
+
+    template <typename T, typename Slots>
+    class WhenAnyState
+    {
+        public:
+            Slots slots;
+            std::atomic_size_t references = 1;
+            std::atomic_bool decided = false;
+            // the winner and await_suspend both have to arrive before the parent may run
+            std::atomic_uint gate = 2;
+            std::size_t winner = 0;
+            std::coroutine_handle<> parent = nullptr;
+            // the children's stop token, stopped once a winner is decided or when the parent is cancelled
+            LinkedStopSource stop;
+        public:
+            WhenAnyState() = default;
+            explicit WhenAnyState(Slots slots);
+            WhenAnyState(const WhenAnyState&) = delete;
+        public:
+            void release() noexcept;
+    };
+
+    template <typename T, typename Slots>
+    class WhenAnyAwaiter
+    {
+        private:
+            using State = WhenAnyState<T, Slots>;
+        private:
+            State* _state;
+        private:
+            static auto on_child_done(TaskWaiter& waiter) noexcept -> std::coroutine_handle<>;
+        public:
+            WhenAnyAwaiter(State* state);
+            WhenAnyAwaiter(const WhenAnyAwaiter&) = delete;
+            ~WhenAnyAwaiter();
+        public:
+            bool await_ready() const noexcept;
+            auto await_suspend(std::coroutine_handle<> handle) -> std::coroutine_handle<>;
+            auto await_resume() -> std::pair<std::size_t, TaskValue<T>>;
+    };
+
+    // every task handed to a combinator must not be started yet, the combinator starts it
+    template <typename... Ts>
+    auto when_all(Task<Ts>... tasks) -> WhenAllAwaiter<Ts...>;
+    template <typename T>
+    auto when_all(std::vector<Task<T>> tasks) -> WhenAllRangeAwaiter<T>;
+    template <typename T, typename... Rest>
+    requires (std::is_same_v<T, Rest> && ...)
+    auto when_any(Task<T> first, Task<Rest>... rest) -> WhenAnyAwaiter<T, std::array<WhenAnySlot<T>, sizeof...(Rest) + 1>>;
+    template <typename T>
+    auto when_any(std::vector<Task<T>> tasks) -> WhenAnyAwaiter<T, std::vector<WhenAnySlot<T>>>;
+}
+
+template <typename T>
+inline Crotine::TaskValue<T> Crotine::take_value(Task<T>& task)
+{
+    if constexpr (std::is_void_v<T>)
+    {
+        task.getPromise().getWaitedValue();
+        return std::monostate{};
+    }
+    else if constexpr (std::is_reference_v<T>)
+    {
+        return std::ref(task.getPromise().getWaitedValue());
+    }
+    else
+    {
+        return std::move(task.getPromise().getWaitedValue());
+    }
+}
+
+inline Crotine::ChildLauncher::ChildLauncher(std::coroutine_handle<> parent)
+    : ChildLauncher(parent, PromiseBase::stop_token_of(parent))
+{}
+
+inline Crotine::ChildLauncher::ChildLauncher(std::coroutine_handle<> parent, std::stop_token stop_token)
+    : _parent_ctx(PromiseBase::execution_ctx_of(parent)), _parent_priority(PromiseBase::priority_of(parent)), _stop_token(std::move(stop_token))
+{}
+
+template <typename T>
+inline void Crotine::ChildLauncher::adopt(Task<T>& task)
+{
+    task.getPromise().inherit(_parent_ctx, _parent_priority, _stop_token);
+}
+
+template <typename T>
+inline void Crotine::ChildLauncher::launch(Task<T>& task)
+{
+    auto& promise = task.getPromise();
+    // only a child in the parent's context and lane may take over the parent's thread, like in launch_all
+    if (!_inline_child && &promise.get_execution_ctx() == &_parent_ctx && promise.get_priority() == _parent_priority)
+    {
+        if (promise.try_start())
+        {
+            _inline_child = std::coroutine_handle<typename Task<T>::PromiseType>::from_promise(promise);
+        }
+        return;
+    }
+    task.execute_async();
+}
+
+template <typename T>
+inline void Crotine::ChildLauncher::launch_all(std::vector<Task<T>>& tasks)
+{
+    std::vector<Job> batch;
+    batch.reserve(tasks.size());
+    for (auto& task : tasks)
+    {
+        auto& promise = task.getPromise();
+        if (&promise.get_execution_ctx() != &_parent_ctx || promise.get_priority() != _parent_priority)
+        {
+            task.execute_async();
+        }
+        else if (!_inline_child)
+        {
+            if (promise.try_start())
+            {
+                _inline_child = std::coroutine_handle<typename Task<T>::PromiseType>::from_promise(promise);
+            }
+        }
+        else
+        {
+            batch.push_back(task.start_job());
+        }
+    }
+    if (!batch.empty())
+    {
+        _parent_ctx.execute_batch(batch, _parent_priority);
+    }
+}
+
+inline std::coroutine_handle<> Crotine::ChildLauncher::inlineChild() const noexcept
+{
+    return _inline_child;
+}
+
+template <typename... Ts>
+inline Crotine::WhenAllAwaiter<Ts...>::WhenAllAwaiter(Task<Ts>... tasks) : _tasks(std::move(tasks)...)
+{}
+
+template <typename... Ts>
+inline std::coroutine_handle<> Crotine::WhenAllAwaiter<Ts...>::on_child_done(TaskWaiter& waiter) noexcept
+{
+    auto* self = static_cast<WhenAllAwaiter*>(static_cast<ChildWaiter&>(waiter).state);
+    if (self->_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        return self->_parent;
+    }
+    return nullptr;
+}
+
+template <typename... Ts>
+inline bool Crotine::WhenAllAwaiter<Ts...>::await_ready() const noexcept
+{
+    return sizeof...(Ts) == 0;
+}
+
+template <typename... Ts>
+inline std::coroutine_handle<> Crotine::WhenAllAwaiter<Ts...>::await_suspend(std::coroutine_handle<> handle)
+{
+    _parent = handle;
+    ChildLauncher launcher(handle);
+    std::size_t index = 0;
+    std::apply([&](auto&... tasks)
+    {
+        (([&](auto& task)
+        {
+            auto& waiter = _waiters[index++];
+            waiter.state = this;
+            waiter.notify = &on_child_done;
+            launcher.adopt(task);
+            if (!task.getPromise().addWaiter(waiter))
+            {
+                _remaining.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }(tasks)), ...);
+        (launcher.launch(tasks), ...);
+    }, _tasks);
+    auto inline_child = launcher.inlineChild();
+    if (_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // everybody was done before we got here
+        return handle;
+    }
+    // the children may resume us at any moment now, our frame is off limits
+    return inline_child ? inline_child : std::noop_coroutine();
+}
+
+template <typename... Ts>
+inline std::tuple<Crotine::TaskValue<Ts>...> Crotine::WhenAllAwaiter<Ts...>::await_resume()
+{
+    return std::apply([](auto&... tasks)
+    {
+        // braced initialisation keeps argument order, so the first failed child is the one rethrown
+        return std::tuple<TaskValue<Ts>...>{ take_value(tasks)... };
+    }, _tasks);
+}
+
+template <typename T>
+inline Crotine::WhenAllRangeAwaiter<T>::WhenAllRangeAwaiter(std::vector<Task<T>> tasks)
+    : _tasks(std::move(tasks)), _waiters(_tasks.size()), _remaining(_tasks.size() + 1)
+{}
+
+template <typename T>
+inline std::coroutine_handle<> Crotine::WhenAllRangeAwaiter<T>::on_child_done(TaskWaiter& waiter) noexcept
+{
+    auto* self = static_cast<WhenAllRangeAwaiter*>(static_cast<ChildWaiter&>(waiter).state);
+    if (self->_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        return self->_parent;
+    }
+    return nullptr;
+}
+
+template <typename T>
+inline bool Crotine::WhenAllRangeAwaiter<T>::await_ready() const noexcept
+{
+    return _tasks.empty();
+}
+
+template <typename T>
+inline std::coroutine_handle<> Crotine::WhenAllRangeAwaiter<T>::await_suspend(std::coroutine_handle<> handle)
+{
+    _parent = handle;
+    ChildLauncher launcher(handle);
+    for (std::size_t i = 0; i < _tasks.size(); ++i)
+    {
+        auto& waiter = _waiters[i];
+        waiter.state = this;
+        waiter.notify = &on_child_done;
+        launcher.adopt(_tasks[i]);
+        if (!_tasks[i].getPromise().addWaiter(waiter))
+        {
+            _remaining.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    launcher.launch_all(_tasks);
+    auto inline_child = launcher.inlineChild();
+    if (_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        return handle;
+    }
+    return inline_child ? inline_child : std::noop_coroutine();
+}
+
+template <typename T>
+inline std::vector<Crotine::TaskValue<T>> Crotine::WhenAllRangeAwaiter<T>::await_resume()
+{
+    std::vector<TaskValue<T>> values;
+    values.reserve(_tasks.size());
+    for (auto& task : _tasks)
+    {
+        values.push_back(take_value(task));
+    }
+    return values;
+}
+
+template <typename T, typename Slots>
+inline Crotine::WhenAnyState<T, Slots>::WhenAnyState(Slots slots) : slots(std::move(slots))
+{}
+
+template <typename T, typename Slots>
+inline void Crotine::WhenAnyState<T, Slots>::release() noexcept
+{
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete this;
+    }
+}
+
+template <typename T, typename Slots>
+inline Crotine::WhenAnyAwaiter<T, Slots>::WhenAnyAwaiter(State* state) : _state(state)
+{}
+
+template <typename T, typename Slots>
+inline Crotine::WhenAnyAwaiter<T, Slots>::~WhenAnyAwaiter()
+{
+    _state->release();
+}
+
+template <typename T, typename Slots>
+inline std::coroutine_handle<> Crotine::WhenAnyAwaiter<T, Slots>::on_child_done(TaskWaiter& waiter) noexcept
+{
+    auto& node = static_cast<ChildWaiter&>(waiter);
+    auto* state = static_cast<State*>(node.state);
+    std::coroutine_handle<> parent = nullptr;
+    if (!state->decided.exchange(true, std::memory_order_acq_rel))
+    {
+        state->winner = node.index;
+        // the losers' cancellable awaits resume through their own executors, none of them runs in here
+        state->stop.request_stop();
+        if (state->gate.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            parent = state->parent;
+        }
+    }
+    // a loser only lets go of the state, which may free this child's own frame as well
+    state->release();
+    return parent;
+}
+
+template <typename T, typename Slots>
+inline bool Crotine::WhenAnyAwaiter<T, Slots>::await_ready() const noexcept
+{
+    return false;
+}
+
+template <typename T, typename Slots>
+inline std::coroutine_handle<> Crotine::WhenAnyAwaiter<T, Slots>::await_suspend(std::coroutine_handle<> handle)
+{
+    auto* state = _state;
+    state->parent = handle;
+    state->stop.link(PromiseBase::stop_token_of(handle));
+    ChildLauncher launcher(handle, state->stop.get_token());
+    for (std::size_t i = 0; i < state->slots.size(); ++i)
+    {
+        auto& slot = state->slots[i];
+        slot.waiter.state = state;
+        slot.waiter.index = i;
+        slot.waiter.notify = &on_child_done;
+        launcher.adopt(slot.task);
+        state->references.fetch_add(1, std::memory_order_relaxed);
+        if (!slot.task.getPromise().addWaiter(slot.waiter))
+        {
+            // already finished before we asked, counts as an arrival right away
+            on_child_done(slot.waiter);
+        }
+    }
+    for (auto& slot : state->slots)
+    {
+        if (!slot.task.getPromise().isResolved())
+        {
+            launcher.launch(slot.task);
+        }
+    }
+    auto inline_child = launcher.inlineChild();
+    if (state->gate.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // a winner was already decided, the inline child still has to run somewhere
+        if (inline_child)
+        {
+            PromiseBase::resume_on_ctx(inline_child);
+        }
+        return handle;
+    }
+    return inline_child ? inline_child : std::noop_coroutine();
+}
+
+template <typename T, typename Slots>
+inline std::pair<std::size_t, Crotine::TaskValue<T>> Crotine::WhenAnyAwaiter<T, Slots>::await_resume()
+{
+    auto index = _state->winner;
+    return { index, take_value(_state->slots[index].task) };
+}
+
+template <typename... Ts>
+inline Crotine::WhenAllAwaiter<Ts...> Crotine::when_all(Task<Ts>... tasks)
+{
+    return WhenAllAwaiter<Ts...>(std::move(tasks)...);
+}
+
+template <typename T>
+inline Crotine::WhenAllRangeAwaiter<T> Crotine::when_all(std::vector<Task<T>> tasks)
+{
+    return WhenAllRangeAwaiter<T>(std::move(tasks));
+}
+
+template <typename T, typename... Rest>
+requires (std::is_same_v<T, Rest> && ...)
+inline auto Crotine::when_any(Task<T> first, Task<Rest>... rest) -> WhenAnyAwaiter<T, std::array<WhenAnySlot<T>, sizeof...(Rest) + 1>>
+{
+    using Slots = std::array<WhenAnySlot<T>, sizeof...(Rest) + 1>;
+    // the slots live inside the state, a single allocation for the whole race
+    auto* state = new WhenAnyState<T, Slots>(Slots{ { std::move(first), std::move(rest)... } });
+    return WhenAnyAwaiter<T, Slots>(state);
+}
+
+template <typename T>
+inline auto Crotine::when_any(std::vector<Task<T>> tasks) -> WhenAnyAwaiter<T, std::vector<WhenAnySlot<T>>>
+{
+    if (tasks.empty())
+    {
+        throw std::invalid_argument("when_any needs at least one task");
+    }
+    using Slots = std::vector<WhenAnySlot<T>>;
+    auto* state = new WhenAnyState<T, Slots>;
+    state->slots.reserve(tasks.size());
+    for (auto& task : tasks)
+    {
+        state->slots.emplace_back(std::move(task));
+    }
+    return WhenAnyAwaiter<T, Slots>(state);
+}
@@ -1,16 +1,79 @@
 #pragma once
+#include <span>
 #include <thread>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 #include <functional>
 
+#include "utils/UniqueFunction.hpp"
+
 namespace Crotine
 {
+    // unit of work handed to executors, move only and allocation free for small callables
+    using Job = UniqueFunction<void()>;
+
+    // scheduling class of a job, executors with priority lanes run Critical work first and Background work last
+    enum class Priority : std::uint8_t
+    {
+        Critical,
+        Normal,
+        Background
+    };
+    inline constexpr std::size_t PriorityCount = 3;
+
     class Executor
     {
+        public:
+            static constexpr std::size_t NoWorker = static_cast<std::size_t>(-1);
+        private:
+            inline static thread_local Executor* _current_executor = nullptr;
+            inline static thread_local std::size_t _current_worker = NoWorker;
+        public:
+            // marks the calling thread as running work of an executor until the binding goes out of scope
+            class ThreadBinding
+            {
+                private:
+                    Executor* _previous_executor;
+                    std::size_t _previous_worker;
+                public:
+                    ThreadBinding(Executor& executor , std::size_t worker_index = NoWorker) noexcept
+                        : _previous_executor(std::exchange(_current_executor , &executor)) , _previous_worker(std::exchange(_current_worker , worker_index)) {}
+                    ThreadBinding(const ThreadBinding&) = delete;
+                    ~ThreadBinding()
+                    {
+                        _current_executor = _previous_executor;
+                        _current_worker = _previous_worker;
+                    }
+            };
         public:
             virtual ~Executor() = default;
-            virtual void execute(std::function<void()> func)
+            virtual void execute(Job func)
+            {
+                std::thread([this , func = std::move(func)]()
+                {
+                    ThreadBinding binding(*this);
+                    func();
+                }).detach();
+            }
+            // executors without priority lanes treat it like execute()
+            virtual void execute_with_priority(Job func , Priority)
+            {
+                execute(std::move(func));
+            }
+            // hands over several jobs at once, pools override it to enqueue them under one lock
+            // and wake only as many workers as the batch can keep busy; the jobs are moved from
+            virtual void execute_batch(std::span<Job> jobs , Priority priority = Priority::Normal)
+            {
+                for(auto& job : jobs)
+                {
+                    execute_with_priority(std::move(job) , priority);
+                }
+            }
+            // upper bound of the worker indices handed out, 0 if the executor has no fixed workers
+            virtual auto getWorkerCount() const noexcept -> std::size_t
             {
-                std::thread(std::move(func)).detach();
+                return 0;
             }
         public:
             static Executor& getDefaultExecutor()
@@ -18,5 +81,16 @@ namespace Crotine
                 static Executor defaultExecutor;
                 return defaultExecutor;
             }
+            // executor running the calling thread, nullptr outside of any executor
+            static Executor* getCurrentExecutor() noexcept
+            {
+                return _current_executor;
+            }
+            // stable worker slot in [0, getWorkerCount()) of the calling pool thread, NoWorker elsewhere
+            // lets user code keep per worker shards without locking
+            static std::size_t getCurrentWorkerIndex() noexcept
+            {
+                return _current_worker;
+            }
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,259 @@
+#pragma once
+#include <memory>
+#include <cstddef>
+#include <utility>
+#include <iterator>
+#include <optional>
+#include <exception>
+#include <coroutine>
+#include <type_traits>
+
+#include "utils/FramePool.hpp"
+
+namespace Crotine
+{
+    // lazy synchronous sequence, the body runs on the iterating thread up to the next co_yield
+    // only the element in flight is alive, co_yield hands out a reference to it instead of a copy:
+    //   Generator<T>         yields T&, the consumer may move from it
+    //   Generator<const T&>  yields references to objects the body owns, e.g. elements of a container it walks
+    // single pass, begin() once; the body cannot co_await, use AsyncGenerator for that
+    template <typename T>
+    class Generator
+    {
+        public:
+            using value_type = std::remove_cvref_t<T>;
+            using reference = std::conditional_t<std::is_reference_v<T>, T, T&>;
+            using pointer = std::add_pointer_t<reference>;
+        public:
+            class PromiseType
+            {
+                private:
+                    pointer _current = nullptr;
+                    // const lvalues yielded into a by-value generator are copied here, everything else is pointed at
+                    std::optional<value_type> _copy;
+                    std::exception_ptr _exception;
+                public:
+                    auto get_return_object() -> Generator;
+                    auto initial_suspend() const noexcept -> std::suspend_always;
+                    auto final_suspend() const noexcept -> std::suspend_always;
+                    void unhandled_exception() noexcept;
+                    void return_void() const noexcept;
+                public:
+                    // the yielded object outlives the suspension, a temporary lives until the full expression ends
+                    auto yield_value(std::remove_reference_t<reference>& value) noexcept -> std::suspend_always;
+                    auto yield_value(std::remove_reference_t<reference>&& value) noexcept -> std::suspend_always;
+                    auto yield_value(const value_type& value) -> std::suspend_always
+                        requires (!std::is_reference_v<T> && !std::is_const_v<T>);
+                    template <typename U>
+                    auto await_transform(U&&) -> std::suspend_never = delete;
+#ifndef CROTINE_DISABLE_FRAME_POOL
+                public:
+                    static auto operator new(std::size_t size) -> void*;
+                    static void operator delete(void* ptr, std::size_t size) noexcept;
+#endif
+                public:
+                    auto current() const noexcept -> pointer;
+                    void rethrow_if_failed();
+            };
+            using promise_type = PromiseType;
+            using Handle = std::coroutine_handle<PromiseType>;
+        public:
+            class Iterator
+            {
+                private:
+                    Handle _handle = nullptr;
+                public:
+                    using iterator_category = std::input_iterator_tag;
+                    using difference_type = std::ptrdiff_t;
+                    using value_type = Generator::value_type;
+                    using reference = Generator::reference;
+                public:
+                    Iterator() = default;
+                    explicit Iterator(Handle handle) noexcept;
+                public:
+                    auto operator*() const noexcept -> reference;
+                    auto operator->() const noexcept -> pointer;
+                    auto operator++() -> Iterator&;
+                    void operator++(int);
+                    bool operator==(std::default_sentinel_t) const noexcept;
+            };
+        private:
+            Handle _handle;
+        public:
+            explicit Generator(Handle handle) noexcept;
+            Generator(const Generator&) = delete;
+            Generator(Generator&& other) noexcept;
+            ~Generator();
+        public:
+            Generator& operator=(const Generator&) = delete;
+            Generator& operator=(Generator&& other) noexcept;
+        public:
+            // runs the body up to its first co_yield
+            auto begin() -> Iterator;
+            auto end() const noexcept -> std::default_sentinel_t;
+    };
+}
+
+template <typename T>
+inline Crotine::Generator<T> Crotine::Generator<T>::PromiseType::get_return_object()
+{
+    return Generator(Handle::from_promise(*this));
+}
+
+template <typename T>
+inline std::suspend_always Crotine::Generator<T>::PromiseType::initial_suspend() const noexcept
+{
+    return {};
+}
+
+template <typename T>
+inline std::suspend_always Crotine::Generator<T>::PromiseType::final_suspend() const noexcept
+{
+    return {};
+}
+
+template <typename T>
+inline void Crotine::Generator<T>::PromiseType::unhandled_exception() noexcept
+{
+    _exception = std::current_exception();
+}
+
+template <typename T>
+inline void Crotine::Generator<T>::PromiseType::return_void() const noexcept
+{}
+
+template <typename T>
+inline std::suspend_always Crotine::Generator<T>::PromiseType::yield_value(std::remove_reference_t<reference>& value) noexcept
+{
+    _current = std::addressof(value);
+    return {};
+}
+
+template <typename T>
+inline std::suspend_always Crotine::Generator<T>::PromiseType::yield_value(std::remove_reference_t<reference>&& value) noexcept
+{
+    _current = std::addressof(value);
+    return {};
+}
+
+template <typename T>
+inline std::suspend_always Crotine::Generator<T>::PromiseType::yield_value(const value_type& value)
+    requires (!std::is_reference_v<T> && !std::is_const_v<T>)
+{
+    _current = std::addressof(_copy.emplace(value));
+    return {};
+}
+
+#ifndef CROTINE_DISABLE_FRAME_POOL
+template <typename T>
+inline void* Crotine::Generator<T>::PromiseType::operator new(std::size_t size)
+{
+    return FramePool::allocate(size);
+}
+
+template <typename T>
+inline void Crotine::Generator<T>::PromiseType::operator delete(void* ptr, std::size_t size) noexcept
+{
+    FramePool::deallocate(ptr, size);
+}
+#endif
+
+template <typename T>
+inline typename Crotine::Generator<T>::pointer Crotine::Generator<T>::PromiseType::current() const noexcept
+{
+    return _current;
+}
+
+template <typename T>
+inline void Crotine::Generator<T>::PromiseType::rethrow_if_failed()
+{
+    if (_exception)
+    {
+        std::rethrow_exception(std::exchange(_exception, nullptr));
+    }
+}
+
+template <typename T>
+inline Crotine::Generator<T>::Iterator::Iterator(Handle handle) noexcept : _handle(handle)
+{}
+
+template <typename T>
+inline typename Crotine::Generator<T>::reference Crotine::Generator<T>::Iterator::operator*() const noexcept
+{
+    return static_cast<reference>(*_handle.promise().current());
+}
+
+template <typename T>
+inline typename Crotine::Generator<T>::pointer Crotine::Generator<T>::Iterator::operator->() const noexcept
+{
+    return _handle.promise().current();
+}
+
+template <typename T>
+inline typename Crotine::Generator<T>::Iterator& Crotine::Generator<T>::Iterator::operator++()
+{
+    _handle.resume();
+    _handle.promise().rethrow_if_failed();
+    return *this;
+}
+
+template <typename T>
+inline void Crotine::Generator<T>::Iterator::operator++(int)
+{
+    ++*this;
+}
+
+template <typename T>
+inline bool Crotine::Generator<T>::Iterator::operator==(std::default_sentinel_t) const noexcept
+{
+    return !_handle || _handle.done();
+}
+
+template <typename T>
+inline Crotine::Generator<T>::Generator(Handle handle) noexcept : _handle(handle)
+{}
+
+template <typename T>
+inline Crotine::Generator<T>::Generator(Generator&& other) noexcept : _handle(std::exchange(other._handle, nullptr))
+{}
+
+template <typename T>
+inline Crotine::Generator<T>::~Generator()
+{
+    // a generator left in the middle destroys its frame at the last co_yield, locals are cleaned up as usual
+    if (_handle)
+    {
+        _handle.destroy();
+    }
+}
+
+template <typename T>
+inline Crotine::Generator<T>& Crotine::Generator<T>::operator=(Generator&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (_handle)
+        {
+            _handle.destroy();
+        }
+        _handle = std::exchange(other._handle, nullptr);
+    }
+    return *this;
+}
+
+template <typename T>
+inline typename Crotine::Generator<T>::Iterator Crotine::Generator<T>::begin()
+{
+    if (_handle)
+    {
+        _handle.resume();
+        _handle.promise().rethrow_if_failed();
+    }
+    return Iterator(_handle);
+}
+
+template <typename T>
+inline std::default_sentinel_t Crotine::Generator<T>::end() const noexcept
+{
+    return std::default_sentinel;
+}
@@ -0,0 +1,891 @@
+#pragma once
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <coroutine>
+#include <stdexcept>
+#include <stop_token>
+#include <system_error>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "Executor.hpp"
+#include "PromiseBase.hpp"
+
+namespace Crotine
+{
+    // single threaded event loop for I/O, linux only
+    // coroutines awaiting an operation are parked on the completion queue instead of a thread
+    // and resumed through their own execution context (inline if that is this executor)
+    // io_uring is used when the kernel allows it, epoll readiness otherwise
+    // accept and connect take sockets opened with SOCK_NONBLOCK, the epoll backend fails blocking ones with -EINVAL
+    class IoExecutor : public Executor
+    {
+        public:
+            enum class Backend : unsigned char { Auto , IoUring , Epoll };
+            enum class OpKind : unsigned char { Read , Write , Recv , Send , Accept , Connect };
+        public:
+            // awaitable for one operation, co_await yields the syscall result:
+            // bytes transferred / accepted fd / 0 on success, or -errno on failure
+            // -ECANCELED if a stop was requested for the awaiting coroutine before the operation finished
+            class Operation
+            {
+                friend class IoExecutor;
+                private:
+                    struct OnStop
+                    {
+                        Operation* operation;
+                        void operator()() const noexcept
+                        {
+                            operation->_io.request_cancel(*operation);
+                        }
+                    };
+                private:
+                    IoExecutor& _io;
+                    OpKind _kind;
+                    int _fd;
+                    void* _buffer;
+                    std::size_t _length;
+                    int _flags;
+                    const sockaddr* _address;
+                    socklen_t _address_length;
+                private:
+                    std::coroutine_handle<> _handle;
+                    long _result = 0;
+                    Operation* _next = nullptr;
+                private:
+                    // cancellation bookkeeping, the flags and _next_cancel are guarded by the incoming mutex
+                    bool _cancellable = false;
+                    bool _submitted = false;
+                    bool _cancel_requested = false;
+                    bool _completed = false;
+                    Operation* _next_cancel = nullptr;
+                    // set by the loop thread once the operation reached the backend, only then can a cancel find it
+                    bool _prepared = false;
+                    std::optional<std::stop_callback<OnStop>> _on_stop;
+                public:
+                    Operation(IoExecutor& io , OpKind kind , int fd , void* buffer , std::size_t length , int flags = 0 , const sockaddr* address = nullptr , socklen_t address_length = 0)
+                        : _io(io) , _kind(kind) , _fd(fd) , _buffer(buffer) , _length(length) , _flags(flags) , _address(address) , _address_length(address_length) {}
+                    Operation(const Operation&) = delete;
+                    Operation& operator=(const Operation&) = delete;
+                public:
+                    bool await_ready() const noexcept
+                    {
+                        return false;
+                    }
+                    bool await_suspend(std::coroutine_handle<> handle)
+                    {
+                        _handle = handle;
+                        auto& stop_token = PromiseBase::stop_token_of(handle);
+                        if (stop_token.stop_possible())
+                        {
+                            if (stop_token.stop_requested())
+                            {
+                                _result = -ECANCELED;
+                                return false;
+                            }
+                            // a stop coming in before submit() is remembered and sent along with the operation
+                            _cancellable = true;
+                            _on_stop.emplace(stop_token, OnStop{ this });
+                        }
+                        _io.submit(*this);
+                        return true;
+                    }
+                    long await_resume() const noexcept
+                    {
+                        return _result;
+                    }
+            };
+        private:
+            // epoll backend: operations waiting for readiness on one descriptor
+            struct FdWaiters
+            {
+                Operation* readers = nullptr;
+                Operation* writers = nullptr;
+                std::uint32_t registered = 0;
+            };
+        private:
+            // user_data / epoll data of the wake up eventfd, never a valid Operation address or descriptor
+            static constexpr std::uint64_t WakeTag = static_cast<std::uint64_t>(-1);
+            // user_data of io_uring cancel requests, their completions carry nothing we wait for
+            static constexpr std::uint64_t CancelTag = WakeTag - 1;
+        private:
+            Backend _backend;
+            int _wake_fd = -1;
+            std::atomic_bool _wake_pending = false;
+            std::atomic_bool _stopped = false;
+        private:
+            std::mutex _incoming_mutex;
+            std::vector<Job> _incoming_jobs;
+            Operation* _incoming_ops = nullptr;
+            Operation* _incoming_cancels = nullptr;
+        private:
+            // io_uring state, only touched by the loop thread
+            int _ring_fd = -1;
+            void* _sq_ptr = nullptr;
+            std::size_t _sq_size = 0;
+            void* _cq_ptr = nullptr;
+            std::size_t _cq_size = 0;
+            io_uring_sqe* _sqes = nullptr;
+            std::size_t _sqes_size = 0;
+            unsigned* _sq_head = nullptr;
+            unsigned* _sq_tail = nullptr;
+            unsigned* _sq_mask = nullptr;
+            unsigned* _sq_array = nullptr;
+            unsigned* _cq_head = nullptr;
+            unsigned* _cq_tail = nullptr;
+            unsigned* _cq_mask = nullptr;
+            io_uring_cqe* _cqes = nullptr;
+            unsigned _sq_entries = 0;
+            unsigned _to_submit = 0;
+            std::uint64_t _wake_buffer = 0;
+        private:
+            // epoll state, only touched by the loop thread
+            int _epoll_fd = -1;
+            std::unordered_map<int, FdWaiters> _fd_waiters;
+        private:
+            std::thread _loop;
+        private:
+            bool setup_uring(unsigned entries);
+            // every opcode we submit has to be there, ACCEPT needs 5.5, RECV / SEND and the probe itself 5.6
+            bool probe_uring();
+            void teardown_uring();
+            void setup_epoll();
+            void submit(Operation& operation);
+            void request_cancel(Operation& operation);
+            void queue_cancel(Operation& operation);
+            void wake();
+            void run();
+            // true if an operation was submitted from the loop thread meanwhile, those do not wake the loop
+            bool drain_incoming();
+            void complete(Operation& operation, long result);
+        private:
+            auto next_sqe() -> io_uring_sqe*;
+            void prepare_uring(Operation& operation);
+            void cancel_uring(Operation& operation);
+            void arm_wake_read();
+            void wait_uring();
+        private:
+            void watch_epoll(Operation& operation);
+            void cancel_epoll(Operation& operation);
+            // false if the descriptor can not be polled (regular files, directories), nothing is registered then
+            bool update_epoll(int fd, FdWaiters& waiters);
+            // readiness can be stolen and a write may not fit, on a pollable descriptor neither may block the loop
+            bool perform_epoll(Operation& operation, bool pollable = true);
+            auto take_ready(Operation*& queue) -> Operation*;
+            void wait_epoll();
+        public:
+            void execute(Job func) override;
+            void execute_batch(std::span<Job> jobs, Priority priority = Priority::Normal) override;
+            auto getWorkerCount() const noexcept -> std::size_t override;
+            auto backend() const noexcept -> Backend;
+        public:
+            auto read(int fd , std::span<std::byte> buffer) -> Operation;
+            auto write(int fd , std::span<const std::byte> buffer) -> Operation;
+            auto recv(int fd , std::span<std::byte> buffer , int flags = 0) -> Operation;
+            auto send(int fd , std::span<const std::byte> buffer , int flags = 0) -> Operation;
+            auto accept(int fd) -> Operation;
+            auto connect(int fd , const sockaddr* address , socklen_t address_length) -> Operation;
+        public:
+            IoExecutor(Backend backend = Backend::Auto , unsigned int entries = 256);
+            IoExecutor(const IoExecutor&) = delete;
+            ~IoExecutor();
+    };
+}
+
+inline Crotine::IoExecutor::IoExecutor(Backend backend, unsigned int entries) : _backend(backend)
+{
+    _wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (_wake_fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "eventfd");
+    }
+    if (_backend == Backend::Auto)
+    {
+        _backend = setup_uring(entries) ? Backend::IoUring : Backend::Epoll;
+    }
+    else if (_backend == Backend::IoUring && !setup_uring(entries))
+    {
+        ::close(_wake_fd);
+        throw std::runtime_error("io_uring is not available");
+    }
+    if (_backend == Backend::Epoll)
+    {
+        setup_epoll();
+    }
+    _loop = std::thread([this]() { run(); });
+}
+
+inline Crotine::IoExecutor::~IoExecutor()
+{
+    // operations still in flight are abandoned, their coroutines are never resumed
+    _stopped.store(true);
+    wake();
+    _loop.join();
+    teardown_uring();
+    if (_epoll_fd >= 0)
+    {
+        ::close(_epoll_fd);
+    }
+    ::close(_wake_fd);
+}
+
+inline bool Crotine::IoExecutor::setup_uring(unsigned int entries)
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    _ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (_ring_fd < 0)
+    {
+        // old kernel or blocked by seccomp
+        return false;
+    }
+    _sq_entries = params.sq_entries;
+    _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap)
+    {
+        _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+    }
+    _sq_ptr = ::mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+    _cq_ptr = single_mmap ? _sq_ptr : ::mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_CQ_RING);
+    _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    _sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQES));
+    if (_sq_ptr == MAP_FAILED || _cq_ptr == MAP_FAILED || _sqes == MAP_FAILED)
+    {
+        teardown_uring();
+        return false;
+    }
+    auto* sq = static_cast<char*>(_sq_ptr);
+    auto* cq = static_cast<char*>(_cq_ptr);
+    _sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    _sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    _sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    _sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    _cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    _cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    if (!probe_uring())
+    {
+        teardown_uring();
+        return false;
+    }
+    return true;
+}
+
+inline bool Crotine::IoExecutor::probe_uring()
+{
+    constexpr unsigned OpCount = 256;
+    alignas(io_uring_probe) unsigned char storage[sizeof(io_uring_probe) + OpCount * sizeof(io_uring_probe_op)] = {};
+    auto* probe = reinterpret_cast<io_uring_probe*>(storage);
+    if (::syscall(__NR_io_uring_register, _ring_fd, IORING_REGISTER_PROBE, probe, OpCount) < 0)
+    {
+        return false;
+    }
+    for (unsigned opcode : { IORING_OP_READ, IORING_OP_WRITE, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_ACCEPT, IORING_OP_CONNECT, IORING_OP_ASYNC_CANCEL })
+    {
+        if (opcode > probe->last_op || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline void Crotine::IoExecutor::teardown_uring()
+{
+    if (_ring_fd < 0)
+    {
+        return;
+    }
+    if (_sqes && _sqes != MAP_FAILED)
+    {
+        ::munmap(_sqes, _sqes_size);
+    }
+    if (_cq_ptr && _cq_ptr != MAP_FAILED && _cq_ptr != _sq_ptr)
+    {
+        ::munmap(_cq_ptr, _cq_size);
+    }
+    if (_sq_ptr && _sq_ptr != MAP_FAILED)
+    {
+        ::munmap(_sq_ptr, _sq_size);
+    }
+    ::close(_ring_fd);
+    _ring_fd = -1;
+    _sqes = nullptr;
+    _sq_ptr = _cq_ptr = nullptr;
+}
+
+inline void Crotine::IoExecutor::setup_epoll()
+{
+    _epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll_fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "epoll_create1");
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = WakeTag;
+    ::epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _wake_fd, &event);
+}
+
+inline void Crotine::IoExecutor::execute(Job func)
+{
+    // wake under the lock: once the loop can drain the job, nothing here touches the executor anymore
+    std::lock_guard<std::mutex> lock(_incoming_mutex);
+    _incoming_jobs.push_back(std::move(func));
+    wake();
+}
+
+inline void Crotine::IoExecutor::execute_batch(std::span<Job> jobs, Priority)
+{
+    // one lock and at most one eventfd write for the whole batch
+    std::lock_guard<std::mutex> lock(_incoming_mutex);
+    for (auto& job : jobs)
+    {
+        _incoming_jobs.push_back(std::move(job));
+    }
+    if (!jobs.empty())
+    {
+        wake();
+    }
+}
+
+inline std::size_t Crotine::IoExecutor::getWorkerCount() const noexcept
+{
+    return 1;
+}
+
+inline Crotine::IoExecutor::Backend Crotine::IoExecutor::backend() const noexcept
+{
+    return _backend;
+}
+
+inline void Crotine::IoExecutor::submit(Operation& operation)
+{
+    std::lock_guard<std::mutex> lock(_incoming_mutex);
+    operation._next = _incoming_ops;
+    _incoming_ops = &operation;
+    operation._submitted = true;
+    if (operation._cancel_requested)
+    {
+        queue_cancel(operation);
+    }
+    // the loop drains the queue until it is empty before it blocks again, no need to wake ourselves
+    if (getCurrentExecutor() != this)
+    {
+        wake();
+    }
+}
+
+inline void Crotine::IoExecutor::request_cancel(Operation& operation)
+{
+    // runs on whichever thread requested the stop
+    std::lock_guard<std::mutex> lock(_incoming_mutex);
+    if (operation._completed)
+    {
+        return;
+    }
+    operation._cancel_requested = true;
+    if (operation._submitted)
+    {
+        queue_cancel(operation);
+        wake();
+    }
+}
+
+inline void Crotine::IoExecutor::queue_cancel(Operation& operation)
+{
+    operation._next_cancel = _incoming_cancels;
+    _incoming_cancels = &operation;
+}
+
+inline void Crotine::IoExecutor::wake()
+{
+    if (!_wake_pending.exchange(true))
+    {
+        std::uint64_t one = 1;
+        [[maybe_unused]] auto written = ::write(_wake_fd, &one, sizeof(one));
+    }
+}
+
+inline void Crotine::IoExecutor::complete(Operation& operation, long result)
+{
+    if (operation._cancellable)
+    {
+        // from here on a stop request must not reach the operation, its coroutine may destroy it any moment
+        std::lock_guard<std::mutex> lock(_incoming_mutex);
+        operation._completed = true;
+        for (auto** slot = &_incoming_cancels; *slot; slot = &(*slot)->_next_cancel)
+        {
+            if (*slot == &operation)
+            {
+                *slot = operation._next_cancel;
+                break;
+            }
+        }
+    }
+    operation._result = result;
+    auto handle = operation._handle;
+    if (&PromiseBase::execution_ctx_of(handle) == this)
+    {
+        handle.resume();
+    }
+    else
+    {
+        PromiseBase::resume_on_ctx(handle);
+    }
+}
+
+inline bool Crotine::IoExecutor::drain_incoming()
+{
+    std::vector<Job> jobs;
+    {
+        std::lock_guard<std::mutex> lock(_incoming_mutex);
+        jobs.swap(_incoming_jobs);
+    }
+    for (auto& job : jobs)
+    {
+        job();
+    }
+    // operations are collected after the jobs ran, so the ones those jobs started are included
+    Operation* operations = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_incoming_mutex);
+        operations = std::exchange(_incoming_ops, nullptr);
+    }
+    // restore submission order
+    Operation* ordered = nullptr;
+    while (operations)
+    {
+        auto* next = operations->_next;
+        operations->_next = ordered;
+        ordered = operations;
+        operations = next;
+    }
+    while (ordered)
+    {
+        auto* next = ordered->_next;
+        ordered->_prepared = true;
+        if (_backend == Backend::IoUring)
+        {
+            prepare_uring(*ordered);
+        }
+        else
+        {
+            watch_epoll(*ordered);
+        }
+        ordered = next;
+    }
+    // cancels are collected only now, an operation completed inline above may be gone already and complete() unlinked it
+    // the ones for operations submitted meanwhile stay queued until those are prepared by the next drain
+    Operation* cancels = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_incoming_mutex);
+        for (auto** slot = &_incoming_cancels; *slot;)
+        {
+            auto* operation = *slot;
+            if (!operation->_prepared)
+            {
+                slot = &operation->_next_cancel;
+                continue;
+            }
+            *slot = operation->_next_cancel;
+            operation->_next_cancel = cancels;
+            cancels = operation;
+        }
+    }
+    while (cancels)
+    {
+        auto* next = cancels->_next_cancel;
+        if (_backend == Backend::IoUring)
+        {
+            cancel_uring(*cancels);
+        }
+        else
+        {
+            cancel_epoll(*cancels);
+        }
+        cancels = next;
+    }
+    std::lock_guard<std::mutex> lock(_incoming_mutex);
+    return _incoming_ops != nullptr;
+}
+
+inline void Crotine::IoExecutor::run()
+{
+    ThreadBinding binding(*this, 0);
+    if (_backend == Backend::IoUring)
+    {
+        arm_wake_read();
+    }
+    while (!_stopped.load())
+    {
+        // coroutines resumed inline while draining may submit their next operation without a wake
+        while (drain_incoming())
+        {
+        }
+        if (_backend == Backend::IoUring)
+        {
+            wait_uring();
+        }
+        else
+        {
+            wait_epoll();
+        }
+    }
+}
+
+inline io_uring_sqe* Crotine::IoExecutor::next_sqe()
+{
+    std::atomic_ref<unsigned> head(*_sq_head);
+    auto tail = *_sq_tail;
+    while (tail - head.load(std::memory_order_acquire) >= _sq_entries)
+    {
+        // submission queue full, hand what we have to the kernel first
+        ::syscall(__NR_io_uring_enter, _ring_fd, _to_submit, 0, 0, nullptr, 0);
+        _to_submit = 0;
+    }
+    auto index = tail & *_sq_mask;
+    auto* sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    _sq_array[index] = index;
+    std::atomic_ref<unsigned>(*_sq_tail).store(tail + 1, std::memory_order_release);
+    ++_to_submit;
+    return sqe;
+}
+
+inline void Crotine::IoExecutor::arm_wake_read()
+{
+    auto* sqe = next_sqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = _wake_fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&_wake_buffer);
+    sqe->len = sizeof(_wake_buffer);
+    sqe->off = static_cast<std::uint64_t>(-1);
+    sqe->user_data = WakeTag;
+}
+
+inline void Crotine::IoExecutor::prepare_uring(Operation& operation)
+{
+    auto* sqe = next_sqe();
+    sqe->fd = operation._fd;
+    sqe->user_data = reinterpret_cast<std::uint64_t>(&operation);
+    switch (operation._kind)
+    {
+        case OpKind::Read:
+        case OpKind::Write:
+            sqe->opcode = operation._kind == OpKind::Read ? IORING_OP_READ : IORING_OP_WRITE;
+            sqe->addr = reinterpret_cast<std::uint64_t>(operation._buffer);
+            sqe->len = static_cast<unsigned>(operation._length);
+            // current file position, the only meaningful one for pipes and sockets
+            sqe->off = static_cast<std::uint64_t>(-1);
+            break;
+        case OpKind::Recv:
+        case OpKind::Send:
+            sqe->opcode = operation._kind == OpKind::Recv ? IORING_OP_RECV : IORING_OP_SEND;
+            sqe->addr = reinterpret_cast<std::uint64_t>(operation._buffer);
+            sqe->len = static_cast<unsigned>(operation._length);
+            sqe->msg_flags = static_cast<unsigned>(operation._flags);
+            break;
+        case OpKind::Accept:
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->accept_flags = SOCK_CLOEXEC;
+            break;
+        case OpKind::Connect:
+            sqe->opcode = IORING_OP_CONNECT;
+            sqe->addr = reinterpret_cast<std::uint64_t>(operation._address);
+            sqe->off = operation._address_length;
+            break;
+    }
+}
+
+inline void Crotine::IoExecutor::cancel_uring(Operation& operation)
+{
+    // the operation still completes through its own cqe, with -ECANCELED unless it finished first
+    auto* sqe = next_sqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&operation);
+    sqe->user_data = CancelTag;
+}
+
+inline void Crotine::IoExecutor::wait_uring()
+{
+    auto submitted = std::exchange(_to_submit, 0);
+    ::syscall(__NR_io_uring_enter, _ring_fd, submitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    std::atomic_ref<unsigned> cq_head(*_cq_head);
+    std::atomic_ref<unsigned> cq_tail(*_cq_tail);
+    auto head = cq_head.load(std::memory_order_relaxed);
+    while (head != cq_tail.load(std::memory_order_acquire))
+    {
+        auto cqe = _cqes[head & *_cq_mask];
+        // release the slot before resuming, a resumed coroutine may queue more work
+        cq_head.store(++head, std::memory_order_release);
+        if (cqe.user_data == WakeTag)
+        {
+            _wake_pending.store(false);
+            arm_wake_read();
+        }
+        else if (cqe.user_data == CancelTag)
+        {
+            continue;
+        }
+        else
+        {
+            complete(*reinterpret_cast<Operation*>(cqe.user_data), cqe.res);
+        }
+    }
+}
+
+inline void Crotine::IoExecutor::watch_epoll(Operation& operation)
+{
+    auto& waiters = _fd_waiters[operation._fd];
+    auto writes = operation._kind == OpKind::Write || operation._kind == OpKind::Send || operation._kind == OpKind::Connect;
+    if (operation._kind == OpKind::Accept || operation._kind == OpKind::Connect)
+    {
+        // neither has a per call non blocking flag, on a blocking socket either could stall the loop
+        // fcntl failing leaves every bit set, the syscall then reports the bad descriptor itself
+        if (!(::fcntl(operation._fd, F_GETFL) & O_NONBLOCK))
+        {
+            complete(operation, -EINVAL);
+            return;
+        }
+    }
+    if (operation._kind == OpKind::Connect)
+    {
+        // a connect has to be started before there is anything to wait for
+        auto result = ::connect(operation._fd, operation._address, operation._address_length);
+        auto error = errno;
+        if (result == 0 || error != EINPROGRESS)
+        {
+            complete(operation, result == 0 ? 0 : -error);
+            return;
+        }
+    }
+    // fifo per direction, appended at the tail
+    auto** slot = writes ? &waiters.writers : &waiters.readers;
+    while (*slot)
+    {
+        slot = &(*slot)->_next;
+    }
+    operation._next = nullptr;
+    *slot = &operation;
+    if (!update_epoll(operation._fd, waiters))
+    {
+        // a regular file is always ready, the operation is the only one queued on it and runs right here
+        _fd_waiters.erase(operation._fd);
+        perform_epoll(operation, false);
+        complete(operation, operation._result);
+    }
+}
+
+inline void Crotine::IoExecutor::cancel_epoll(Operation& operation)
+{
+    auto found = _fd_waiters.find(operation._fd);
+    if (found == _fd_waiters.end())
+    {
+        return;
+    }
+    auto& waiters = found->second;
+    for (auto** queue : { &waiters.readers, &waiters.writers })
+    {
+        for (auto** slot = queue; *slot; slot = &(*slot)->_next)
+        {
+            if (*slot != &operation)
+            {
+                continue;
+            }
+            *slot = operation._next;
+            update_epoll(operation._fd, waiters);
+            complete(operation, -ECANCELED);
+            return;
+        }
+    }
+}
+
+inline bool Crotine::IoExecutor::update_epoll(int fd, FdWaiters& waiters)
+{
+    std::uint32_t wanted = (waiters.readers ? std::uint32_t{EPOLLIN} : 0u) | (waiters.writers ? std::uint32_t{EPOLLOUT} : 0u);
+    if (wanted == waiters.registered)
+    {
+        return true;
+    }
+    epoll_event event{};
+    event.events = wanted;
+    event.data.u64 = static_cast<std::uint64_t>(fd);
+    if (wanted == 0)
+    {
+        ::epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, &event);
+        _fd_waiters.erase(fd);
+        return true;
+    }
+    if (::epoll_ctl(_epoll_fd, waiters.registered == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event) < 0)
+    {
+        if (errno == EPERM)
+        {
+            return false;
+        }
+        // the descriptor number was closed and reused behind our back, start over with it
+        if (::epoll_ctl(_epoll_fd, errno == EEXIST ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event) < 0 && errno == EPERM)
+        {
+            return false;
+        }
+    }
+    waiters.registered = wanted;
+    return true;
+}
+
+inline bool Crotine::IoExecutor::perform_epoll(Operation& operation, bool pollable)
+{
+    long result = 0;
+    switch (operation._kind)
+    {
+        case OpKind::Read:
+        case OpKind::Write:
+        {
+            // O_NONBLOCK belongs to the open file description every other user of the descriptor shares, RWF_NOWAIT only to this call
+            // a regular file is read right away instead, RWF_NOWAIT would only turn a page cache miss into EAGAIN
+            iovec vector{ operation._buffer, operation._length };
+            auto reads = operation._kind == OpKind::Read;
+            auto flags = pollable ? RWF_NOWAIT : 0;
+            result = reads ? ::preadv2(operation._fd, &vector, 1, -1, flags) : ::pwritev2(operation._fd, &vector, 1, -1, flags);
+            if (result < 0 && errno == EOPNOTSUPP && flags)
+            {
+                // no per call non blocking mode for this kind of file, the readiness was just reported
+                result = reads ? ::readv(operation._fd, &vector, 1) : ::writev(operation._fd, &vector, 1);
+            }
+            break;
+        }
+        case OpKind::Recv:
+            result = ::recv(operation._fd, operation._buffer, operation._length, operation._flags | MSG_DONTWAIT);
+            break;
+        case OpKind::Send:
+            result = ::send(operation._fd, operation._buffer, operation._length, operation._flags | MSG_DONTWAIT);
+            break;
+        case OpKind::Accept:
+            // another acceptor may have taken the connection since the readiness was reported, the listener does not block
+            result = ::accept4(operation._fd, nullptr, nullptr, SOCK_CLOEXEC);
+            break;
+        case OpKind::Connect:
+        {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            ::getsockopt(operation._fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            result = error == 0 ? 0 : -1;
+            errno = error;
+            break;
+        }
+    }
+    if (pollable && result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+        // spurious readiness, keep waiting
+        return false;
+    }
+    operation._result = result < 0 ? -errno : result;
+    return true;
+}
+
+inline Crotine::IoExecutor::Operation* Crotine::IoExecutor::take_ready(Operation*& queue)
+{
+    auto* operation = queue;
+    if (!perform_epoll(*operation))
+    {
+        return nullptr;
+    }
+    queue = operation->_next;
+    return operation;
+}
+
+inline void Crotine::IoExecutor::wait_epoll()
+{
+    epoll_event events[64];
+    auto count = ::epoll_wait(_epoll_fd, events, 64, -1);
+    for (int i = 0; i < count; ++i)
+    {
+        if (events[i].data.u64 == WakeTag)
+        {
+            std::uint64_t value;
+            [[maybe_unused]] auto consumed = ::read(_wake_fd, &value, sizeof(value));
+            _wake_pending.store(false);
+            continue;
+        }
+        auto fd = static_cast<int>(events[i].data.u64);
+        auto found = _fd_waiters.find(fd);
+        if (found == _fd_waiters.end())
+        {
+            continue;
+        }
+        auto& waiters = found->second;
+        auto failed = events[i].events & (EPOLLERR | EPOLLHUP);
+        Operation* read_done = nullptr;
+        Operation* write_done = nullptr;
+        if ((events[i].events & EPOLLIN || failed) && waiters.readers)
+        {
+            read_done = take_ready(waiters.readers);
+        }
+        if ((events[i].events & EPOLLOUT || failed) && waiters.writers)
+        {
+            write_done = take_ready(waiters.writers);
+        }
+        // deregister before resuming, the resumed coroutine may close the descriptor right away
+        update_epoll(fd, waiters);
+        if (read_done)
+        {
+            complete(*read_done, read_done->_result);
+        }
+        if (write_done)
+        {
+            complete(*write_done, write_done->_result);
+        }
+    }
+}
+
+inline Crotine::IoExecutor::Operation Crotine::IoExecutor::read(int fd, std::span<std::byte> buffer)
+{
+    return Operation(*this, OpKind::Read, fd, buffer.data(), buffer.size());
+}
+
+inline Crotine::IoExecutor::Operation Crotine::IoExecutor::write(int fd, std::span<const std::byte> buffer)
+{
+    return Operation(*this, OpKind::Write, fd, const_cast<std::byte*>(buffer.data()), buffer.size());
+}
+
+inline Crotine::IoExecutor::Operation Crotine::IoExecutor::recv(int fd, std::span<std::byte> buffer, int flags)
+{
+    return Operation(*this, OpKind::Recv, fd, buffer.data(), buffer.size(), flags);
+}
+
+inline Crotine::IoExecutor::Operation Crotine::IoExecutor::send(int fd, std::span<const std::byte> buffer, int flags)
+{
+    return Operation(*this, OpKind::Send, fd, const_cast<std::byte*>(buffer.data()), buffer.size(), flags);
+}
+
+inline Crotine::IoExecutor::Operation Crotine::IoExecutor::accept(int fd)
+{
+    return Operation(*this, OpKind::Accept, fd, nullptr, 0);
+}
+
+inline Crotine::IoExecutor::Operation Crotine::IoExecutor::connect(int fd, const sockaddr* address, socklen_t address_length)
+{
+    return Operation(*this, OpKind::Connect, fd, nullptr, 0, 0, address, address_length);
+}
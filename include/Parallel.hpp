@@ -0,0 +1,406 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <optional>
+#include <exception>
+#include <coroutine>
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <ranges>
+
+#include "Executor.hpp"
+#include "PromiseBase.hpp"
+
+namespace Crotine
+{
+    // data parallel loops over random access ranges on any executor
+    //   co_await Crotine::parallel_for(pool, items, [](auto& item) { ... });          from a coroutine
+    //   auto sum = Crotine::parallel_reduce(pool, items, 0L, std::plus<>{}).get();   from a plain thread
+    // one job per participant instead of one per element: the caller and up to getWorkerCount() helpers claim
+    // chunks from a shared index, chunks shrink with the remaining work (guided scheduling) so a slow participant
+    // is balanced out by the others taking the tail, grain is the smallest chunk (0 picks one from the size)
+    // nothing runs until the operation is awaited or get() is called, the range and callables must outlive that
+    // an exception stops the remaining chunks from being claimed and is rethrown once the running ones finished
+
+    // one reduction slot per participant, padded so neighbouring workers never share a cache line
+    template <typename T>
+    struct alignas(64) ParallelPartial
+    {
+        std::optional<T> value;
+    };
+
+    template <typename View, typename F>
+    class ForEachBody
+    {
+        private:
+            View _view;
+            F _func;
+        public:
+            ForEachBody(View view, F func) : _view(std::move(view)), _func(std::move(func)) {}
+        public:
+            void prepare(std::size_t) {}
+            void operator()(std::size_t, std::size_t begin, std::size_t end)
+            {
+                auto it = std::ranges::begin(_view) + begin;
+                for (auto i = begin; i < end; ++i, ++it)
+                {
+                    std::invoke(_func, *it);
+                }
+            }
+            void result() {}
+    };
+
+    template <typename In, typename Out, typename F>
+    class TransformBody
+    {
+        private:
+            In _input;
+            Out _output;
+            F _func;
+        public:
+            TransformBody(In input, Out output, F func) : _input(std::move(input)), _output(std::move(output)), _func(std::move(func)) {}
+        public:
+            void prepare(std::size_t) {}
+            void operator()(std::size_t, std::size_t begin, std::size_t end)
+            {
+                auto in = std::ranges::begin(_input) + begin;
+                auto out = std::ranges::begin(_output) + begin;
+                for (auto i = begin; i < end; ++i, ++in, ++out)
+                {
+                    *out = std::invoke(_func, *in);
+                }
+            }
+            void result() {}
+    };
+
+    // op has to be associative and commutative, the partials are combined in no particular element order
+    template <typename View, typename T, typename Op, typename Map>
+    class ReduceBody
+    {
+        private:
+            View _view;
+            T _init;
+            Op _op;
+            Map _map;
+            std::vector<ParallelPartial<T>> _partials;
+        public:
+            ReduceBody(View view, T init, Op op, Map map) : _view(std::move(view)), _init(std::move(init)), _op(std::move(op)), _map(std::move(map)) {}
+        public:
+            void prepare(std::size_t participants)
+            {
+                _partials.resize(participants);
+            }
+            void operator()(std::size_t participant, std::size_t begin, std::size_t end)
+            {
+                // the chunk is folded in a local, a participant only ever touches its own slot
+                auto it = std::ranges::begin(_view) + begin;
+                T value = std::invoke(_map, *it);
+                ++it;
+                for (auto i = begin + 1; i < end; ++i, ++it)
+                {
+                    value = std::invoke(_op, std::move(value), std::invoke(_map, *it));
+                }
+                auto& partial = _partials[participant].value;
+                if (partial)
+                {
+                    *partial = std::invoke(_op, std::move(*partial), std::move(value));
+                }
+                else
+                {
+                    partial.emplace(std::move(value));
+                }
+            }
+            T result()
+            {
+                auto value = std::move(_init);
+                for (auto& partial : _partials)
+                {
+                    if (partial.value)
+                    {
+                        value = std::invoke(_op, std::move(value), std::move(*partial.value));
+                    }
+                }
+                return value;
+            }
+    };
+
+    // shared by the caller and the helper jobs, the helpers keep it alive until they returned
+    template <typename Body>
+    class ParallelLoop
+    {
+        private:
+            Body _body;
+            const std::size_t _size;
+            std::size_t _grain;
+            std::size_t _participants = 1;
+            alignas(64) std::atomic_size_t _next = 0;
+            alignas(64) std::atomic_size_t _completed = 0;
+            std::atomic_bool _failed = false;
+            std::exception_ptr _exception;
+            // the caller's own share and the completion of the last chunk both arrive before the caller goes on
+            std::atomic_uint _gate = 2;
+            std::coroutine_handle<> _waiting = nullptr;
+            std::atomic_bool _finished = false;
+        private:
+            bool claim(std::size_t& begin, std::size_t& end) noexcept;
+            void finish(std::size_t count) noexcept;
+            void arrive() noexcept;
+        public:
+            ParallelLoop(Body body, std::size_t size, std::size_t grain);
+            ParallelLoop(const ParallelLoop&) = delete;
+        public:
+            auto size() const noexcept -> std::size_t;
+            // posts the helpers, call participate(0) on the calling thread right after
+            void launch(const std::shared_ptr<ParallelLoop>& self, Executor& executor, Priority priority, std::size_t helpers);
+            void participate(std::size_t participant) noexcept;
+            // the caller's share is done, true if it has to wait for the helpers
+            bool leave(std::coroutine_handle<> waiting) noexcept;
+            void wait() noexcept;
+            auto result() -> decltype(std::declval<Body&>().result());
+    };
+
+    template <typename Body>
+    class [[nodiscard]] ParallelOperation
+    {
+        private:
+            Executor& _executor;
+            std::shared_ptr<ParallelLoop<Body>> _loop;
+        public:
+            using Result = decltype(std::declval<Body&>().result());
+        public:
+            ParallelOperation(Executor& executor, Body body, std::size_t size, std::size_t grain);
+        public:
+            bool await_ready() const noexcept;
+            bool await_suspend(std::coroutine_handle<> handle);
+            auto await_resume() -> Result;
+            // blocks the calling thread, which takes a share of the work itself
+            auto get() -> Result;
+    };
+
+    // func(element) for every element
+    template <std::ranges::random_access_range Range, typename F>
+    requires std::ranges::sized_range<Range>
+    auto parallel_for(Executor& executor, Range&& range, F&& func, std::size_t grain = 0);
+    // output[i] = func(input[i]), output must be at least as long as input
+    template <std::ranges::random_access_range In, std::ranges::random_access_range Out, typename F>
+    requires std::ranges::sized_range<In> && std::ranges::sized_range<Out>
+    auto parallel_transform(Executor& executor, In&& input, Out&& output, F&& func, std::size_t grain = 0);
+    // op(... op(init, map(e0)) ..., map(en)) in any grouping and order
+    template <std::ranges::random_access_range Range, typename T, typename Op, typename Map = std::identity>
+    requires std::ranges::sized_range<Range>
+    auto parallel_reduce(Executor& executor, Range&& range, T init, Op&& op, Map&& map = {}, std::size_t grain = 0);
+}
+
+template <typename Body>
+inline Crotine::ParallelLoop<Body>::ParallelLoop(Body body, std::size_t size, std::size_t grain) : _body(std::move(body)), _size(size), _grain(grain)
+{}
+
+template <typename Body>
+inline std::size_t Crotine::ParallelLoop<Body>::size() const noexcept
+{
+    return _size;
+}
+
+template <typename Body>
+inline bool Crotine::ParallelLoop<Body>::claim(std::size_t& begin, std::size_t& end) noexcept
+{
+    auto start = _next.load(std::memory_order_relaxed);
+    std::size_t length = 0;
+    do
+    {
+        if (start >= _size)
+        {
+            return false;
+        }
+        auto remaining = _size - start;
+        // big chunks first, the tail is split finer so everybody finishes at about the same time
+        length = std::min(remaining, std::max(_grain, remaining / (_participants * 4)));
+    } while (!_next.compare_exchange_weak(start, start + length, std::memory_order_relaxed));
+    begin = start;
+    end = start + length;
+    return true;
+}
+
+template <typename Body>
+inline void Crotine::ParallelLoop<Body>::finish(std::size_t count) noexcept
+{
+    if (_completed.fetch_add(count, std::memory_order_acq_rel) + count == _size)
+    {
+        arrive();
+    }
+}
+
+template <typename Body>
+inline void Crotine::ParallelLoop<Body>::arrive() noexcept
+{
+    if (_gate.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+        return;
+    }
+    if (_waiting)
+    {
+        PromiseBase::resume_on_ctx(_waiting);
+    }
+    else
+    {
+        _finished.store(true, std::memory_order_release);
+        _finished.notify_one();
+    }
+}
+
+template <typename Body>
+inline void Crotine::ParallelLoop<Body>::launch(const std::shared_ptr<ParallelLoop>& self, Executor& executor, Priority priority, std::size_t helpers)
+{
+    auto chunks = _grain ? (_size + _grain - 1) / _grain : _size;
+    _participants = std::max<std::size_t>(1, std::min(helpers + 1, chunks));
+    if (_grain == 0)
+    {
+        // about 64 claims per participant before the tail, enough to balance without contending on the index
+        _grain = std::max<std::size_t>(1, _size / (_participants * 64));
+    }
+    _body.prepare(_participants);
+    if (_participants == 1)
+    {
+        return;
+    }
+    std::vector<Job> jobs;
+    jobs.reserve(_participants - 1);
+    for (std::size_t participant = 1; participant < _participants; ++participant)
+    {
+        jobs.push_back([self, participant]()
+        {
+            self->participate(participant);
+        });
+    }
+    executor.execute_batch(jobs, priority);
+}
+
+template <typename Body>
+inline void Crotine::ParallelLoop<Body>::participate(std::size_t participant) noexcept
+{
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    while (claim(begin, end))
+    {
+        try
+        {
+            _body(participant, begin, end);
+        }
+        catch (...)
+        {
+            if (!_failed.exchange(true, std::memory_order_relaxed))
+            {
+                _exception = std::current_exception();
+            }
+            // nobody starts another chunk, what was not claimed yet counts as done
+            auto rest = _next.exchange(_size, std::memory_order_relaxed);
+            end += rest < _size ? _size - rest : 0;
+        }
+        finish(end - begin);
+    }
+}
+
+template <typename Body>
+inline bool Crotine::ParallelLoop<Body>::leave(std::coroutine_handle<> waiting) noexcept
+{
+    _waiting = waiting;
+    return _gate.fetch_sub(1, std::memory_order_acq_rel) != 1;
+}
+
+template <typename Body>
+inline void Crotine::ParallelLoop<Body>::wait() noexcept
+{
+    _finished.wait(false, std::memory_order_acquire);
+}
+
+template <typename Body>
+inline auto Crotine::ParallelLoop<Body>::result() -> decltype(std::declval<Body&>().result())
+{
+    if (_exception)
+    {
+        std::rethrow_exception(_exception);
+    }
+    return _body.result();
+}
+
+template <typename Body>
+inline Crotine::ParallelOperation<Body>::ParallelOperation(Executor& executor, Body body, std::size_t size, std::size_t grain)
+    : _executor(executor), _loop(std::make_shared<ParallelLoop<Body>>(std::move(body), size, grain))
+{}
+
+template <typename Body>
+inline bool Crotine::ParallelOperation<Body>::await_ready() const noexcept
+{
+    return _loop->size() == 0;
+}
+
+template <typename Body>
+inline bool Crotine::ParallelOperation<Body>::await_suspend(std::coroutine_handle<> handle)
+{
+    // the awaiting coroutine is usually one of the executor's workers already, so it counts as one of them
+    auto workers = std::max<std::size_t>(1, _executor.getWorkerCount() ? _executor.getWorkerCount() : std::thread::hardware_concurrency());
+    _loop->launch(_loop, _executor, PromiseBase::priority_of(handle), workers - 1);
+    _loop->participate(0);
+    return _loop->leave(handle);
+}
+
+template <typename Body>
+inline auto Crotine::ParallelOperation<Body>::await_resume() -> Result
+{
+    return _loop->result();
+}
+
+template <typename Body>
+inline auto Crotine::ParallelOperation<Body>::get() -> Result
+{
+    if (_loop->size() != 0)
+    {
+        // the calling thread is not a worker, it joins all of them
+        auto workers = std::max<std::size_t>(1, _executor.getWorkerCount() ? _executor.getWorkerCount() : std::thread::hardware_concurrency());
+        _loop->launch(_loop, _executor, Priority::Normal, workers);
+        _loop->participate(0);
+        if (_loop->leave(nullptr))
+        {
+            _loop->wait();
+        }
+    }
+    return _loop->result();
+}
+
+template <std::ranges::random_access_range Range, typename F>
+requires std::ranges::sized_range<Range>
+inline auto Crotine::parallel_for(Executor& executor, Range&& range, F&& func, std::size_t grain)
+{
+    using View = std::views::all_t<Range>;
+    using Body = ForEachBody<View, std::decay_t<F>>;
+    auto size = static_cast<std::size_t>(std::ranges::size(range));
+    return ParallelOperation<Body>(executor, Body(std::views::all(std::forward<Range>(range)), std::forward<F>(func)), size, grain);
+}
+
+template <std::ranges::random_access_range In, std::ranges::random_access_range Out, typename F>
+requires std::ranges::sized_range<In> && std::ranges::sized_range<Out>
+inline auto Crotine::parallel_transform(Executor& executor, In&& input, Out&& output, F&& func, std::size_t grain)
+{
+    auto size = static_cast<std::size_t>(std::ranges::size(input));
+    if (static_cast<std::size_t>(std::ranges::size(output)) < size)
+    {
+        throw std::invalid_argument("parallel_transform output is shorter than its input");
+    }
+    using Body = TransformBody<std::views::all_t<In>, std::views::all_t<Out>, std::decay_t<F>>;
+    return ParallelOperation<Body>(executor, Body(std::views::all(std::forward<In>(input)), std::views::all(std::forward<Out>(output)), std::forward<F>(func)), size, grain);
+}
+
+template <std::ranges::random_access_range Range, typename T, typename Op, typename Map>
+requires std::ranges::sized_range<Range>
+inline auto Crotine::parallel_reduce(Executor& executor, Range&& range, T init, Op&& op, Map&& map, std::size_t grain)
+{
+    using Body = ReduceBody<std::views::all_t<Range>, T, std::decay_t<Op>, std::decay_t<Map>>;
+    auto size = static_cast<std::size_t>(std::ranges::size(range));
+    return ParallelOperation<Body>(executor, Body(std::views::all(std::forward<Range>(range)), std::move(init), std::forward<Op>(op), std::forward<Map>(map)), size, grain);
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <span>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "Executor.hpp"
+#include "BlockChannel.hpp"
+#include "utils/Metrics.hpp"
+
+namespace Crotine
+{
+    // snapshot of one priority lane
+    struct LaneStats
+    {
+        // jobs waiting right now and the most that ever waited at once
+        std::size_t depth = 0;
+        std::size_t peak_depth = 0;
+        // jobs taken out of the lane so far
+        std::uint64_t taken = 0;
+    };
+
+    // one Channel per Priority with the channel interface on top, higher lanes are drained first
+    // starvation protection: every AgingInterval-th take starts at one of the lower lanes (in turn),
+    // so under a flood of Critical work Normal and Background still get a guaranteed share
+    template<typename Channel = BlockChannel<QueuedJob>>
+    class PriorityLanes
+    {
+        private:
+            static constexpr std::size_t AgingInterval = 8;
+        private:
+            struct Lane
+            {
+                Channel tasks;
+                // counted before the job is visible and after it left, empty lanes are skipped without touching the channel
+                alignas(64) std::atomic_size_t depth = 0;
+                std::atomic_size_t peak_depth = 0;
+                std::atomic_uint64_t taken = 0;
+            };
+        private:
+            std::array<Lane, PriorityCount> _lanes;
+            std::atomic_uint64_t _takes = 0;
+        private:
+            auto lane(Priority priority) -> Lane&;
+            void count_in(Lane& lane, std::size_t count);
+        public:
+            PriorityLanes() = default;
+            PriorityLanes(const PriorityLanes&) = delete;
+            ~PriorityLanes() = default;
+        public:
+            void put(QueuedJob job, Priority priority = Priority::Normal);
+            void put_batch(std::span<QueuedJob> jobs, Priority priority = Priority::Normal);
+            std::optional<QueuedJob> try_take();
+            void close();
+            // true if no lane holds a job, a job being put already counts
+            bool empty() const;
+            auto stats(Priority priority) const -> LaneStats;
+    };
+}
+
+template<typename Channel>
+inline auto Crotine::PriorityLanes<Channel>::lane(Priority priority) -> Lane&
+{
+    return _lanes[static_cast<std::size_t>(priority)];
+}
+
+template<typename Channel>
+inline void Crotine::PriorityLanes<Channel>::count_in(Lane& lane, std::size_t count)
+{
+    auto depth = lane.depth.fetch_add(count) + count;
+    auto peak = lane.peak_depth.load(std::memory_order_relaxed);
+    while(depth > peak && !lane.peak_depth.compare_exchange_weak(peak, depth, std::memory_order_relaxed))
+    {}
+}
+
+template<typename Channel>
+inline void Crotine::PriorityLanes<Channel>::put(QueuedJob job, Priority priority)
+{
+    auto& target = lane(priority);
+    count_in(target, 1);
+    target.tasks.put(std::move(job));
+}
+
+template<typename Channel>
+inline void Crotine::PriorityLanes<Channel>::put_batch(std::span<QueuedJob> jobs, Priority priority)
+{
+    auto& target = lane(priority);
+    count_in(target, jobs.size());
+    if constexpr (requires { target.tasks.put_batch(jobs); })
+    {
+        target.tasks.put_batch(jobs);
+    }
+    else
+    {
+        for(auto& job : jobs)
+        {
+            target.tasks.put(std::move(job));
+        }
+    }
+}
+
+template<typename Channel>
+inline std::optional<Crotine::QueuedJob> Crotine::PriorityLanes<Channel>::try_take()
+{
+    auto takes = _takes.load(std::memory_order_relaxed);
+    std::size_t first = 0;
+    if(takes % AgingInterval == AgingInterval - 1)
+    {
+        first = 1 + (takes / AgingInterval) % (PriorityCount - 1);
+    }
+    for(std::size_t i = 0; i < PriorityCount; ++i)
+    {
+        auto& candidate = _lanes[(first + i) % PriorityCount];
+        if(candidate.depth.load() == 0)
+        {
+            continue;
+        }
+        if(auto job = candidate.tasks.try_take(); job)
+        {
+            candidate.depth.fetch_sub(1);
+            candidate.taken.fetch_add(1, std::memory_order_relaxed);
+            _takes.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return std::nullopt;
+}
+
+template<typename Channel>
+inline void Crotine::PriorityLanes<Channel>::close()
+{
+    for(auto& each : _lanes)
+    {
+        each.tasks.close();
+    }
+}
+
+template<typename Channel>
+inline bool Crotine::PriorityLanes<Channel>::empty() const
+{
+    return std::all_of(_lanes.begin(), _lanes.end(), [](const Lane& each) { return each.depth.load() == 0; });
+}
+
+template<typename Channel>
+inline Crotine::LaneStats Crotine::PriorityLanes<Channel>::stats(Priority priority) const
+{
+    auto& source = _lanes[static_cast<std::size_t>(priority)];
+    return { source.depth.load(std::memory_order_relaxed), source.peak_depth.load(std::memory_order_relaxed), source.taken.load(std::memory_order_relaxed) };
+}
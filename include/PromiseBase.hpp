@@ -1,4 +1,8 @@
 #pragma once
+#include <coroutine>
+#include <functional>
+#include <stop_token>
+
 #include "Executor.hpp"
 
 namespace Crotine
@@ -7,6 +11,9 @@ namespace Crotine
     {
         private:
             std::reference_wrapper<Executor> _execution_context;
+            Priority _priority = Priority::Normal;
+            // empty unless somebody can ask the coroutine to stop, then checking it is a single load
+            std::stop_token _stop_token;
         public:
             void set_execution_ctx(Executor& ctx)
             {
@@ -16,8 +23,77 @@ namespace Crotine
             {
                 return _execution_context.get();
             }
+            // lane the coroutine is started and resumed in, on executors that have lanes
+            void set_priority(Priority priority)
+            {
+                _priority = priority;
+            }
+            Priority get_priority() const
+            {
+                return _priority;
+            }
+            // cancellation requests for the coroutine, cancellable awaitables give up early once a stop is requested
+            void set_stop_token(std::stop_token token)
+            {
+                _stop_token = std::move(token);
+            }
+            const std::stop_token& get_stop_token() const
+            {
+                return _stop_token;
+            }
+            // a child started on behalf of a parent takes over whatever it did not choose itself:
+            // the parent's executor if it is still on the default one, its priority if Normal, its stop token if it has none
+            void inherit(Executor& ctx , Priority priority , const std::stop_token& token)
+            {
+                if(&get_execution_ctx() == &Executor::getDefaultExecutor())
+                {
+                    set_execution_ctx(ctx);
+                }
+                if(_priority == Priority::Normal)
+                {
+                    _priority = priority;
+                }
+                if(!_stop_token.stop_possible())
+                {
+                    _stop_token = token;
+                }
+            }
+        private:
+            static PromiseBase& promise_of(std::coroutine_handle<> handle)
+            {
+                return std::coroutine_handle<PromiseBase>::from_address(handle.address()).promise();
+            }
+        public:
+            // execution context of a suspended coroutine whose promise derives from PromiseBase
+            static Executor& execution_ctx_of(std::coroutine_handle<> handle)
+            {
+                return promise_of(handle).get_execution_ctx();
+            }
+            static Priority priority_of(std::coroutine_handle<> handle)
+            {
+                return promise_of(handle).get_priority();
+            }
+            static const std::stop_token& stop_token_of(std::coroutine_handle<> handle)
+            {
+                return promise_of(handle).get_stop_token();
+            }
+            // lets the coroutine behind child inherit from the one behind parent, see inherit()
+            static void inherit_from(std::coroutine_handle<> child , std::coroutine_handle<> parent)
+            {
+                auto& from = promise_of(parent);
+                promise_of(child).inherit(from.get_execution_ctx() , from.get_priority() , from.get_stop_token());
+            }
+            // resumes a suspended coroutine through its own execution context, in its own priority lane
+            static void resume_on_ctx(std::coroutine_handle<> handle)
+            {
+                auto& promise = promise_of(handle);
+                promise.get_execution_ctx().execute_with_priority([handle]()
+                {
+                    handle.resume();
+                } , promise.get_priority());
+            }
         public:
             PromiseBase() : _execution_context(Executor::getDefaultExecutor()) {}
             virtual ~PromiseBase() = default;
     };
-}
\ No newline at end of file
+}
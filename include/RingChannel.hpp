@@ -0,0 +1,229 @@
+#pragma once
+#include <span>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <condition_variable>
+
+namespace Crotine
+{
+    // bounded multi producer / multi consumer channel with the same interface as BlockChannel
+    // slots are allocated once up front and claimed with a per slot sequence number (Vyukov's ring)
+    // consumers spin for a while before parking, producers only take the mutex if somebody is parked
+    // a full ring spills into a locked overflow queue instead of blocking the producer, which may be a worker itself
+    template<typename T, std::size_t Capacity = 1024>
+    class RingChannel
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "RingChannel capacity must be a power of two");
+        private:
+            struct Cell
+            {
+                std::atomic_size_t sequence;
+                std::optional<T> item;
+            };
+        private:
+            static constexpr unsigned int SpinCount = 128;
+        private:
+            std::unique_ptr<Cell[]> _cells;
+            alignas(64) std::atomic_size_t _enqueue_pos = 0;
+            alignas(64) std::atomic_size_t _dequeue_pos = 0;
+        private:
+            std::atomic_bool _closed = false;
+            std::atomic_uint _parked = 0;
+            std::mutex _mutex;
+            std::condition_variable _notifier;
+        private:
+            // only touched while the ring is full or the overflow has not drained yet
+            std::atomic_size_t _overflow_size = 0;
+            std::mutex _overflow_mutex;
+            std::deque<T> _overflow;
+        private:
+            template<typename U>
+            bool try_put(U&& item)
+            {
+                auto pos = _enqueue_pos.load(std::memory_order_relaxed);
+                while(true)
+                {
+                    auto& cell = _cells[pos & (Capacity - 1)];
+                    auto sequence = cell.sequence.load(std::memory_order_acquire);
+                    auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+                    if(diff == 0)
+                    {
+                        if(_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            cell.item.emplace(std::forward<U>(item));
+                            cell.sequence.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if(diff < 0)
+                    {
+                        // full
+                        return false;
+                    }
+                    else
+                    {
+                        pos = _enqueue_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+            template<typename U>
+            void enqueue(U&& item)
+            {
+                // once items spilled over the later ones follow them, so a producer's items stay in order
+                if(_overflow_size.load() == 0 && try_put(std::forward<U>(item)))
+                {
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(_overflow_mutex);
+                _overflow.push_back(std::forward<U>(item));
+                _overflow_size.fetch_add(1);
+            }
+            std::optional<T> take_overflow()
+            {
+                if(_overflow_size.load() == 0)
+                {
+                    return std::nullopt;
+                }
+                std::lock_guard<std::mutex> lock(_overflow_mutex);
+                if(_overflow.empty())
+                {
+                    return std::nullopt;
+                }
+                std::optional<T> item = std::move(_overflow.front());
+                _overflow.pop_front();
+                _overflow_size.fetch_sub(1);
+                return item;
+            }
+            void wake_consumers(std::size_t count)
+            {
+                // pairs with the fence in park() so either we see the parked consumer or it sees the item
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if(_parked.load(std::memory_order_relaxed) > 0)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(_mutex);
+                    }
+                    if(count > 1)
+                        _notifier.notify_all();
+                    else
+                        _notifier.notify_one();
+                }
+            }
+            template<typename U>
+            void put_item(U&& item)
+            {
+                enqueue(std::forward<U>(item));
+                wake_consumers(1);
+            }
+            std::optional<T> spin()
+            {
+                for(unsigned int i = 0; i < SpinCount && !_closed.load(std::memory_order_relaxed); ++i)
+                {
+                    if(auto item = try_take(); item)
+                    {
+                        return item;
+                    }
+                }
+                return std::nullopt;
+            }
+            template<typename Wait>
+            std::optional<T> park(Wait&& wait)
+            {
+                std::optional<T> item;
+                std::unique_lock<std::mutex> lock(_mutex);
+                _parked.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                wait(lock, [this, &item] { return _closed.load() or (item = try_take()).has_value(); });
+                _parked.fetch_sub(1, std::memory_order_relaxed);
+                return item;
+            }
+        public:
+            RingChannel() : _cells(std::make_unique<Cell[]>(Capacity))
+            {
+                for(std::size_t i = 0; i < Capacity; ++i)
+                {
+                    _cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+            ~RingChannel() = default;
+        public:
+            void put(const T& item)
+            {
+                put_item(item);
+            }
+            void put(T&& item)
+            {
+                put_item(std::move(item));
+            }
+            // consumers are woken once for the whole batch
+            void put_batch(std::span<T> items)
+            {
+                for(auto& item : items)
+                {
+                    enqueue(std::move(item));
+                }
+                if(!items.empty())
+                {
+                    wake_consumers(items.size());
+                }
+            }
+            // never blocks, returns nothing while the ring and the overflow are empty
+            std::optional<T> try_take()
+            {
+                auto pos = _dequeue_pos.load(std::memory_order_relaxed);
+                while(true)
+                {
+                    auto& cell = _cells[pos & (Capacity - 1)];
+                    auto sequence = cell.sequence.load(std::memory_order_acquire);
+                    auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+                    if(diff == 0)
+                    {
+                        if(_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            std::optional<T> item = std::move(cell.item);
+                            cell.item.reset();
+                            cell.sequence.store(pos + Capacity, std::memory_order_release);
+                            return item;
+                        }
+                    }
+                    else if(diff < 0)
+                    {
+                        // empty
+                        return take_overflow();
+                    }
+                    else
+                    {
+                        pos = _dequeue_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+            std::optional<T> take()
+            {
+                if(auto item = spin(); item)
+                {
+                    return item;
+                }
+                return park([this](auto& lock, auto predicate) { _notifier.wait(lock, predicate); });
+            }
+            std::optional<T> try_take_for(const std::chrono::milliseconds& timeout)
+            {
+                if(auto item = spin(); item)
+                {
+                    return item;
+                }
+                return park([this, timeout](auto& lock, auto predicate) { _notifier.wait_for(lock, timeout, predicate); });
+            }
+            void close()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _closed.store(true);
+                }
+                _notifier.notify_all();
+            }
+    };
+}
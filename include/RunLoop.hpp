@@ -0,0 +1,196 @@
+#pragma once
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+#include <condition_variable>
+
+#include "Task.hpp"
+#include "Executor.hpp"
+
+namespace Crotine
+{
+    // executor without threads of its own: jobs are queued and run on whichever thread drives the loop
+    //   Crotine::RunLoop loop;
+    //   task.set_execution_ctx(loop); task.execute_async();
+    //   loop.run_one() / loop.poll() step it by hand, loop.run() keeps going until finish()
+    // any thread may post (timers and io resume their coroutines on it), the driving thread takes the queued
+    // jobs in one batch per lock, vectors keep their capacity so a warm loop does not allocate
+    // jobs run in posting order, priorities are ignored, jobs still queued when the loop is destroyed are dropped
+    class RunLoop : public Executor
+    {
+        private:
+            std::mutex _mutex;
+            std::condition_variable _ready;
+            std::vector<Job> _queue;
+            std::atomic_bool _finishing = false;
+        private:
+            // taken over from _queue, only the driving thread touches these
+            std::vector<Job> _batch;
+            std::size_t _next = 0;
+        private:
+            bool refill(bool wait);
+            void run_next();
+        public:
+            RunLoop() = default;
+            RunLoop(const RunLoop&) = delete;
+        public:
+            void execute(Job func) override;
+            void execute_batch(std::span<Job> jobs , Priority priority = Priority::Normal) override;
+            // the driving thread is worker 0
+            auto getWorkerCount() const noexcept -> std::size_t override;
+        public:
+            // runs the oldest queued job, false if there was none, never blocks
+            bool run_one();
+            // runs jobs until the queue is empty, including the ones they post, returns how many ran
+            auto poll() -> std::size_t;
+            // runs jobs and waits for new ones until finish() is called, the jobs left behind stay queued
+            void run();
+            // makes the current or next run() return after the job it is running, callable from any thread
+            void finish();
+    };
+
+    // starts task (which must not be started yet) and drives loop on the calling thread until it finished,
+    // then returns its result or rethrows its exception
+    // a task on the default executor is moved onto loop, so it and the children it awaits run here without a
+    // single thread being created, a task placed on another executor runs there while the caller waits
+    // work the task leaves behind (a when_any loser, a spawned task) stays queued on loop for the next run
+    template <typename T>
+    auto sync_wait(RunLoop& loop , Task<T> task) -> T;
+    // same on a loop of its own, only for tasks that leave nothing behind that could still post to it
+    template <typename T>
+    auto sync_wait(Task<T> task) -> T;
+}
+
+inline bool Crotine::RunLoop::refill(bool wait)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if(wait)
+    {
+        _ready.wait(lock , [this]() { return !_queue.empty() || _finishing.load(std::memory_order_relaxed); });
+    }
+    if(_queue.empty())
+    {
+        return false;
+    }
+    _batch.clear();
+    _next = 0;
+    std::swap(_batch , _queue);
+    return true;
+}
+
+inline void Crotine::RunLoop::run_next()
+{
+    // moved out first, the job may post to the loop or drive it recursively
+    auto job = std::move(_batch[_next++]);
+    job();
+}
+
+inline void Crotine::RunLoop::execute(Job func)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queue.push_back(std::move(func));
+    // notified under the mutex, a run() that returns may take its loop down with it
+    _ready.notify_one();
+}
+
+inline void Crotine::RunLoop::execute_batch(std::span<Job> jobs , Priority)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for(auto& job : jobs)
+    {
+        _queue.push_back(std::move(job));
+    }
+    _ready.notify_one();
+}
+
+inline std::size_t Crotine::RunLoop::getWorkerCount() const noexcept
+{
+    return 1;
+}
+
+inline bool Crotine::RunLoop::run_one()
+{
+    if(_next == _batch.size() && !refill(false))
+    {
+        return false;
+    }
+    ThreadBinding binding(*this , 0);
+    run_next();
+    return true;
+}
+
+inline std::size_t Crotine::RunLoop::poll()
+{
+    ThreadBinding binding(*this , 0);
+    std::size_t count = 0;
+    while(_next != _batch.size() || refill(false))
+    {
+        run_next();
+        ++count;
+    }
+    return count;
+}
+
+inline void Crotine::RunLoop::run()
+{
+    ThreadBinding binding(*this , 0);
+    while(!_finishing.load(std::memory_order_acquire))
+    {
+        if(_next == _batch.size() && !refill(true))
+        {
+            continue;
+        }
+        run_next();
+    }
+    _finishing.store(false , std::memory_order_relaxed);
+}
+
+inline void Crotine::RunLoop::finish()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _finishing.store(true , std::memory_order_release);
+    _ready.notify_one();
+}
+
+template <typename T>
+inline auto Crotine::sync_wait(RunLoop& loop , Task<T> task) -> T
+{
+    struct FinishWaiter : TaskWaiter
+    {
+        RunLoop* loop;
+    };
+    auto& promise = task.getPromise();
+    if(&promise.get_execution_ctx() == &Executor::getDefaultExecutor())
+    {
+        promise.set_execution_ctx(loop);
+    }
+    // called by the task's completion before it publishes the result, run() returns once that job is done
+    FinishWaiter waiter;
+    waiter.loop = &loop;
+    waiter.callback = [](TaskWaiter& self) noexcept
+    {
+        static_cast<FinishWaiter&>(self).loop->finish();
+    };
+    promise.addWaiter(waiter);
+    task.execute_async();
+    loop.run();
+    if constexpr (std::is_void_v<T> || std::is_reference_v<T>)
+    {
+        return promise.getWaitedValue();
+    }
+    else
+    {
+        return std::move(promise.getWaitedValue());
+    }
+}
+
+template <typename T>
+inline auto Crotine::sync_wait(Task<T> task) -> T
+{
+    RunLoop loop;
+    return sync_wait(loop , std::move(task));
+}
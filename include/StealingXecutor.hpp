@@ -0,0 +1,243 @@
+#pragma once
+#include <span>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <optional>
+#include <condition_variable>
+
+#include "Executor.hpp"
+#include "utils/Metrics.hpp"
+
+namespace Crotine
+{
+    // fixed size pool where every worker owns a deque
+    // work posted from a worker stays on that worker (LIFO for cache locality)
+    // idle workers steal from the opposite end of other workers' deques
+    class StealingXecutor : public Executor
+    {
+        private:
+            struct Worker
+            {
+                std::mutex mutex;
+                std::deque<QueuedJob> tasks;
+            };
+        private:
+            std::vector<std::unique_ptr<Worker>> _workers;
+            std::vector<std::thread> _threads;
+        private:
+            // number of tasks sitting in any deque, used for parking decisions
+            std::atomic_size_t _pending = 0;
+            std::atomic_uint _sleeping = 0;
+            std::atomic_size_t _next_worker = 0;
+            bool _stopped = false;
+            std::mutex _park_mutex;
+            std::condition_variable _park_notifier;
+            [[no_unique_address]] ExecutorMetrics _metrics;
+        private:
+            void push(std::size_t index, Job func);
+            auto pop_local(std::size_t index) -> std::optional<QueuedJob>;
+            auto steal(std::size_t thief) -> std::optional<QueuedJob>;
+            void run_worker(std::size_t index);
+        public:
+            void execute(Job func) override;
+            void execute_batch(std::span<Job> jobs, Priority priority = Priority::Normal) override;
+            auto getWorkerCount() const noexcept -> std::size_t override;
+            // per worker counters and latency histograms, gauges only without CROTINE_ENABLE_METRICS
+            auto getMetrics() const -> ExecutorMetricsSnapshot;
+        public:
+            StealingXecutor(unsigned int worker_count = std::thread::hardware_concurrency());
+            ~StealingXecutor();
+    };
+}
+
+inline Crotine::StealingXecutor::StealingXecutor(unsigned int worker_count) : _metrics(std::max(worker_count, 1u))
+{
+    if(worker_count == 0)
+    {
+        worker_count = 1;
+    }
+    _workers.reserve(worker_count);
+    for(unsigned int i = 0; i < worker_count; ++i)
+    {
+        _workers.emplace_back(std::make_unique<Worker>());
+    }
+    _threads.reserve(worker_count);
+    for(std::size_t i = 0; i < worker_count; ++i)
+    {
+        _threads.emplace_back([this, i]() { run_worker(i); });
+        _metrics.thread_created();
+    }
+}
+
+inline Crotine::StealingXecutor::~StealingXecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(_park_mutex);
+        _stopped = true;
+    }
+    _park_notifier.notify_all();
+    for(auto& thread : _threads)
+    {
+        thread.join();
+    }
+}
+
+inline void Crotine::StealingXecutor::execute(Job func)
+{
+    // tasks spawned by one of our own workers are kept local
+    // everything else is spread round robin over the workers
+    if(getCurrentExecutor() == this)
+    {
+        push(getCurrentWorkerIndex(), std::move(func));
+    }
+    else
+    {
+        push(_next_worker.fetch_add(1, std::memory_order_relaxed) % _workers.size(), std::move(func));
+    }
+}
+
+inline void Crotine::StealingXecutor::execute_batch(std::span<Job> jobs, Priority)
+{
+    if(jobs.empty())
+    {
+        return;
+    }
+    // one contiguous slice per worker, each pushed under a single lock of its deque
+    auto count = _workers.size();
+    auto first = getCurrentExecutor() == this ? getCurrentWorkerIndex() : _next_worker.fetch_add(1, std::memory_order_relaxed);
+    auto slices = std::min(count, jobs.size());
+    _pending.fetch_add(jobs.size());
+    for(std::size_t slice = 0; slice < slices; ++slice)
+    {
+        auto begin = jobs.size() * slice / slices;
+        auto end = jobs.size() * (slice + 1) / slices;
+        auto& worker = *_workers[(first + slice) % count];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        for(auto i = begin; i < end; ++i)
+        {
+            worker.tasks.push_back(ExecutorMetrics::track_enqueue(std::move(jobs[i])));
+        }
+    }
+    auto sleeping = _sleeping.load();
+    if(sleeping > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_park_mutex);
+        }
+        if(jobs.size() >= sleeping)
+        {
+            _park_notifier.notify_all();
+        }
+        else
+        {
+            for(std::size_t i = 0; i < jobs.size(); ++i)
+            {
+                _park_notifier.notify_one();
+            }
+        }
+    }
+}
+
+inline std::size_t Crotine::StealingXecutor::getWorkerCount() const noexcept
+{
+    return _workers.size();
+}
+
+inline Crotine::ExecutorMetricsSnapshot Crotine::StealingXecutor::getMetrics() const
+{
+    auto snapshot = _metrics.snapshot();
+    snapshot.queue_depth = _pending.load();
+    snapshot.live_threads = _threads.size();
+    snapshot.idle_threads = _sleeping.load();
+    return snapshot;
+}
+
+inline void Crotine::StealingXecutor::push(std::size_t index, Job func)
+{
+    // counted before it is visible so a thief never sees the counter underflow
+    _pending.fetch_add(1);
+    {
+        auto& worker = *_workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(ExecutorMetrics::track_enqueue(std::move(func)));
+    }
+    // only touch the park mutex when somebody is actually parked
+    if(_sleeping.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_park_mutex);
+        }
+        _park_notifier.notify_one();
+    }
+}
+
+inline auto Crotine::StealingXecutor::pop_local(std::size_t index) -> std::optional<QueuedJob>
+{
+    auto& worker = *_workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if(worker.tasks.empty())
+    {
+        return std::nullopt;
+    }
+    auto task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return task;
+}
+
+inline auto Crotine::StealingXecutor::steal(std::size_t thief) -> std::optional<QueuedJob>
+{
+    auto count = _workers.size();
+    for(std::size_t offset = 1; offset < count; ++offset)
+    {
+        auto& victim = *_workers[(thief + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(!victim.tasks.empty())
+        {
+            auto task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return task;
+        }
+    }
+    return std::nullopt;
+}
+
+inline void Crotine::StealingXecutor::run_worker(std::size_t index)
+{
+    ThreadBinding binding(*this, index);
+    ExecutorMetrics::Binding metrics_binding(_metrics, index);
+    while(true)
+    {
+        auto task = pop_local(index);
+        if(!task)
+        {
+            task = steal(index);
+            if(task)
+            {
+                ExecutorMetrics::stolen();
+            }
+        }
+        if(task)
+        {
+            _pending.fetch_sub(1);
+            auto started = ExecutorMetrics::job_started(*task);
+            (*task)();
+            ExecutorMetrics::job_finished(started);
+            continue;
+        }
+        ExecutorMetrics::parked();
+        std::unique_lock<std::mutex> lock(_park_mutex);
+        _sleeping.fetch_add(1);
+        // the counter is rechecked under the park mutex so a push can not slip by unnoticed
+        _park_notifier.wait(lock, [this] { return _pending.load() > 0 or _stopped; });
+        _sleeping.fetch_sub(1);
+        if(_stopped && _pending.load() == 0)
+        {
+            break;
+        }
+    }
+}
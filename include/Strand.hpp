@@ -0,0 +1,182 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <cstddef>
+#include <utility>
+
+#include "Executor.hpp"
+#include "utils/FramePool.hpp"
+
+namespace Crotine
+{
+    // serial executor on top of another one: jobs posted to a strand run one at a time, in posting order,
+    // on whatever threads the underlying executor provides, so state only touched from the strand needs no lock
+    //   Crotine::Strand session(pool);
+    //   task.set_execution_ctx(session);   // every resume of the task (and of the children it inherits to) is serialized
+    // posting is a push onto an intrusive lock-free queue plus one counter increment, only the post that finds the
+    // strand idle hands a drain job to the underlying executor, the drain runs up to DrainBatch jobs and then
+    // queues itself again so one busy strand does not hold a pool thread forever
+    // priorities are ignored, the destructor waits until the jobs already posted ran
+    class Strand : public Executor
+    {
+        private:
+            struct Node
+            {
+                std::atomic<Node*> next = nullptr;
+                Job job;
+#ifndef CROTINE_DISABLE_FRAME_POOL
+                static auto operator new(std::size_t size) -> void*;
+                static void operator delete(void* ptr, std::size_t size) noexcept;
+#endif
+            };
+        public:
+            static constexpr std::size_t DrainBatch = 64;
+        private:
+            Executor& _executor;
+            // jobs posted and not finished yet, the 0 -> 1 transition schedules the drain
+            alignas(64) std::atomic_size_t _pending = 0;
+            // producers swing the tail, the running drain alone owns the head (Vyukov's MPSC queue)
+            alignas(64) std::atomic<Node*> _tail;
+            alignas(64) Node* _head;
+            Node _stub;
+        private:
+            void push(Node* node) noexcept;
+            auto pop() noexcept -> Node*;
+            void schedule();
+            void drain();
+        public:
+            explicit Strand(Executor& executor);
+            Strand(const Strand&) = delete;
+            ~Strand();
+        public:
+            void execute(Job func) override;
+            // one job at a time, code sizing itself by the worker count runs inline on a strand
+            auto getWorkerCount() const noexcept -> std::size_t override;
+        public:
+            auto getExecutor() noexcept -> Executor&;
+            // true while the calling thread runs a job of this strand
+            bool running_in_this_thread() const noexcept;
+    };
+}
+
+#ifndef CROTINE_DISABLE_FRAME_POOL
+inline void* Crotine::Strand::Node::operator new(std::size_t size)
+{
+    return FramePool::allocate(size);
+}
+
+inline void Crotine::Strand::Node::operator delete(void* ptr, std::size_t size) noexcept
+{
+    FramePool::deallocate(ptr, size);
+}
+#endif
+
+inline Crotine::Strand::Strand(Executor& executor) : _executor(executor), _tail(&_stub), _head(&_stub)
+{}
+
+inline Crotine::Strand::~Strand()
+{
+    // the drain touches nothing of the strand after its last decrement, so polling is all a notification could be
+    while (_pending.load(std::memory_order_acquire) != 0)
+    {
+        std::this_thread::yield();
+    }
+}
+
+inline void Crotine::Strand::push(Node* node) noexcept
+{
+    auto* previous = _tail.exchange(node, std::memory_order_acq_rel);
+    // between the exchange and this store the node is queued but not linked yet, pop() waits for it
+    previous->next.store(node, std::memory_order_release);
+}
+
+inline Crotine::Strand::Node* Crotine::Strand::pop() noexcept
+{
+    auto* head = _head;
+    auto* next = head->next.load(std::memory_order_acquire);
+    if (head == &_stub)
+    {
+        if (!next)
+        {
+            return nullptr;
+        }
+        _head = next;
+        head = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next)
+    {
+        _head = next;
+        return head;
+    }
+    if (head != _tail.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+    // head is the last node, the stub goes behind it so head can be handed out
+    _stub.next.store(nullptr, std::memory_order_relaxed);
+    push(&_stub);
+    next = head->next.load(std::memory_order_acquire);
+    if (next)
+    {
+        _head = next;
+        return head;
+    }
+    return nullptr;
+}
+
+inline void Crotine::Strand::schedule()
+{
+    _executor.execute([this]()
+    {
+        drain();
+    });
+}
+
+inline void Crotine::Strand::drain()
+{
+    ThreadBinding binding(*this, 0);
+    for (std::size_t ran = 0; ran < DrainBatch; ++ran)
+    {
+        // the counter says a job is there, a producer may just not have linked it yet
+        auto* node = pop();
+        while (!node)
+        {
+            std::this_thread::yield();
+            node = pop();
+        }
+        node->job();
+        delete node;
+        if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            return;
+        }
+    }
+    schedule();
+}
+
+inline void Crotine::Strand::execute(Job func)
+{
+    auto* node = new Node;
+    node->job = std::move(func);
+    push(node);
+    if (_pending.fetch_add(1, std::memory_order_acq_rel) == 0)
+    {
+        schedule();
+    }
+}
+
+inline std::size_t Crotine::Strand::getWorkerCount() const noexcept
+{
+    return 1;
+}
+
+inline Crotine::Executor& Crotine::Strand::getExecutor() noexcept
+{
+    return _executor;
+}
+
+inline bool Crotine::Strand::running_in_this_thread() const noexcept
+{
+    return getCurrentExecutor() == this;
+}
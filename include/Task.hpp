@@ -1,29 +1,62 @@
 #pragma once
+#include <atomic>
+#include <memory>
 #include <thread>
-#include <future>
+#include <utility>
 #include <variant>
+#include <exception>
 #include <optional>
 #include <functional>
 #include <coroutine>
-#include <forward_list>
+#include <type_traits>
 
 #include "PromiseBase.hpp"
+#include "Cancellation.hpp"
+#include "utils/FramePool.hpp"
 
 namespace Crotine
 {
     class Final_suspension_awaiter
     {
         private:
-            std::variant<std::suspend_always, std::suspend_never> _suspension;
+            // suspend_never: the frame frees itself once it has handed over to its awaiter (detached tasks)
+            bool _destroy_frame;
         public:
             bool await_ready() const noexcept;
             void await_resume() const noexcept;
-            void await_suspend(std::coroutine_handle<> handle) const noexcept;
+            template <typename PromiseT>
+            auto await_suspend(std::coroutine_handle<PromiseT> handle) const noexcept -> std::coroutine_handle<>;
         public:
             Final_suspension_awaiter(std::suspend_never);
             Final_suspension_awaiter(std::suspend_always);
     };
 
+    // first suspension of every task, a task whose stop was requested before it ever ran fails with OperationCancelled
+    class Start_awaiter
+    {
+        private:
+            const PromiseBase& _promise;
+        public:
+            Start_awaiter(const PromiseBase& promise) noexcept;
+        public:
+            bool await_ready() const noexcept;
+            void await_suspend(std::coroutine_handle<>) const noexcept;
+            void await_resume() const;
+    };
+
+    // intrusive node of a task's waiter list, embedded in the Awaiter of a suspended coroutine,
+    // in the shared state of a combinator, or heap allocated for the chainOn* callbacks
+    struct TaskWaiter
+    {
+        TaskWaiter* next = nullptr;
+        std::coroutine_handle<> handle = nullptr;
+        // set for callback nodes only, runs the callback and frees the node
+        void (*callback)(TaskWaiter& self) noexcept = nullptr;
+        // set for combinator nodes, called once the result is published
+        // returns the coroutine to resume in place of handle, or nullptr if nobody is due yet
+        std::coroutine_handle<> (*notify)(TaskWaiter& self) noexcept = nullptr;
+    };
+
     template <typename T>
     class Task 
     {
@@ -33,50 +66,87 @@ namespace Crotine
                 private:
                     Final_suspension_awaiter _suspension_awaiter;
                 protected:
-                    std::promise<T> _promise;
-                    std::future<T> _future;
-                private: 
-                    std::forward_list<std::function<void(std::exception_ptr)>> _exception_handlers;
+                    // the result lives in the coroutine frame itself, _state tells which member is set
+                    // a Task<T&> keeps a pointer to the referred object
+                    enum class State : unsigned char { Pending , Value , Exception };
+                    using Stored = std::conditional_t<std::is_reference_v<T>, std::add_pointer_t<T>, T>;
+                    std::atomic<State> _state = State::Pending;
+                    std::conditional_t<std::is_void_v<T>, std::monostate, std::optional<Stored>> _value;
+                    std::exception_ptr _exception;
                 public:
-                    auto initial_suspend() -> std::suspend_always;
+                    using Waiter = TaskWaiter;
+                private:
+                    // head of a lock-free stack of Waiter nodes, or completed_tag() once the task has finished
+                    std::atomic<void*> _waiters = nullptr;
+                    // set by whoever starts the coroutine first, execute_async(), start_job(), a combinator or an awaiter
+                    std::atomic_bool _started = false;
+                    static auto completed_tag() noexcept -> void*;
+                protected:
+                    void publish(State state) noexcept;
+                    template <typename F>
+                    void chainCallback(F&& callback);
+                public:
+                    bool addWaiter(Waiter& waiter) noexcept;
+                    auto complete() noexcept -> std::coroutine_handle<>;
+                public:
+                    auto initial_suspend() -> Start_awaiter;
                     auto final_suspend() noexcept -> Final_suspension_awaiter;
                     void unhandled_exception();
                 public:
                     Promise();
                     ~Promise() = default;
+#ifndef CROTINE_DISABLE_FRAME_POOL
+                public:
+                    // coroutine frames are recycled through per thread free lists instead of the global heap
+                    static auto operator new(std::size_t size) -> void*;
+                    static void operator delete(void* ptr, std::size_t size) noexcept;
+#endif
                 public:
                     bool isResolved() const noexcept;
-                    auto getWaitedValue() -> T;
+                    // true for the one caller that gets to start the coroutine, every later start is a no-op
+                    bool try_start() noexcept;
+                    // the failure of a finished task, already readable from the waiter callbacks that complete() runs
+                    auto getException() const noexcept -> const std::exception_ptr&;
+                    // the result in place, move from it only as the task's last reader
+                    auto getWaitedValue() -> std::add_lvalue_reference_t<T>;
                 public:
-                    void chainOnException(std::function<void()> handler);
-                    void chainOnException(std::function<void(std::exception_ptr)> handler);
+                    void chainOnException(UniqueFunction<void()> handler);
+                    void chainOnException(UniqueFunction<void(std::exception_ptr)> handler);
                 public:
                     void setFinalSuspensionAwaiter(Final_suspension_awaiter awaiter);
             };
             class PromiseType : public Promise
             {
-                private:
-                    std::forward_list<std::function<void(const T&)>> _continuations;
                 public:
-                    void return_value(const T& value);
+                    // forwards into the frame, co_return of a local moves
+                    template <typename U = T>
+                    void return_value(U&& value) requires std::is_convertible_v<U&&, T>;
                     auto get_return_object() -> Task<T>;
                 public:
-                    void chainOnResolved(std::function<void()> continuation);
-                    void chainOnResolved(std::function<void(const T&)> continuation);
+                    void chainOnResolved(UniqueFunction<void()> continuation);
+                    void chainOnResolved(UniqueFunction<void(const T&)> continuation);
                 public:
                     ~PromiseType() = default;
             };
-            class Awaiter
+            template <bool Move>
+            class BasicAwaiter
             {
                 private:
                     PromiseType& _promise;
+                    typename Promise::Waiter _waiter;
+                    // the task was not started yet, await_suspend starts it on behalf of the awaiting coroutine
+                    bool _start;
                 public:
-                    Awaiter(PromiseType& promise);
+                    BasicAwaiter(PromiseType& promise, bool start = false);
                 public:
                     bool await_ready() const noexcept;
-                    void await_suspend(std::coroutine_handle<> handle) const;
-                    auto await_resume();
+                    auto await_suspend(std::coroutine_handle<> handle) noexcept -> std::coroutine_handle<>;
+                    auto await_resume() -> std::conditional_t<Move, T, std::add_lvalue_reference_t<T>>;
             };
+            // co_await task reads the result in place, any number of coroutines may await the same task
+            using Awaiter = BasicAwaiter<false>;
+            // co_await std::move(task) moves the result out to its only awaiter
+            using MoveAwaiter = BasicAwaiter<true>;
         using promise_type = PromiseType;
         using Handle = std::coroutine_handle<PromiseType>;
         private:
@@ -90,12 +160,25 @@ namespace Crotine
             Task& operator=(const Task&) = delete;
             Task& operator=(Task&& other) noexcept;
         public:
+            // a task starts once, whichever start comes first (this, start_job(), a combinator or an awaiter) wins
+            // and the others do nothing, so awaiters may register before or after an explicit start
             void execute_async();
+            // job that starts the task, run it on the task's execution context, e.g. through Executor::execute_batch
+            // an empty job if the task was started already
+            auto start_job() -> Job;
+            // starts a task that was not started yet and lets its frame free itself, the Task is empty afterwards
+            void execute_detached();
             void set_execution_ctx(Executor& ctx);
+            void set_priority(Priority priority);
+            // set before starting the task, otherwise it inherits the token of the coroutine that awaits it
+            void set_stop_token(std::stop_token token);
         public:
             auto getPromise() -> PromiseType&;
         public:
-            auto operator co_await() -> Awaiter;
+            // awaiting a task that was not started yet starts it, inheriting the awaiting coroutine's
+            // context, priority and stop token like a combinator's child does
+            auto operator co_await() & -> Awaiter;
+            auto operator co_await() && -> MoveAwaiter;
         public:
             void detach();
     };
@@ -103,13 +186,11 @@ namespace Crotine
     template <>
     class Task<void>::PromiseType : public Task<void>::Promise
     {
-        private:
-            std::forward_list<std::function<void()>> _continuations;
         public:
             void return_void();
             auto get_return_object() -> Task<void>;
         public:
-            void chainOnResolved(std::function<void()> continuation);
+            void chainOnResolved(UniqueFunction<void()> continuation);
         public:
             void Wait();
         public:
@@ -119,29 +200,55 @@ namespace Crotine
 
 inline bool Crotine::Final_suspension_awaiter::await_ready() const noexcept
 {
-    return std::visit([](auto&& suspension) { return suspension.await_ready(); }, _suspension);
+    return false;
 }
 
 inline void Crotine::Final_suspension_awaiter::await_resume() const noexcept
+{}
+
+template <typename PromiseT>
+inline std::coroutine_handle<> Crotine::Final_suspension_awaiter::await_suspend(std::coroutine_handle<PromiseT> handle) const noexcept
 {
-    std::visit([](auto&& suspension) { suspension.await_resume(); }, _suspension);
+    // this awaiter lives inside the frame, so read everything before the frame can go away
+    auto destroy_frame = _destroy_frame;
+    auto next = handle.promise().complete();
+    if (destroy_frame)
+    {
+        handle.destroy();
+    }
+    return next;
 }
 
-inline void Crotine::Final_suspension_awaiter::await_suspend(std::coroutine_handle<> handle) const noexcept
+inline Crotine::Final_suspension_awaiter::Final_suspension_awaiter(std::suspend_never) : _destroy_frame(true) 
+{}
+
+inline Crotine::Final_suspension_awaiter::Final_suspension_awaiter(std::suspend_always) : _destroy_frame(false) 
+{}
+
+inline Crotine::Start_awaiter::Start_awaiter(const PromiseBase& promise) noexcept : _promise(promise)
+{}
+
+inline bool Crotine::Start_awaiter::await_ready() const noexcept
 {
-    std::visit([handle](auto&& suspension) { suspension.await_suspend(handle); }, _suspension);
+    return false;
 }
 
-inline Crotine::Final_suspension_awaiter::Final_suspension_awaiter(std::suspend_never _s) : _suspension(_s) 
+inline void Crotine::Start_awaiter::await_suspend(std::coroutine_handle<>) const noexcept
 {}
 
-inline Crotine::Final_suspension_awaiter::Final_suspension_awaiter(std::suspend_always _s) : _suspension(_s) 
-{}
+inline void Crotine::Start_awaiter::await_resume() const
+{
+    // thrown inside the coroutine body, so it ends up in unhandled_exception like any other failure
+    if (_promise.get_stop_token().stop_requested())
+    {
+        throw OperationCancelled();
+    }
+}
 
 template <typename T>
-inline std::suspend_always Crotine::Task<T>::Promise::initial_suspend()
+inline Crotine::Start_awaiter Crotine::Task<T>::Promise::initial_suspend()
 {
-    return {};
+    return { *this };
 }
 
 template <typename T>
@@ -153,80 +260,241 @@ inline Crotine::Final_suspension_awaiter Crotine::Task<T>::Promise::final_suspen
 template <typename T>
 inline void Crotine::Task<T>::Promise::unhandled_exception()
 {
-    auto exception = std::current_exception();
-    _promise.set_exception(exception);
-    for (auto& handler : _exception_handlers)
+    _exception = std::current_exception();
+}
+
+template <typename T>
+inline Crotine::Task<T>::Promise::Promise() : _suspension_awaiter(std::suspend_always{}) {}
+
+template <typename T>
+inline void Crotine::Task<T>::Promise::publish(State state) noexcept
+{
+    _state.store(state, std::memory_order_release);
+    // only threads blocked in getWaitedValue() are parked on the state word
+    _state.notify_all();
+}
+
+#ifndef CROTINE_DISABLE_FRAME_POOL
+template <typename T>
+inline void* Crotine::Task<T>::Promise::operator new(std::size_t size)
+{
+    return FramePool::allocate(size);
+}
+
+template <typename T>
+inline void Crotine::Task<T>::Promise::operator delete(void* ptr, std::size_t size) noexcept
+{
+    FramePool::deallocate(ptr, size);
+}
+#endif
+
+template <typename T>
+inline void* Crotine::Task<T>::Promise::completed_tag() noexcept
+{
+    static char tag;
+    return &tag;
+}
+
+template <typename T>
+inline bool Crotine::Task<T>::Promise::addWaiter(Waiter& waiter) noexcept
+{
+    // fails only if the task already finished, the caller then reads the result right away
+    auto head = _waiters.load(std::memory_order_acquire);
+    do
+    {
+        if (head == completed_tag())
+        {
+            return false;
+        }
+        waiter.next = static_cast<Waiter*>(head);
+    } while (!_waiters.compare_exchange_weak(head, &waiter, std::memory_order_release, std::memory_order_acquire));
+    return true;
+}
+
+template <typename T>
+template <typename F>
+inline void Crotine::Task<T>::Promise::chainCallback(F&& callback)
+{
+    struct CallbackWaiter : Waiter
+    {
+        std::decay_t<F> func;
+        CallbackWaiter(F&& f) : func(std::forward<F>(f)) {}
+    };
+    auto* node = new CallbackWaiter(std::forward<F>(callback));
+    node->callback = [](Waiter& self) noexcept
+    {
+        auto* node = static_cast<CallbackWaiter*>(&self);
+        node->func();
+        delete node;
+    };
+    if (!addWaiter(*node))
     {
-        handler(exception);
+        node->callback(*node);
     }
 }
 
 template <typename T>
-inline Crotine::Task<T>::Promise::Promise() : _suspension_awaiter(std::suspend_always{}) , _future(_promise.get_future()) {}
+inline std::coroutine_handle<> Crotine::Task<T>::Promise::complete() noexcept
+{
+    auto& execution_ctx = get_execution_ctx();
+    auto* waiter = static_cast<Waiter*>(_waiters.exchange(completed_tag(), std::memory_order_acq_rel));
+    // callbacks still need the result, so they run before anyone may destroy the frame
+    // coroutine waiters are moved to a local list, which also restores their registration order
+    Waiter* suspended = nullptr;
+    while (waiter)
+    {
+        auto* next = waiter->next;
+        if (waiter->callback)
+        {
+            waiter->callback(*waiter);
+        }
+        else
+        {
+            waiter->next = suspended;
+            suspended = waiter;
+        }
+        waiter = next;
+    }
+    publish(_exception ? State::Exception : State::Value);
+    // from here on the frame may already be destroyed, only locals and the waiter nodes are touched
+    // a node belongs to its suspended coroutine and is gone as soon as that coroutine resumes,
+    // a combinator node may even release the last reference to this frame from within notify
+    std::coroutine_handle<> transfer = std::noop_coroutine();
+    bool transferred = false;
+    while (suspended)
+    {
+        auto* next = suspended->next;
+        auto handle = suspended->notify ? suspended->notify(*suspended) : suspended->handle;
+        if (!handle)
+        {
+            suspended = next;
+            continue;
+        }
+        auto& awaiting_ctx = PromiseBase::execution_ctx_of(handle);
+        if (!transferred && &awaiting_ctx == &execution_ctx)
+        {
+            // same executor, resume the awaiting coroutine right here without a trip through the queue
+            transfer = handle;
+            transferred = true;
+        }
+        else
+        {
+            PromiseBase::resume_on_ctx(handle);
+        }
+        suspended = next;
+    }
+    return transfer;
+}
 
 template <typename T>
 inline bool Crotine::Task<T>::Promise::isResolved() const noexcept
 {
-    return _future.valid() && _future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    return _state.load(std::memory_order_acquire) != State::Pending;
 }
 
 template <typename T>
-inline T Crotine::Task<T>::Promise::getWaitedValue()
+inline bool Crotine::Task<T>::Promise::try_start() noexcept
 {
-    return _future.get();
+    return !_started.exchange(true, std::memory_order_acq_rel);
 }
 
 template <typename T>
-inline void Crotine::Task<T>::Promise::chainOnException(std::function<void()> handler)
+inline const std::exception_ptr& Crotine::Task<T>::Promise::getException() const noexcept
 {
-    _exception_handlers.emplace_front([handler](std::exception_ptr){ handler(); });
+    return _exception;
 }
 
 template <typename T>
-inline void Crotine::Task<T>::Promise::chainOnException(std::function<void(std::exception_ptr)> handler)
+inline std::add_lvalue_reference_t<T> Crotine::Task<T>::Promise::getWaitedValue()
 {
-    _exception_handlers.emplace_front(std::move(handler));
+    // blocking path for non coroutine callers, awaiters never get here before the task is resolved
+    auto state = _state.load(std::memory_order_acquire);
+    while (state == State::Pending)
+    {
+        _state.wait(State::Pending, std::memory_order_acquire);
+        state = _state.load(std::memory_order_acquire);
+    }
+    if (state == State::Exception)
+    {
+        std::rethrow_exception(_exception);
+    }
+    if constexpr (std::is_reference_v<T>)
+    {
+        return **_value;
+    }
+    else if constexpr (!std::is_void_v<T>)
+    {
+        return *_value;
+    }
 }
 
 template <typename T>
-inline void Crotine::Task<T>::Promise::setFinalSuspensionAwaiter(Final_suspension_awaiter awaiter)
+inline void Crotine::Task<T>::Promise::chainOnException(UniqueFunction<void()> handler)
 {
-    _suspension_awaiter = std::move(awaiter);
+    chainCallback([this, handler = std::move(handler)]()
+    {
+        if (_exception)
+        {
+            handler();
+        }
+    });
 }
 
-inline void Crotine::Task<void>::PromiseType::return_void()
+template <typename T>
+inline void Crotine::Task<T>::Promise::chainOnException(UniqueFunction<void(std::exception_ptr)> handler)
 {
-    _promise.set_value();
-    for (auto& continuation : _continuations)
+    chainCallback([this, handler = std::move(handler)]()
     {
-        continuation();
-    }
+        if (_exception)
+        {
+            handler(_exception);
+        }
+    });
 }
 
+template <typename T>
+inline void Crotine::Task<T>::Promise::setFinalSuspensionAwaiter(Final_suspension_awaiter awaiter)
+{
+    _suspension_awaiter = std::move(awaiter);
+}
+
+inline void Crotine::Task<void>::PromiseType::return_void()
+{}
+
 inline Crotine::Task<void> Crotine::Task<void>::PromiseType::get_return_object()
 {
     return Task<void>{Handle::from_promise(*this)};
 }
 
-inline void Crotine::Task<void>::PromiseType::chainOnResolved(std::function<void()> continuation)
+inline void Crotine::Task<void>::PromiseType::chainOnResolved(UniqueFunction<void()> continuation)
 {
-    _continuations.emplace_front(std::move(continuation));
+    chainCallback([this, continuation = std::move(continuation)]()
+    {
+        if (!_exception)
+        {
+            continuation();
+        }
+    });
 }
 
 inline void Crotine::Task<void>::PromiseType::Wait()
 {
-    _future.get();
+    getWaitedValue();
 }
 
 template <typename T>
-inline void Crotine::Task<T>::PromiseType::return_value(const T &value)
+template <typename U>
+inline void Crotine::Task<T>::PromiseType::return_value(U&& value) requires std::is_convertible_v<U&&, T>
 {
     // umm yes we need "this" here due to template dependent name lookup rules
     // read here https://stackoverflow.com/questions/10639053/name-lookups-in-c-templates
-    this->_promise.set_value(value);
-    for (auto& continuation : _continuations)
+    if constexpr (std::is_reference_v<T>)
+    {
+        this->_value.emplace(std::addressof(static_cast<T>(value)));
+    }
+    else
     {
-        continuation(value);
+        this->_value.emplace(std::forward<U>(value));
     }
 }
 
@@ -237,15 +505,27 @@ inline Crotine::Task<T> Crotine::Task<T>::PromiseType::get_return_object()
 }
 
 template <typename T>
-inline void Crotine::Task<T>::PromiseType::chainOnResolved(std::function<void()> continuation)
+inline void Crotine::Task<T>::PromiseType::chainOnResolved(UniqueFunction<void()> continuation)
 {
-    _continuations.emplace_front([continuation](const T&){ continuation(); });
+    this->chainCallback([this, continuation = std::move(continuation)]()
+    {
+        if (!this->_exception)
+        {
+            continuation();
+        }
+    });
 }
 
 template <typename T>
-inline void Crotine::Task<T>::PromiseType::chainOnResolved(std::function<void(const T&)> continuation)
+inline void Crotine::Task<T>::PromiseType::chainOnResolved(UniqueFunction<void(const T&)> continuation)
 {
-    _continuations.emplace_front(std::move(continuation));
+    this->chainCallback([this, continuation = std::move(continuation)]()
+    {
+        if (!this->_exception)
+        {
+            continuation(*this->_value);
+        }
+    });
 }
 
 template <typename T>
@@ -282,13 +562,48 @@ inline Crotine::Task<T> &Crotine::Task<T>::operator=(Task &&other) noexcept
 template <typename T>
 inline void Crotine::Task<T>::execute_async()
 {
-    if (_handle)
+    if (_handle && getPromise().try_start())
     {
-        getPromise().get_execution_ctx().execute([handle = _handle]()
+        getPromise().get_execution_ctx().execute_with_priority([handle = _handle]()
         {
             handle.resume();
-        });
+        }, getPromise().get_priority());
+    }
+}
+
+template <typename T>
+inline Crotine::Job Crotine::Task<T>::start_job()
+{
+    if (!_handle || !getPromise().try_start())
+    {
+        // somebody else started the task already
+        return []() {};
+    }
+    return [handle = _handle]()
+    {
+        handle.resume();
+    };
+}
+
+template <typename T>
+inline void Crotine::Task<T>::execute_detached()
+{
+    if (!_handle)
+    {
+        return;
+    }
+    if (!getPromise().try_start())
+    {
+        detach();
+        return;
     }
+    // nothing runs the coroutine yet, so switching the final suspension can not race with its completion
+    getPromise().setFinalSuspensionAwaiter(Final_suspension_awaiter{std::suspend_never{}});
+    getPromise().get_execution_ctx().execute_with_priority([handle = _handle]()
+    {
+        handle.resume();
+    }, getPromise().get_priority());
+    _handle = nullptr;
 }
 
 template <typename T>
@@ -298,48 +613,81 @@ inline void Crotine::Task<T>::set_execution_ctx(Executor& ctx)
 }
 
 template <typename T>
-inline Crotine::Task<T>::Awaiter::Awaiter(PromiseType& promise) : _promise(promise)
+inline void Crotine::Task<T>::set_priority(Priority priority)
+{
+    getPromise().set_priority(priority);
+}
+
+template <typename T>
+inline void Crotine::Task<T>::set_stop_token(std::stop_token token)
+{
+    getPromise().set_stop_token(std::move(token));
+}
+
+template <typename T>
+template <bool Move>
+inline Crotine::Task<T>::BasicAwaiter<Move>::BasicAwaiter(PromiseType& promise, bool start) : _promise(promise), _start(start)
 {}
 
 template <typename T>
-inline bool Crotine::Task<T>::Awaiter::await_ready() const noexcept
+template <bool Move>
+inline bool Crotine::Task<T>::BasicAwaiter<Move>::await_ready() const noexcept
 {
     return _promise.isResolved();
 }
 
 template <typename T>
-inline void Crotine::Task<T>::Awaiter::await_suspend(std::coroutine_handle<> handle) const
+template <bool Move>
+inline std::coroutine_handle<> Crotine::Task<T>::BasicAwaiter<Move>::await_suspend(std::coroutine_handle<> handle) noexcept
 {
-    auto resume_routine = [handle]() 
+    // the node lives in this awaiter, which stays alive in our frame until we are resumed
+    _waiter.handle = handle;
+    if (_start)
     {
-        auto typed_handle = std::coroutine_handle<PromiseBase>::from_address(handle.address());
-        typed_handle.promise().get_execution_ctx().execute([handle]()
+        // nothing runs the task yet, so it can still take over our context, priority and stop token
+        auto child = Handle::from_promise(_promise);
+        PromiseBase::inherit_from(child, handle);
+        _promise.addWaiter(_waiter);
+        if (&_promise.get_execution_ctx() == &PromiseBase::execution_ctx_of(handle))
         {
-            handle.resume();
-        });
-    };
-    if (!_promise.isResolved())
+            return child;
+        }
+        PromiseBase::resume_on_ctx(child);
+        return std::noop_coroutine();
+    }
+    if (_promise.addWaiter(_waiter))
     {
-        _promise.chainOnResolved(resume_routine);
-        _promise.chainOnException(resume_routine);
+        // the task resumes us from its final suspension point
+        return std::noop_coroutine();
+    }
+    // already finished, keep running
+    return handle;
+}
+
+template <typename T>
+template <bool Move>
+inline auto Crotine::Task<T>::BasicAwaiter<Move>::await_resume() -> std::conditional_t<Move, T, std::add_lvalue_reference_t<T>>
+{
+    if constexpr (Move && !std::is_void_v<T> && !std::is_reference_v<T>)
+    {
+        return std::move(_promise.getWaitedValue());
     }
     else
     {
-        resume_routine();
+        return _promise.getWaitedValue();
     }
 }
 
 template <typename T>
-inline auto Crotine::Task<T>::Awaiter::await_resume()
+inline Crotine::Task<T>::Awaiter Crotine::Task<T>::operator co_await() &
 {
-
-    return _promise.getWaitedValue();
+    return { getPromise(), getPromise().try_start() };
 }
 
 template <typename T>
-inline Crotine::Task<T>::Awaiter Crotine::Task<T>::operator co_await()
+inline Crotine::Task<T>::MoveAwaiter Crotine::Task<T>::operator co_await() &&
 {
-    return { getPromise() };
+    return { getPromise(), getPromise().try_start() };
 }
 
 template <typename T>
@@ -19,5 +19,10 @@ namespace Crotine
             {
                 return RunTask(executor , std::forward<F>(f), std::forward<Args>(args)...);
             }
+            template<std::ranges::input_range Range>
+            auto RunAll(Range&& functions)
+            {
+                return RunTasks(executor , std::forward<Range>(functions));
+            }
     };
 }
\ No newline at end of file
@@ -0,0 +1,599 @@
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <functional>
+#include <coroutine>
+#include <stop_token>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include <condition_variable>
+
+#include "Task.hpp"
+#include "PromiseBase.hpp"
+#include "Cancellation.hpp"
+
+namespace Crotine
+{
+    // hierarchical timer wheel (4 levels of 64 slots, 1ms ticks) driven by one service thread
+    // a pending timer is an intrusive node, so it costs its node and nothing else
+    // expired coroutines are handed back to their own execution context, user code never runs on the timer thread
+    class TimerWheel
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+            // intrusive node, embedded in a suspended sleep awaiter or in a with_timeout race
+            struct Entry
+            {
+                Entry* next = nullptr;
+                Entry* prev = nullptr;
+                // slot list the node is linked into, nullptr while not armed
+                Entry** head = nullptr;
+                std::uint64_t deadline = 0;
+                std::coroutine_handle<> handle = nullptr;
+                // set for non coroutine entries, called on the timer thread instead of resuming handle
+                void (*callback)(Entry& self) noexcept = nullptr;
+            };
+        public:
+            static constexpr unsigned int SlotBits = 6;
+            static constexpr unsigned int SlotCount = 1u << SlotBits;
+            static constexpr unsigned int LevelCount = 4;
+        private:
+            static constexpr std::uint64_t SlotMask = SlotCount - 1;
+            // deadlines further out are parked in the last level and cascaded again until they fit
+            static constexpr std::uint64_t MaxSpan = (std::uint64_t(1) << (SlotBits * LevelCount)) - 1;
+            static constexpr std::uint64_t NoWake = static_cast<std::uint64_t>(-1);
+        private:
+            const Clock::time_point _origin = Clock::now();
+            Entry* _slots[LevelCount][SlotCount] = {};
+            // tick up to which the wheel has been advanced
+            std::uint64_t _current = 0;
+            std::uint64_t _wake_tick = NoWake;
+            std::size_t _pending = 0;
+            bool _stopped = false;
+            std::mutex _mutex;
+            std::condition_variable _notifier;
+            std::thread _thread;
+        private:
+            auto to_tick(Clock::time_point time_point) const -> std::uint64_t;
+            // last tick that fully passed, the wheel is never advanced beyond it
+            auto elapsed_tick() const -> std::uint64_t;
+            void link(Entry& entry);
+            void unlink(Entry& entry);
+            auto advance(std::uint64_t now) -> Entry*;
+            auto next_wake() const -> std::uint64_t;
+            void run();
+        public:
+            // arms entry, a deadline that already passed fires on the next tick
+            void schedule(Entry& entry, Clock::time_point deadline);
+            // true if the entry was disarmed before it fired
+            bool cancel(Entry& entry);
+            auto getPendingCount() -> std::size_t;
+        public:
+            TimerWheel();
+            TimerWheel(const TimerWheel&) = delete;
+            // entries still pending are dropped, their coroutines never resume
+            ~TimerWheel();
+        public:
+            static TimerWheel& getDefaultTimer();
+    };
+
+    class SleepAwaiter
+    {
+        private:
+            struct SleepEntry : TimerWheel::Entry
+            {
+                SleepAwaiter* awaiter = nullptr;
+            };
+            struct OnStop
+            {
+                SleepAwaiter* awaiter;
+                void operator()() const noexcept;
+            };
+        private:
+            TimerWheel& _timer;
+            TimerWheel::Clock::time_point _deadline;
+            SleepEntry _entry;
+            // a cancellable sleep resumes once await_suspend and the outcome (expiry or a successful stop) both arrived
+            std::coroutine_handle<> _handle = nullptr;
+            std::atomic_uint _arrivals = 2;
+            bool _cancelled = false;
+            std::optional<std::stop_callback<OnStop>> _on_stop;
+        private:
+            static void expired(TimerWheel::Entry& entry) noexcept;
+            void arrive() noexcept;
+        public:
+            SleepAwaiter(TimerWheel& timer, TimerWheel::Clock::time_point deadline);
+            SleepAwaiter(const SleepAwaiter&) = delete;
+        public:
+            bool await_ready() const noexcept;
+            bool await_suspend(std::coroutine_handle<> handle);
+            void await_resume() const;
+    };
+
+    // co_await Crotine::sleep_for(d) suspends the coroutine without holding on to its thread
+    // throws OperationCancelled right away if a stop is requested for the coroutine while it sleeps
+    template <typename Rep, typename Period>
+    auto sleep_for(std::chrono::duration<Rep, Period> duration, TimerWheel& timer = TimerWheel::getDefaultTimer()) -> SleepAwaiter;
+    template <typename Duration>
+    auto sleep_until(std::chrono::time_point<TimerWheel::Clock, Duration> time_point, TimerWheel& timer = TimerWheel::getDefaultTimer()) -> SleepAwaiter;
+
+    class TimeoutError : public std::runtime_error
+    {
+        public:
+            TimeoutError() : std::runtime_error("Task timed out") {}
+    };
+
+    // shared between the with_timeout awaiter, the coroutine watching the task and the armed timer
+    // whoever settles it first resumes the waiting coroutine, the others back off
+    template <typename T>
+    class TimeoutRace
+    {
+        private:
+            struct RaceEntry : TimerWheel::Entry
+            {
+                TimeoutRace* race = nullptr;
+            };
+        private:
+            TimerWheel& _timer;
+            RaceEntry _entry;
+            // keeps the race alive while the timer is armed
+            std::shared_ptr<TimeoutRace> _timer_ref;
+            // the task's stop token, stopped on timeout or when the awaiting coroutine is cancelled
+            LinkedStopSource _stop;
+            std::atomic_bool _settled = false;
+            std::coroutine_handle<> _waiting = nullptr;
+            // a Task<T&> result is kept as a std::reference_wrapper, like the combinators do
+            using Stored = std::conditional_t<std::is_reference_v<T>, std::reference_wrapper<std::remove_reference_t<T>>, T>;
+            std::conditional_t<std::is_void_v<T>, bool, std::optional<Stored>> _value{};
+            std::exception_ptr _exception;
+        private:
+            static auto watch(Task<T> task, std::shared_ptr<TimeoutRace> race) -> Task<void>;
+            void finish(std::exception_ptr exception);
+        public:
+            class Awaiter
+            {
+                private:
+                    std::shared_ptr<TimeoutRace> _race;
+                    Task<T> _task;
+                    TimerWheel::Clock::time_point _deadline;
+                public:
+                    Awaiter(TimerWheel& timer, Task<T> task, TimerWheel::Clock::time_point deadline);
+                public:
+                    bool await_ready() const noexcept;
+                    void await_suspend(std::coroutine_handle<> handle);
+                    auto await_resume() -> T;
+            };
+        public:
+            TimeoutRace(TimerWheel& timer);
+    };
+
+    // co_await Crotine::with_timeout(task, d) starts task (which must not be started yet)
+    // and throws TimeoutError if it has not finished within d
+    // a timed out task gets a stop request and keeps running in the background until it notices, its result is discarded
+    template <typename T, typename Rep, typename Period>
+    auto with_timeout(Task<T> task, std::chrono::duration<Rep, Period> duration, TimerWheel& timer = TimerWheel::getDefaultTimer()) -> typename TimeoutRace<T>::Awaiter;
+}
+
+inline Crotine::TimerWheel::TimerWheel()
+{
+    _thread = std::thread([this]() { run(); });
+}
+
+inline Crotine::TimerWheel::~TimerWheel()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+    }
+    _notifier.notify_one();
+    _thread.join();
+}
+
+inline Crotine::TimerWheel& Crotine::TimerWheel::getDefaultTimer()
+{
+    // never destroyed, coroutines on detached threads may still sleep after main returns
+    static auto* instance = new TimerWheel;
+    return *instance;
+}
+
+inline std::uint64_t Crotine::TimerWheel::to_tick(Clock::time_point time_point) const
+{
+    // rounded up, a timer never fires early
+    auto elapsed = std::chrono::ceil<std::chrono::milliseconds>(time_point - _origin).count();
+    return elapsed < 0 ? 0 : static_cast<std::uint64_t>(elapsed);
+}
+
+inline std::uint64_t Crotine::TimerWheel::elapsed_tick() const
+{
+    // rounded down, waking mid-tick must not expire what is due at its end
+    auto elapsed = std::chrono::floor<std::chrono::milliseconds>(Clock::now() - _origin).count();
+    return elapsed < 0 ? 0 : static_cast<std::uint64_t>(elapsed);
+}
+
+inline void Crotine::TimerWheel::link(Entry& entry)
+{
+    auto delta = entry.deadline - _current;
+    unsigned int level = 0;
+    while (level + 1 < LevelCount && delta >= (std::uint64_t(1) << (SlotBits * (level + 1))))
+    {
+        ++level;
+    }
+    auto slot_tick = _current + (delta > MaxSpan ? MaxSpan : delta);
+    auto& head = _slots[level][(slot_tick >> (SlotBits * level)) & SlotMask];
+    entry.prev = nullptr;
+    entry.next = head;
+    if (head)
+    {
+        head->prev = &entry;
+    }
+    head = &entry;
+    entry.head = &head;
+}
+
+inline void Crotine::TimerWheel::unlink(Entry& entry)
+{
+    if (entry.prev)
+    {
+        entry.prev->next = entry.next;
+    }
+    else
+    {
+        *entry.head = entry.next;
+    }
+    if (entry.next)
+    {
+        entry.next->prev = entry.prev;
+    }
+    entry.head = nullptr;
+}
+
+inline auto Crotine::TimerWheel::advance(std::uint64_t now) -> Entry*
+{
+    // walks the wheel up to now and returns the expired entries, already unlinked
+    Entry* expired = nullptr;
+    while (_current < now)
+    {
+        if (_pending == 0)
+        {
+            _current = now;
+            break;
+        }
+        ++_current;
+        // entries of a higher level slot get redistributed once the lower levels wrapped around to it
+        for (auto level = LevelCount - 1; level > 0; --level)
+        {
+            if ((_current & ((std::uint64_t(1) << (SlotBits * level)) - 1)) != 0)
+            {
+                continue;
+            }
+            auto* entry = std::exchange(_slots[level][(_current >> (SlotBits * level)) & SlotMask], nullptr);
+            while (entry)
+            {
+                auto* next = entry->next;
+                link(*entry);
+                entry = next;
+            }
+        }
+        auto* entry = std::exchange(_slots[0][_current & SlotMask], nullptr);
+        while (entry)
+        {
+            auto* next = entry->next;
+            entry->head = nullptr;
+            entry->next = expired;
+            expired = entry;
+            --_pending;
+            entry = next;
+        }
+    }
+    return expired;
+}
+
+inline std::uint64_t Crotine::TimerWheel::next_wake() const
+{
+    if (_pending == 0)
+    {
+        return NoWake;
+    }
+    for (std::uint64_t tick = _current + 1; tick < _current + SlotCount; ++tick)
+    {
+        if (_slots[0][tick & SlotMask])
+        {
+            return tick;
+        }
+    }
+    // nothing due in the first level, wake up for the next cascade
+    return ((_current >> SlotBits) + 1) << SlotBits;
+}
+
+inline void Crotine::TimerWheel::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopped)
+    {
+        if (auto* expired = advance(elapsed_tick()); expired)
+        {
+            lock.unlock();
+            while (expired)
+            {
+                // the entry belongs to whoever armed it and may be gone as soon as it fired
+                auto* next = expired->next;
+                if (expired->callback)
+                {
+                    expired->callback(*expired);
+                }
+                else
+                {
+                    PromiseBase::resume_on_ctx(expired->handle);
+                }
+                expired = next;
+            }
+            lock.lock();
+            continue;
+        }
+        _wake_tick = next_wake();
+        if (_wake_tick == NoWake)
+        {
+            _notifier.wait(lock);
+        }
+        else
+        {
+            _notifier.wait_until(lock, _origin + std::chrono::milliseconds(_wake_tick));
+        }
+    }
+}
+
+inline void Crotine::TimerWheel::schedule(Entry& entry, Clock::time_point deadline)
+{
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_pending == 0)
+        {
+            // an empty wheel is not advanced while the thread sleeps, catch up before measuring the distance
+            _current = std::max(_current, elapsed_tick());
+        }
+        entry.deadline = std::max(to_tick(deadline), _current + 1);
+        link(entry);
+        ++_pending;
+        if (entry.deadline < _wake_tick)
+        {
+            _wake_tick = entry.deadline;
+            wake = true;
+        }
+    }
+    if (wake)
+    {
+        _notifier.notify_one();
+    }
+}
+
+inline bool Crotine::TimerWheel::cancel(Entry& entry)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!entry.head)
+    {
+        // already fired or firing
+        return false;
+    }
+    unlink(entry);
+    --_pending;
+    return true;
+}
+
+inline std::size_t Crotine::TimerWheel::getPendingCount()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pending;
+}
+
+inline Crotine::SleepAwaiter::SleepAwaiter(TimerWheel& timer, TimerWheel::Clock::time_point deadline) : _timer(timer), _deadline(deadline)
+{}
+
+inline bool Crotine::SleepAwaiter::await_ready() const noexcept
+{
+    return _deadline <= TimerWheel::Clock::now();
+}
+
+inline void Crotine::SleepAwaiter::OnStop::operator()() const noexcept
+{
+    // only a stop that disarms the timer counts, a timer that already fired resumes us normally
+    if (awaiter->_timer.cancel(awaiter->_entry))
+    {
+        awaiter->_cancelled = true;
+        awaiter->arrive();
+    }
+}
+
+inline void Crotine::SleepAwaiter::expired(TimerWheel::Entry& entry) noexcept
+{
+    static_cast<SleepEntry&>(entry).awaiter->arrive();
+}
+
+inline void Crotine::SleepAwaiter::arrive() noexcept
+{
+    // whoever arrives first must not touch the awaiter afterwards, the second one resumes the coroutine
+    if (_arrivals.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        PromiseBase::resume_on_ctx(_handle);
+    }
+}
+
+inline bool Crotine::SleepAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    // the entry lives in this awaiter, which stays in our frame until the timer resumes us
+    auto& stop_token = PromiseBase::stop_token_of(handle);
+    if (!stop_token.stop_possible())
+    {
+        _entry.handle = handle;
+        _timer.schedule(_entry, _deadline);
+        return true;
+    }
+    if (stop_token.stop_requested())
+    {
+        _cancelled = true;
+        return false;
+    }
+    _handle = handle;
+    _entry.awaiter = this;
+    _entry.callback = &expired;
+    _timer.schedule(_entry, _deadline);
+    // runs OnStop right here if the stop came in the meantime
+    _on_stop.emplace(stop_token, OnStop{ this });
+    return _arrivals.fetch_sub(1, std::memory_order_acq_rel) != 1;
+}
+
+inline void Crotine::SleepAwaiter::await_resume() const
+{
+    if (_cancelled)
+    {
+        throw OperationCancelled();
+    }
+}
+
+template <typename Rep, typename Period>
+inline Crotine::SleepAwaiter Crotine::sleep_for(std::chrono::duration<Rep, Period> duration, TimerWheel& timer)
+{
+    return { timer, TimerWheel::Clock::now() + std::chrono::duration_cast<TimerWheel::Clock::duration>(duration) };
+}
+
+template <typename Duration>
+inline Crotine::SleepAwaiter Crotine::sleep_until(std::chrono::time_point<TimerWheel::Clock, Duration> time_point, TimerWheel& timer)
+{
+    return { timer, std::chrono::time_point_cast<TimerWheel::Clock::duration>(time_point) };
+}
+
+template <typename T>
+inline Crotine::TimeoutRace<T>::TimeoutRace(TimerWheel& timer) : _timer(timer)
+{
+    _entry.race = this;
+    _entry.callback = [](TimerWheel::Entry& entry) noexcept
+    {
+        auto* race = static_cast<RaceEntry&>(entry).race;
+        auto keep_alive = std::move(race->_timer_ref);
+        if (!race->_settled.exchange(true, std::memory_order_acq_rel))
+        {
+            race->_stop.request_stop();
+            PromiseBase::resume_on_ctx(race->_waiting);
+        }
+    };
+}
+
+template <typename T>
+inline void Crotine::TimeoutRace<T>::finish(std::exception_ptr exception)
+{
+    _exception = std::move(exception);
+    if (_timer.cancel(_entry))
+    {
+        _timer_ref.reset();
+    }
+    PromiseBase::resume_on_ctx(_waiting);
+}
+
+template <typename T>
+inline Crotine::Task<void> Crotine::TimeoutRace<T>::watch(Task<T> task, std::shared_ptr<TimeoutRace> race)
+{
+    task.execute_async();
+    try
+    {
+        if constexpr (std::is_void_v<T>)
+        {
+            co_await task;
+            if (!race->_settled.exchange(true, std::memory_order_acq_rel))
+            {
+                race->_value = true;
+                race->finish(nullptr);
+            }
+        }
+        else
+        {
+            auto&& value = co_await std::move(task);
+            if (!race->_settled.exchange(true, std::memory_order_acq_rel))
+            {
+                race->_value.emplace(std::forward<decltype(value)>(value));
+                race->finish(nullptr);
+            }
+        }
+    }
+    catch (...)
+    {
+        if (!race->_settled.exchange(true, std::memory_order_acq_rel))
+        {
+            race->finish(std::current_exception());
+        }
+    }
+}
+
+template <typename T>
+inline Crotine::TimeoutRace<T>::Awaiter::Awaiter(TimerWheel& timer, Task<T> task, TimerWheel::Clock::time_point deadline)
+    : _race(std::make_shared<TimeoutRace>(timer)), _task(std::move(task)), _deadline(deadline)
+{}
+
+template <typename T>
+inline bool Crotine::TimeoutRace<T>::Awaiter::await_ready() const noexcept
+{
+    return false;
+}
+
+template <typename T>
+inline void Crotine::TimeoutRace<T>::Awaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    // the watcher runs where the task runs, so awaiting the task is a plain symmetric transfer
+    auto& promise = _task.getPromise();
+    auto& execution_ctx = promise.get_execution_ctx();
+    _race->_stop.link(PromiseBase::stop_token_of(handle));
+    if (!promise.get_stop_token().stop_possible())
+    {
+        promise.set_stop_token(_race->_stop.get_token());
+    }
+    auto watcher = watch(std::move(_task), _race);
+    watcher.set_execution_ctx(execution_ctx);
+    _race->_waiting = handle;
+    _race->_timer_ref = _race;
+    // once armed the timer may resume us right away and take this awaiter with our frame, only locals from here on
+    _race->_timer.schedule(_race->_entry, _deadline);
+    watcher.execute_detached();
+}
+
+template <typename T>
+inline T Crotine::TimeoutRace<T>::Awaiter::await_resume()
+{
+    if (_race->_exception)
+    {
+        std::rethrow_exception(_race->_exception);
+    }
+    if constexpr (std::is_void_v<T>)
+    {
+        if (!_race->_value)
+        {
+            throw TimeoutError();
+        }
+    }
+    else
+    {
+        if (!_race->_value)
+        {
+            throw TimeoutError();
+        }
+        if constexpr (std::is_reference_v<T>)
+        {
+            return _race->_value->get();
+        }
+        else
+        {
+            return std::move(*_race->_value);
+        }
+    }
+}
+
+template <typename T, typename Rep, typename Period>
+inline auto Crotine::with_timeout(Task<T> task, std::chrono::duration<Rep, Period> duration, TimerWheel& timer) -> typename TimeoutRace<T>::Awaiter
+{
+    return { timer, std::move(task), TimerWheel::Clock::now() + std::chrono::duration_cast<TimerWheel::Clock::duration>(duration) };
+}
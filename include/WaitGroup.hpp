@@ -1,7 +1,11 @@
+#pragma once
 #include <mutex>
 #include <atomic>
+#include <coroutine>
 #include <condition_variable>
 
+#include "utils/AsyncWaiter.hpp"
+
 namespace Crotine
 {
     class WaitGroup
@@ -10,29 +14,115 @@ namespace Crotine
             std::atomic_uint _count = 0;
             std::mutex _mtx;
             std::condition_variable _cv;
+            // coroutines suspended in wait_async() as a lock-free stack, zero_tag() while the count is zero
+            std::atomic<void*> _async_waiters = zero_tag();
+        public:
+            class Awaiter
+            {
+                private:
+                    WaitGroup& _group;
+                    AsyncWaiter _waiter;
+                public:
+                    Awaiter(WaitGroup& group) : _group(group) {}
+                public:
+                    bool await_ready() const
+                    {
+                        if(_group.count() != 0)
+                        {
+                            return false;
+                        }
+                        _group.settled();
+                        return true;
+                    }
+                    bool await_suspend(std::coroutine_handle<> handle)
+                    {
+                        // once pushed the group may resume us and be gone, so it is not touched afterwards
+                        _waiter.handle = handle;
+                        if(push_waiter(_group._async_waiters, _waiter, _group.zero_tag()))
+                        {
+                            return true;
+                        }
+                        _group.settled();
+                        return false;
+                    }
+                    void await_resume() const noexcept {}
+            };
+        private:
+            void* zero_tag() noexcept
+            {
+                return this;
+            }
+            // the thread that brought the count to zero still holds the mutex until it is done with us,
+            // whoever saw zero without the mutex waits for that before it may destroy the group
+            void settled()
+            {
+                std::lock_guard<std::mutex> lock(_mtx);
+            }
+            // applies delta unless the count would reach or leave zero, those transitions go through the mutex
+            bool try_change(int delta)
+            {
+                auto current = _count.load();
+                while(current != 0 && current + delta != 0)
+                {
+                    if(_count.compare_exchange_weak(current, current + delta))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            // the count reaches zero under the mutex, so a wait() can not see it and destroy us before we are done here
+            void change(int delta)
+            {
+                if(try_change(delta))
+                {
+                    return;
+                }
+                void* woken = zero_tag();
+                {
+                    std::lock_guard<std::mutex> lock(_mtx);
+                    if(_count.fetch_add(delta) + delta == 0)
+                    {
+                        woken = _async_waiters.exchange(zero_tag());
+                        _cv.notify_all();
+                    }
+                    else
+                    {
+                        void* expected = zero_tag();
+                        _async_waiters.compare_exchange_strong(expected, nullptr);
+                    }
+                }
+                // a blocked wait() may already be destroying us, only the waiter nodes are touched from here
+                if(woken != zero_tag())
+                {
+                    resume_waiters(static_cast<AsyncWaiter*>(woken));
+                }
+            }
         public:
             WaitGroup() = default;
             ~WaitGroup() = default;
         public:
             void add(int delta)
             {
-                _count.fetch_add(delta);
+                change(delta);
             }
             void done()
             {
-                if(_count.fetch_sub(1) == 1)
-                {
-                    _cv.notify_all();
-                }
+                change(-1);
             }
             void wait()
             {
                 std::unique_lock<std::mutex> lock(_mtx);
                 _cv.wait(lock, [this]() { return _count.load() == 0; });
             }
+            // co_await group.wait_async() suspends the coroutine instead of blocking its thread
+            auto wait_async() -> Awaiter
+            {
+                return { *this };
+            }
             unsigned int count() const
             {
                 return _count.load();
             }
     };
-}
\ No newline at end of file
+}
@@ -1,57 +1,229 @@
 #pragma once
+#include <mutex>
+#include <span>
 #include <queue>
+#include <thread>
+#include <vector>
+#include <algorithm>
 #include "Executor.hpp"
 #include "AutoThread.hpp"
+#include "PriorityLanes.hpp"
 
 namespace Crotine
 {  
-    class Xecutor : public Executor
+    // Channel is the queue feeding the workers, any type with BlockChannel's put / try_take / close
+    // and optionally put_batch
+    // e.g. BasicXecutor<RingChannel<QueuedJob>> for the lock-free ring
+    // min_worker threads are started up front and never expire, the rest come and go with the load
+    // idle workers spin briefly, then sleep on their own futex, each job wakes at most one of them
+    // every Priority has its own Channel, see PriorityLanes for the order jobs are taken in
+    template<typename Channel = BlockChannel<QueuedJob>>
+    class BasicXecutor : public Executor
     {
         private:
             std::atomic_uint _idle_threads = 0;
+            // producers between publishing a job and their last look at the pool, the destructor waits for them
+            std::atomic_uint _submitting = 0;
         private:
             std::chrono::milliseconds _timeout;
         private:
             WaitGroup _wait_group;
         private:
-            BlockChannel<std::function<void()>> _tasks;
+            using Lanes = PriorityLanes<Channel>;
+        private:
+            Lanes _tasks;
         private:
             unsigned int _max_worker = 0;
+            unsigned int _min_worker = 0;
+        private:
+            IdleWorkers _idle;
+            [[no_unique_address]] ExecutorMetrics _metrics;
+        private:
+            // worker indices currently held by a live thread, reused once a thread expires
+            std::mutex _slot_mutex;
+            std::vector<bool> _slots;
+        private:
+            auto acquire_slot() -> std::size_t;
+            void release_slot(std::size_t index);
+            void spawn_worker(std::size_t index , bool persistent);
         public:
-            void execute(std::function<void()> func) override;
+            void execute(Job func) override;
+            void execute_with_priority(Job func , Priority priority) override;
+            void execute_batch(std::span<Job> jobs , Priority priority = Priority::Normal) override;
+            auto getWorkerCount() const noexcept -> std::size_t override;
+            // queue depth and throughput of one priority lane
+            auto getLaneStats(Priority priority) const -> LaneStats;
+            // per worker counters and latency histograms, gauges only without CROTINE_ENABLE_METRICS
+            auto getMetrics() const -> ExecutorMetricsSnapshot;
         public:
-            Xecutor(unsigned int max_worker = std::thread::hardware_concurrency() , std::chrono::milliseconds timeout = std::chrono::milliseconds(5000));
-            ~Xecutor();
+            BasicXecutor(unsigned int max_worker = std::thread::hardware_concurrency() , std::chrono::milliseconds timeout = std::chrono::milliseconds(5000) , unsigned int min_worker = 0);
+            ~BasicXecutor();
     };
 
-    Xecutor::Xecutor(unsigned int max_worker, std::chrono::milliseconds timeout) : _max_worker(max_worker) , _timeout(timeout) {}
+    using Xecutor = BasicXecutor<>;
+
+    template<typename Channel>
+    BasicXecutor<Channel>::BasicXecutor(unsigned int max_worker, std::chrono::milliseconds timeout, unsigned int min_worker)
+        : _timeout(timeout) , _max_worker(max_worker) , _min_worker(std::min(min_worker , max_worker)) , _idle(max_worker) , _metrics(max_worker) , _slots(max_worker , false)
+    {
+        for(unsigned int i = 0; i < _min_worker; ++i)
+        {
+            spawn_worker(acquire_slot() , true);
+        }
+    }
 
-    Xecutor::~Xecutor()
+    template<typename Channel>
+    BasicXecutor<Channel>::~BasicXecutor()
     {
+        // the job of a producer in flight may already have run and let our owner destroy us
+        while(_submitting.load() != 0)
+        {
+            std::this_thread::yield();
+        }
         _tasks.close();
+        _idle.close();
         _wait_group.wait();
     }
 
-    void Xecutor::execute(std::function<void()> func)
+    template<typename Channel>
+    void BasicXecutor<Channel>::execute(Job func)
+    {
+        execute_with_priority(std::move(func) , Priority::Normal);
+    }
+
+    template<typename Channel>
+    void BasicXecutor<Channel>::execute_with_priority(Job func , Priority priority)
     {
+        _submitting.fetch_add(1);
+        if(func)
+        {
+            _tasks.put(ExecutorMetrics::track_enqueue(std::move(func)) , priority);
+            _idle.notify();
+        }
+
         // if there is no active thread, create one
-        if((_idle_threads.load() == 0) && (_wait_group.count() < _max_worker))
+        // checked only after the job is visible, a worker expiring meanwhile either takes it or is not counted anymore
+        // a full pool is left to acquire_slot(), an expiring worker re-checks the lanes after it released its slot
+        if(_idle_threads.load() == 0)
+        {
+            if(auto index = acquire_slot(); index != NoWorker)
+            {
+                spawn_worker(index , false);
+            }
+        }
+        // last touch, the job may have finished and the pool may be gone right after
+        _submitting.fetch_sub(1);
+    }
+
+    template<typename Channel>
+    void BasicXecutor<Channel>::execute_batch(std::span<Job> jobs , Priority priority)
+    {
+        if(jobs.empty())
+        {
+            return;
+        }
+        auto count = jobs.size();
+        _submitting.fetch_add(1);
+        if constexpr (ExecutorMetrics::Enabled)
         {
-            _idle_threads.fetch_add(1);
-            _wait_group.add(1);
-            AutoThread(AutoThread::thread_context{_tasks , _timeout , [this]()
+            // one buffer for the whole batch, the stamps travel next to the jobs
+            std::vector<QueuedJob> queued;
+            queued.reserve(jobs.size());
+            for(auto& job : jobs)
             {
-                _idle_threads.fetch_sub(1);
-                _wait_group.done();
-            }});
+                queued.push_back(ExecutorMetrics::track_enqueue(std::move(job)));
+            }
+            _tasks.put_batch(queued , priority);
         }
+        else
+        {
+            _tasks.put_batch(jobs , priority);
+        }
+        _idle.notify(jobs.size());
 
-        _tasks.put([_task = func , this]()
+        // start threads only for the part of the batch the idle workers can not take, counted after the jobs are visible
+        for(auto idle = _idle_threads.load(); idle < count; ++idle)
         {
-            _idle_threads.fetch_sub(1);
-            if(_task)
-                _task();
-            _idle_threads.fetch_add(1);
-        });
+            auto index = acquire_slot();
+            if(index == NoWorker)
+            {
+                break;
+            }
+            spawn_worker(index , false);
+        }
+        _submitting.fetch_sub(1);
+    }
+
+    template<typename Channel>
+    void BasicXecutor<Channel>::spawn_worker(std::size_t index , bool persistent)
+    {
+        _idle_threads.fetch_add(1);
+        _wait_group.add(1);
+        _metrics.thread_created();
+        AutoThread<Lanes>(typename AutoThread<Lanes>::thread_context{_tasks , *this , index , _idle_threads , _idle , _metrics , persistent , _timeout , [this , index]()
+        {
+            if(!_idle.isClosed())
+            {
+                _metrics.thread_expired();
+            }
+            // the worker already took itself out of _idle_threads when its wait ended
+            release_slot(index);
+            // a producer that found every slot taken while we were expiring could not start a thread for its job
+            if(!_idle.isClosed() && _idle_threads.load() == 0 && !_tasks.empty())
+            {
+                if(auto replacement = acquire_slot(); replacement != NoWorker)
+                {
+                    spawn_worker(replacement , false);
+                }
+            }
+            _wait_group.done();
+        }});
+    }
+
+    template<typename Channel>
+    auto BasicXecutor<Channel>::getWorkerCount() const noexcept -> std::size_t
+    {
+        return _max_worker;
+    }
+
+    template<typename Channel>
+    auto BasicXecutor<Channel>::getLaneStats(Priority priority) const -> LaneStats
+    {
+        return _tasks.stats(priority);
+    }
+
+    template<typename Channel>
+    auto BasicXecutor<Channel>::getMetrics() const -> ExecutorMetricsSnapshot
+    {
+        auto snapshot = _metrics.snapshot();
+        for(std::size_t lane = 0; lane < PriorityCount; ++lane)
+        {
+            snapshot.queue_depth += _tasks.stats(static_cast<Priority>(lane)).depth;
+        }
+        snapshot.live_threads = _wait_group.count();
+        snapshot.idle_threads = _idle_threads.load();
+        return snapshot;
+    }
+
+    template<typename Channel>
+    auto BasicXecutor<Channel>::acquire_slot() -> std::size_t
+    {
+        std::lock_guard<std::mutex> lock(_slot_mutex);
+        for(std::size_t i = 0; i < _slots.size(); ++i)
+        {
+            if(!_slots[i])
+            {
+                _slots[i] = true;
+                return i;
+            }
+        }
+        return NoWorker;
+    }
+
+    template<typename Channel>
+    void BasicXecutor<Channel>::release_slot(std::size_t index)
+    {
+        std::lock_guard<std::mutex> lock(_slot_mutex);
+        _slots[index] = false;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+
+#include "../PromiseBase.hpp"
+
+namespace Crotine
+{
+    // intrusive node of the lock-free waiter stacks used by the async synchronization primitives
+    // lives in the awaiter of the suspended coroutine, so waiting never allocates
+    struct AsyncWaiter
+    {
+        AsyncWaiter* next = nullptr;
+        std::coroutine_handle<> handle = nullptr;
+    };
+
+    // pushes onto a waiter stack, fails once the stack holds closed_tag (pass nullptr for stacks that never close)
+    inline bool push_waiter(std::atomic<void*>& stack, AsyncWaiter& waiter, void* closed_tag = nullptr) noexcept
+    {
+        auto head = stack.load(std::memory_order_acquire);
+        do
+        {
+            if (closed_tag && head == closed_tag)
+            {
+                return false;
+            }
+            waiter.next = static_cast<AsyncWaiter*>(head);
+        } while (!stack.compare_exchange_weak(head, &waiter, std::memory_order_acq_rel, std::memory_order_acquire));
+        return true;
+    }
+
+    // turns a stack taken off a waiter list into registration order
+    inline AsyncWaiter* reverse_waiters(AsyncWaiter* stack) noexcept
+    {
+        AsyncWaiter* reversed = nullptr;
+        while (stack)
+        {
+            auto* next = stack->next;
+            stack->next = reversed;
+            reversed = stack;
+            stack = next;
+        }
+        return reversed;
+    }
+
+    // resumes every waiter of a stack in registration order, each on its own execution context
+    inline void resume_waiters(AsyncWaiter* stack)
+    {
+        auto* waiter = reverse_waiters(stack);
+        while (waiter)
+        {
+            // the node is gone as soon as its coroutine resumes
+            auto* next = waiter->next;
+            PromiseBase::resume_on_ctx(waiter->handle);
+            waiter = next;
+        }
+    }
+}
@@ -1,7 +1,15 @@
 #pragma once
+#include <optional>
+#include <coroutine>
+#include <stdexcept>
+#include <functional>
+
+#include "../PromiseBase.hpp"
 
 namespace Crotine
 {
+    // reads the execution context of the awaiting coroutine
+    // await_suspend only peeks at the promise and declines to suspend, so nothing is rescheduled
     class get_Execution_Context
     {
         private:
@@ -11,14 +19,10 @@ namespace Crotine
             {
                 return _execution_context.has_value();
             }
-            void await_suspend(std::coroutine_handle<> handle)
+            bool await_suspend(std::coroutine_handle<> handle) noexcept
             {
-                 auto typed_handle = std::coroutine_handle<PromiseBase>::from_address(handle.address());
-                _execution_context = typed_handle.promise().get_execution_ctx();
-                _execution_context->get().execute([handle]()
-                {
-                    handle.resume();
-                });
+                _execution_context = PromiseBase::execution_ctx_of(handle);
+                return false;
             }
             auto await_resume() -> Executor&
             {
@@ -29,4 +33,4 @@ namespace Crotine
                 return _execution_context->get();
             }
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,190 @@
+#pragma once
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <cstddef>
+#include <algorithm>
+
+namespace Crotine
+{
+    // per thread size class free lists for coroutine frames
+    // a frame freed on another thread simply lands in that thread's cache
+    // frames allocated or freed after the cache of the thread is gone (thread_local destructors) bypass it
+    class FramePool
+    {
+        public:
+            struct Stats
+            {
+                std::size_t hits = 0;
+                std::size_t misses = 0;
+                std::size_t bytes_cached = 0;
+            };
+        public:
+            static constexpr std::size_t Granularity = 64;
+            static constexpr std::size_t ClassCount = 16;
+            static constexpr std::size_t MaxCachedPerClass = 256;
+            // every block comes from ::operator new of a multiple of Granularity, which is aligned like any frame
+            static_assert(Granularity % alignof(std::max_align_t) == 0 && __STDCPP_DEFAULT_NEW_ALIGNMENT__ >= alignof(std::max_align_t));
+        private:
+            struct Block
+            {
+                Block* next;
+            };
+            struct ThreadCache;
+            struct Registry
+            {
+                std::mutex mutex;
+                std::vector<ThreadCache*> caches;
+                // stats of threads that already exited
+                Stats retired;
+            };
+            struct ThreadCache
+            {
+                Block* blocks[ClassCount] = {};
+                std::size_t counts[ClassCount] = {};
+                // written by the owning thread only, atomics so that stats() may read them
+                std::atomic_size_t hits = 0;
+                std::atomic_size_t misses = 0;
+                std::atomic_size_t bytes_cached = 0;
+                public:
+                    ThreadCache();
+                    ~ThreadCache();
+            };
+        private:
+            // trivially destructible, so it can still be read while the cache itself is destroyed
+            inline static thread_local bool _cache_destroyed = false;
+        private:
+            static auto registry() -> Registry&;
+            // nullptr once the cache of this thread has been destroyed
+            static auto local() -> ThreadCache*;
+            static void add(std::atomic_size_t& counter, std::size_t delta) noexcept;
+            static void sub(std::atomic_size_t& counter, std::size_t delta) noexcept;
+        public:
+            static auto allocate(std::size_t size) -> void*;
+            static void deallocate(void* ptr, std::size_t size) noexcept;
+        public:
+            // summed over every thread that ever used the pool
+            static auto stats() -> Stats;
+    };
+}
+
+inline Crotine::FramePool::Registry& Crotine::FramePool::registry()
+{
+    // never destroyed, detached workers may still release frames after main returns
+    static auto* instance = new Registry;
+    return *instance;
+}
+
+inline Crotine::FramePool::ThreadCache* Crotine::FramePool::local()
+{
+    if (_cache_destroyed)
+    {
+        return nullptr;
+    }
+    thread_local ThreadCache cache;
+    return &cache;
+}
+
+inline void Crotine::FramePool::add(std::atomic_size_t& counter, std::size_t delta) noexcept
+{
+    // single writer, so a plain load / store pair is enough and avoids a locked instruction
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+inline void Crotine::FramePool::sub(std::atomic_size_t& counter, std::size_t delta) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) - delta, std::memory_order_relaxed);
+}
+
+inline Crotine::FramePool::ThreadCache::ThreadCache()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.caches.push_back(this);
+}
+
+inline Crotine::FramePool::ThreadCache::~ThreadCache()
+{
+    _cache_destroyed = true;
+    for (auto& block : blocks)
+    {
+        while (block)
+        {
+            ::operator delete(std::exchange(block, block->next));
+        }
+    }
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.retired.hits += hits.load(std::memory_order_relaxed);
+    reg.retired.misses += misses.load(std::memory_order_relaxed);
+    reg.caches.erase(std::find(reg.caches.begin(), reg.caches.end(), this));
+}
+
+inline void* Crotine::FramePool::allocate(std::size_t size)
+{
+    auto index = (size + Granularity - 1) / Granularity - 1;
+    auto* cache = local();
+    if (index >= ClassCount)
+    {
+        if (cache)
+        {
+            add(cache->misses, 1);
+        }
+        return ::operator new(size);
+    }
+    if (!cache)
+    {
+        // full class size, another thread's cache may still take the block in
+        return ::operator new((index + 1) * Granularity);
+    }
+    if (auto* block = cache->blocks[index]; block)
+    {
+        assert(reinterpret_cast<std::uintptr_t>(block) % alignof(std::max_align_t) == 0);
+        cache->blocks[index] = block->next;
+        --cache->counts[index];
+        add(cache->hits, 1);
+        sub(cache->bytes_cached, (index + 1) * Granularity);
+        return block;
+    }
+    add(cache->misses, 1);
+    return ::operator new((index + 1) * Granularity);
+}
+
+inline void Crotine::FramePool::deallocate(void* ptr, std::size_t size) noexcept
+{
+    auto index = (size + Granularity - 1) / Granularity - 1;
+    if (index >= ClassCount)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+    auto* cache = local();
+    if (!cache || cache->counts[index] >= MaxCachedPerClass)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+    auto* block = static_cast<Block*>(ptr);
+    block->next = cache->blocks[index];
+    cache->blocks[index] = block;
+    ++cache->counts[index];
+    add(cache->bytes_cached, (index + 1) * Granularity);
+}
+
+inline Crotine::FramePool::Stats Crotine::FramePool::stats()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto total = reg.retired;
+    for (auto* cache : reg.caches)
+    {
+        total.hits += cache->hits.load(std::memory_order_relaxed);
+        total.misses += cache->misses.load(std::memory_order_relaxed);
+        total.bytes_cached += cache->bytes_cached.load(std::memory_order_relaxed);
+    }
+    return total;
+}
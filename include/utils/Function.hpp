@@ -1,4 +1,6 @@
 #pragma once
+#include <vector>
+#include <ranges>
 #include <concepts>
 #include <type_traits>
 
@@ -62,4 +64,55 @@ namespace Crotine
         task.execute_async();
         return task;
     }
-}
\ No newline at end of file
+
+    // like CreateTask, but the callable is moved into the coroutine frame instead of being referenced
+    template<typename Function>
+    requires NonCoroutineFunctionT<Function&>
+    inline auto CreateOwningTask(Function func) -> Task<std::invoke_result_t<Function&>>
+    {
+        co_return std::invoke(func);
+    }
+
+    // one task per callable of the range, all started through a single execute_batch on ctx
+    // plain callables are copied into their task, coroutine callables are invoked right away
+    template<std::ranges::input_range Range>
+    requires CoroutineFunctionT<std::ranges::range_reference_t<Range>> || NonCoroutineFunctionT<std::ranges::range_reference_t<Range>>
+    inline auto RunTasks(Executor& ctx, Range&& functions)
+    {
+        using Function = std::ranges::range_reference_t<Range>;
+        auto create = [](Function func)
+        {
+            if constexpr (CoroutineFunctionT<Function>)
+            {
+                return CreateTask(std::forward<Function>(func));
+            }
+            else
+            {
+                return CreateOwningTask(std::remove_cvref_t<Function>(std::forward<Function>(func)));
+            }
+        };
+        std::vector<decltype(create(std::declval<Function>()))> tasks;
+        std::vector<Job> jobs;
+        if constexpr (std::ranges::sized_range<Range>)
+        {
+            tasks.reserve(std::ranges::size(functions));
+            jobs.reserve(std::ranges::size(functions));
+        }
+        for(auto&& func : functions)
+        {
+            auto task = create(std::forward<decltype(func)>(func));
+            task.set_execution_ctx(ctx);
+            jobs.push_back(task.start_job());
+            tasks.push_back(std::move(task));
+        }
+        ctx.execute_batch(jobs);
+        return tasks;
+    }
+
+    template<std::ranges::input_range Range>
+    requires CoroutineFunctionT<std::ranges::range_reference_t<Range>> || NonCoroutineFunctionT<std::ranges::range_reference_t<Range>>
+    inline auto RunTasks(Range&& functions)
+    {
+        return RunTasks(Executor::getDefaultExecutor(), std::forward<Range>(functions));
+    }
+}
@@ -0,0 +1,359 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "../Executor.hpp"
+
+namespace Crotine
+{
+    // log2 bucketed nanosecond histogram, bucket i counts samples in [2^(i-1), 2^i) ns
+    struct Histogram
+    {
+        static constexpr std::size_t Buckets = 48;
+        std::array<std::uint64_t, Buckets> buckets = {};
+        std::uint64_t count = 0;
+        std::uint64_t total_ns = 0;
+        public:
+            // upper bound of the bucket holding the given quantile, 0 without samples
+            auto percentile(double quantile) const -> std::chrono::nanoseconds;
+            auto mean() const -> std::chrono::nanoseconds;
+            void merge(const Histogram& other);
+    };
+
+    struct WorkerMetrics
+    {
+        std::uint64_t tasks_executed = 0;
+        // jobs taken from another worker's deque (StealingXecutor)
+        std::uint64_t steals = 0;
+        // times the worker ran out of work and went to sleep
+        std::uint64_t parks = 0;
+        // enqueue-to-start latency and run time of the jobs this worker ran
+        Histogram queue_wait;
+        Histogram run_time;
+    };
+
+    struct ExecutorMetricsSnapshot
+    {
+        // false when built without CROTINE_ENABLE_METRICS, only the gauges are filled in then
+        bool enabled = false;
+        // gauges, read at snapshot time
+        std::size_t queue_depth = 0;
+        std::size_t live_threads = 0;
+        std::size_t idle_threads = 0;
+        // counters since the executor was created
+        std::uint64_t threads_created = 0;
+        std::uint64_t threads_expired = 0;
+        std::vector<WorkerMetrics> workers;
+        public:
+            // every worker summed up
+            auto total() const -> WorkerMetrics;
+    };
+
+#if defined(CROTINE_ENABLE_METRICS)
+    // a job sitting in an executor's queue next to the time it went in, runs like the job itself
+    struct QueuedJob
+    {
+        Job job;
+        std::chrono::steady_clock::time_point enqueued;
+        public:
+            void operator()() const;
+    };
+#else
+    // without metrics there is nothing to carry along
+    using QueuedJob = Job;
+#endif
+
+    // opt-in instrumentation of an executor's workers, define CROTINE_ENABLE_METRICS to turn it on
+    // every worker thread writes its own cache line sized block through a thread_local pointer, single writer
+    // relaxed stores so recording never contends; snapshot() reads all blocks
+    // without the define every member is an empty inline function and the class holds no data
+    class ExecutorMetrics
+    {
+#if defined(CROTINE_ENABLE_METRICS)
+        private:
+            using Clock = std::chrono::steady_clock;
+            struct AtomicHistogram
+            {
+                std::array<std::atomic_uint64_t, Histogram::Buckets> buckets = {};
+                std::atomic_uint64_t count = 0;
+                std::atomic_uint64_t total_ns = 0;
+                public:
+                    void record(std::chrono::nanoseconds elapsed) noexcept;
+                    auto load() const -> Histogram;
+            };
+            struct alignas(64) Counters
+            {
+                std::atomic_uint64_t tasks_executed = 0;
+                std::atomic_uint64_t steals = 0;
+                std::atomic_uint64_t parks = 0;
+                AtomicHistogram queue_wait;
+                AtomicHistogram run_time;
+            };
+        private:
+            inline static thread_local Counters* _current = nullptr;
+        private:
+            std::size_t _worker_count;
+            std::unique_ptr<Counters[]> _workers;
+            std::atomic_uint64_t _threads_created = 0;
+            std::atomic_uint64_t _threads_expired = 0;
+        private:
+            static void bump(std::atomic_uint64_t& counter) noexcept;
+        public:
+            static constexpr bool Enabled = true;
+            using Stamp = Clock::time_point;
+#else
+        public:
+            static constexpr bool Enabled = false;
+            struct Stamp {};
+#endif
+        public:
+            // binds the calling worker thread to its block until it goes out of scope
+            class Binding
+            {
+#if defined(CROTINE_ENABLE_METRICS)
+                private:
+                    Counters* _previous;
+#endif
+                public:
+                    Binding(ExecutorMetrics& metrics, std::size_t worker_index) noexcept;
+                    Binding(const Binding&) = delete;
+                    ~Binding();
+            };
+        public:
+            explicit ExecutorMetrics(std::size_t worker_count);
+            ExecutorMetrics(const ExecutorMetrics&) = delete;
+            ~ExecutorMetrics() = default;
+        public:
+            void thread_created() noexcept;
+            void thread_expired() noexcept;
+            auto snapshot() const -> ExecutorMetricsSnapshot;
+        public:
+            // stamps a job on its way into a queue, job_started records how long it waited there
+#if defined(CROTINE_ENABLE_METRICS)
+            static auto track_enqueue(Job&& job) noexcept -> QueuedJob;
+#else
+            static auto track_enqueue(Job&& job) noexcept -> Job&&;
+#endif
+            static auto job_started(const QueuedJob& job) noexcept -> Stamp;
+            static void job_finished(Stamp started) noexcept;
+            static void parked() noexcept;
+            static void stolen() noexcept;
+    };
+}
+
+inline std::chrono::nanoseconds Crotine::Histogram::percentile(double quantile) const
+{
+    if (count == 0)
+    {
+        return std::chrono::nanoseconds::zero();
+    }
+    auto rank = static_cast<std::uint64_t>(quantile * static_cast<double>(count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < Buckets; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            return std::chrono::nanoseconds(std::int64_t{1} << i);
+        }
+    }
+    return std::chrono::nanoseconds(std::int64_t{1} << (Buckets - 1));
+}
+
+inline std::chrono::nanoseconds Crotine::Histogram::mean() const
+{
+    return std::chrono::nanoseconds(count ? static_cast<std::int64_t>(total_ns / count) : 0);
+}
+
+inline void Crotine::Histogram::merge(const Histogram& other)
+{
+    for (std::size_t i = 0; i < Buckets; ++i)
+    {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    total_ns += other.total_ns;
+}
+
+inline Crotine::WorkerMetrics Crotine::ExecutorMetricsSnapshot::total() const
+{
+    WorkerMetrics sum;
+    for (auto& worker : workers)
+    {
+        sum.tasks_executed += worker.tasks_executed;
+        sum.steals += worker.steals;
+        sum.parks += worker.parks;
+        sum.queue_wait.merge(worker.queue_wait);
+        sum.run_time.merge(worker.run_time);
+    }
+    return sum;
+}
+
+#if defined(CROTINE_ENABLE_METRICS)
+
+inline void Crotine::ExecutorMetrics::bump(std::atomic_uint64_t& counter) noexcept
+{
+    // only the owning worker writes, a plain load and store is enough
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+inline void Crotine::ExecutorMetrics::AtomicHistogram::record(std::chrono::nanoseconds elapsed) noexcept
+{
+    auto ns = static_cast<std::uint64_t>(elapsed.count() > 0 ? elapsed.count() : 0);
+    auto bucket = std::min<std::size_t>(std::bit_width(ns), Histogram::Buckets - 1);
+    bump(buckets[bucket]);
+    bump(count);
+    total_ns.store(total_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+}
+
+inline Crotine::Histogram Crotine::ExecutorMetrics::AtomicHistogram::load() const
+{
+    Histogram histogram;
+    for (std::size_t i = 0; i < Histogram::Buckets; ++i)
+    {
+        histogram.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+    histogram.count = count.load(std::memory_order_relaxed);
+    histogram.total_ns = total_ns.load(std::memory_order_relaxed);
+    return histogram;
+}
+
+inline Crotine::ExecutorMetrics::ExecutorMetrics(std::size_t worker_count)
+    : _worker_count(worker_count), _workers(std::make_unique<Counters[]>(worker_count))
+{}
+
+inline Crotine::ExecutorMetrics::Binding::Binding(ExecutorMetrics& metrics, std::size_t worker_index) noexcept
+    : _previous(std::exchange(_current, worker_index < metrics._worker_count ? &metrics._workers[worker_index] : nullptr))
+{}
+
+inline Crotine::ExecutorMetrics::Binding::~Binding()
+{
+    _current = _previous;
+}
+
+inline void Crotine::ExecutorMetrics::thread_created() noexcept
+{
+    _threads_created.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void Crotine::ExecutorMetrics::thread_expired() noexcept
+{
+    _threads_expired.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline Crotine::ExecutorMetricsSnapshot Crotine::ExecutorMetrics::snapshot() const
+{
+    ExecutorMetricsSnapshot snapshot;
+    snapshot.enabled = true;
+    snapshot.threads_created = _threads_created.load(std::memory_order_relaxed);
+    snapshot.threads_expired = _threads_expired.load(std::memory_order_relaxed);
+    snapshot.workers.resize(_worker_count);
+    for (std::size_t i = 0; i < _worker_count; ++i)
+    {
+        auto& source = _workers[i];
+        auto& worker = snapshot.workers[i];
+        worker.tasks_executed = source.tasks_executed.load(std::memory_order_relaxed);
+        worker.steals = source.steals.load(std::memory_order_relaxed);
+        worker.parks = source.parks.load(std::memory_order_relaxed);
+        worker.queue_wait = source.queue_wait.load();
+        worker.run_time = source.run_time.load();
+    }
+    return snapshot;
+}
+
+inline void Crotine::QueuedJob::operator()() const
+{
+    job();
+}
+
+inline Crotine::QueuedJob Crotine::ExecutorMetrics::track_enqueue(Job&& job) noexcept
+{
+    return {std::move(job), Clock::now()};
+}
+
+inline Crotine::ExecutorMetrics::Stamp Crotine::ExecutorMetrics::job_started(const QueuedJob& job) noexcept
+{
+    if (!_current)
+    {
+        return {};
+    }
+    auto now = Clock::now();
+    _current->queue_wait.record(now - job.enqueued);
+    return now;
+}
+
+inline void Crotine::ExecutorMetrics::job_finished(Stamp started) noexcept
+{
+    if (_current)
+    {
+        _current->run_time.record(Clock::now() - started);
+        bump(_current->tasks_executed);
+    }
+}
+
+inline void Crotine::ExecutorMetrics::parked() noexcept
+{
+    if (_current)
+    {
+        bump(_current->parks);
+    }
+}
+
+inline void Crotine::ExecutorMetrics::stolen() noexcept
+{
+    if (_current)
+    {
+        bump(_current->steals);
+    }
+}
+
+#else
+
+inline Crotine::ExecutorMetrics::Binding::Binding(ExecutorMetrics&, std::size_t) noexcept
+{}
+
+inline Crotine::ExecutorMetrics::Binding::~Binding()
+{}
+
+inline Crotine::ExecutorMetrics::ExecutorMetrics(std::size_t)
+{}
+
+inline void Crotine::ExecutorMetrics::thread_created() noexcept
+{}
+
+inline void Crotine::ExecutorMetrics::thread_expired() noexcept
+{}
+
+inline Crotine::ExecutorMetricsSnapshot Crotine::ExecutorMetrics::snapshot() const
+{
+    return {};
+}
+
+inline Crotine::Job&& Crotine::ExecutorMetrics::track_enqueue(Job&& job) noexcept
+{
+    return std::move(job);
+}
+
+inline Crotine::ExecutorMetrics::Stamp Crotine::ExecutorMetrics::job_started(const QueuedJob&) noexcept
+{
+    return {};
+}
+
+inline void Crotine::ExecutorMetrics::job_finished(Stamp) noexcept
+{}
+
+inline void Crotine::ExecutorMetrics::parked() noexcept
+{}
+
+inline void Crotine::ExecutorMetrics::stolen() noexcept
+{}
+
+#endif
@@ -0,0 +1,118 @@
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+
+#if defined(__linux__)
+#include <ctime>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace Crotine
+{
+    // wake-up token for exactly one thread: prepare(), publish that you sleep, then park()
+    // an unpark() that lands anywhere after prepare() is never lost, the park simply returns
+    // sleeps on a futex on linux, so waking a particular thread costs one syscall and no lock
+    class Parker
+    {
+        private:
+            static constexpr std::uint32_t Empty = 0;
+            static constexpr std::uint32_t Notified = 1;
+        private:
+            std::atomic_uint32_t _state = Empty;
+#if !defined(__linux__)
+            std::mutex _mutex;
+            std::condition_variable _notifier;
+#endif
+        private:
+            bool sleep(const std::chrono::nanoseconds* timeout);
+        public:
+            Parker() = default;
+            Parker(const Parker&) = delete;
+            ~Parker() = default;
+        public:
+            void prepare() noexcept;
+            // true once unparked, false if the token is still empty when the timeout runs out
+            bool park();
+            bool park_for(std::chrono::nanoseconds timeout);
+            void unpark();
+    };
+}
+
+inline void Crotine::Parker::prepare() noexcept
+{
+    _state.store(Empty);
+}
+
+inline bool Crotine::Parker::park()
+{
+    return sleep(nullptr);
+}
+
+inline bool Crotine::Parker::park_for(std::chrono::nanoseconds timeout)
+{
+    return sleep(&timeout);
+}
+
+#if defined(__linux__)
+
+inline bool Crotine::Parker::sleep(const std::chrono::nanoseconds* timeout)
+{
+    static_assert(sizeof(std::atomic_uint32_t) == sizeof(std::uint32_t), "futex needs a plain 32 bit word");
+    auto deadline = std::chrono::steady_clock::now() + (timeout ? *timeout : std::chrono::nanoseconds::zero());
+    while(_state.load() == Empty)
+    {
+        timespec relative{};
+        if(timeout)
+        {
+            auto left = deadline - std::chrono::steady_clock::now();
+            if(left <= std::chrono::nanoseconds::zero())
+            {
+                break;
+            }
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(left);
+            relative.tv_sec = static_cast<time_t>(seconds.count());
+            relative.tv_nsec = static_cast<long>((left - seconds).count());
+        }
+        // returns right away if an unpark already changed the word, spurious returns loop around
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&_state), FUTEX_WAIT_PRIVATE, Empty, timeout ? &relative : nullptr, nullptr, 0);
+    }
+    return _state.load() == Notified;
+}
+
+inline void Crotine::Parker::unpark()
+{
+    if(_state.exchange(Notified) == Empty)
+    {
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&_state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+}
+
+#else
+
+inline bool Crotine::Parker::sleep(const std::chrono::nanoseconds* timeout)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto notified = [this] { return _state.load() == Notified; };
+    if(timeout)
+    {
+        return _notifier.wait_for(lock, *timeout, notified);
+    }
+    _notifier.wait(lock, notified);
+    return true;
+}
+
+inline void Crotine::Parker::unpark()
+{
+    if(_state.exchange(Notified) == Empty)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _notifier.notify_one();
+    }
+}
+
+#endif
@@ -0,0 +1,142 @@
+#pragma once
+#include <new>
+#include <memory>
+#include <cstddef>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+namespace Crotine
+{
+    template <typename Signature, std::size_t Capacity = 48>
+    class UniqueFunction;
+
+    // move only replacement for std::function
+    // callables up to Capacity bytes (a coroutine handle plus a few pointers) are stored inline,
+    // only bigger ones fall back to the heap
+    template <typename R, typename... Args, std::size_t Capacity>
+    class UniqueFunction<R(Args...), Capacity>
+    {
+        private:
+            struct VTable
+            {
+                R (*invoke)(void* storage, Args&&... args);
+                void (*move)(void* destination, void* source) noexcept;
+                void (*destroy)(void* storage) noexcept;
+            };
+        private:
+            template <typename F>
+            static constexpr bool StoredInline = sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+            template <typename F>
+            static constexpr VTable InlineTable =
+            {
+                [](void* storage, Args&&... args) -> R { return std::invoke(*static_cast<F*>(storage), std::forward<Args>(args)...); },
+                [](void* destination, void* source) noexcept
+                {
+                    ::new (destination) F(std::move(*static_cast<F*>(source)));
+                    static_cast<F*>(source)->~F();
+                },
+                [](void* storage) noexcept { static_cast<F*>(storage)->~F(); }
+            };
+            template <typename F>
+            static constexpr VTable HeapTable =
+            {
+                [](void* storage, Args&&... args) -> R { return std::invoke(**static_cast<F**>(storage), std::forward<Args>(args)...); },
+                [](void* destination, void* source) noexcept { ::new (destination) F*(*static_cast<F**>(source)); },
+                [](void* storage) noexcept { delete *static_cast<F**>(storage); }
+            };
+        private:
+            alignas(std::max_align_t) mutable unsigned char _storage[Capacity];
+            const VTable* _vtable = nullptr;
+        private:
+            void reset() noexcept;
+        public:
+            UniqueFunction() noexcept = default;
+            UniqueFunction(std::nullptr_t) noexcept {}
+            template <typename F>
+            requires (!std::is_same_v<std::remove_cvref_t<F>, UniqueFunction>) && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>
+            UniqueFunction(F&& func);
+            UniqueFunction(const UniqueFunction&) = delete;
+            UniqueFunction(UniqueFunction&& other) noexcept;
+            ~UniqueFunction();
+        public:
+            UniqueFunction& operator=(const UniqueFunction&) = delete;
+            UniqueFunction& operator=(UniqueFunction&& other) noexcept;
+        public:
+            explicit operator bool() const noexcept;
+            R operator()(Args... args) const;
+    };
+}
+
+template <typename R, typename... Args, std::size_t Capacity>
+template <typename F>
+requires (!std::is_same_v<std::remove_cvref_t<F>, Crotine::UniqueFunction<R(Args...), Capacity>>) && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>
+inline Crotine::UniqueFunction<R(Args...), Capacity>::UniqueFunction(F&& func)
+{
+    using Stored = std::decay_t<F>;
+    if constexpr (StoredInline<Stored>)
+    {
+        ::new (static_cast<void*>(_storage)) Stored(std::forward<F>(func));
+        _vtable = &InlineTable<Stored>;
+    }
+    else
+    {
+        ::new (static_cast<void*>(_storage)) Stored*(new Stored(std::forward<F>(func)));
+        _vtable = &HeapTable<Stored>;
+    }
+}
+
+template <typename R, typename... Args, std::size_t Capacity>
+inline Crotine::UniqueFunction<R(Args...), Capacity>::UniqueFunction(UniqueFunction&& other) noexcept : _vtable(std::exchange(other._vtable, nullptr))
+{
+    if (_vtable)
+    {
+        _vtable->move(_storage, other._storage);
+    }
+}
+
+template <typename R, typename... Args, std::size_t Capacity>
+inline Crotine::UniqueFunction<R(Args...), Capacity>::~UniqueFunction()
+{
+    reset();
+}
+
+template <typename R, typename... Args, std::size_t Capacity>
+inline void Crotine::UniqueFunction<R(Args...), Capacity>::reset() noexcept
+{
+    if (_vtable)
+    {
+        std::exchange(_vtable, nullptr)->destroy(_storage);
+    }
+}
+
+template <typename R, typename... Args, std::size_t Capacity>
+inline Crotine::UniqueFunction<R(Args...), Capacity>& Crotine::UniqueFunction<R(Args...), Capacity>::operator=(UniqueFunction&& other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        _vtable = std::exchange(other._vtable, nullptr);
+        if (_vtable)
+        {
+            _vtable->move(_storage, other._storage);
+        }
+    }
+    return *this;
+}
+
+template <typename R, typename... Args, std::size_t Capacity>
+inline Crotine::UniqueFunction<R(Args...), Capacity>::operator bool() const noexcept
+{
+    return _vtable != nullptr;
+}
+
+template <typename R, typename... Args, std::size_t Capacity>
+inline R Crotine::UniqueFunction<R(Args...), Capacity>::operator()(Args... args) const
+{
+    if (!_vtable)
+    {
+        throw std::bad_function_call();
+    }
+    return _vtable->invoke(_storage, std::forward<Args>(args)...);
+}
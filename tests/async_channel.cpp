@@ -0,0 +1,227 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/TimerWheel.hpp"
+#include "../include/Combinators.hpp"
+#include "../include/AsyncChannel.hpp"
+#include "../include/utils/Context.hpp"
+
+using namespace std::chrono_literals;
+
+Crotine::Task<void> produce(Crotine::AsyncChannel<int>& out, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        co_await out.send(i);
+    }
+    out.close();
+}
+
+Crotine::Task<void> square_stage(Crotine::AsyncChannel<int>& in, Crotine::AsyncChannel<long long>& out)
+{
+    while (auto value = co_await in.receive())
+    {
+        co_await out.send(static_cast<long long>(*value) * *value);
+    }
+    out.close();
+}
+
+Crotine::Task<long long> consume(Crotine::AsyncChannel<long long>& in)
+{
+    long long sum = 0;
+    while (auto value = co_await in.receive())
+    {
+        sum += *value;
+    }
+    co_return sum;
+}
+
+Crotine::Task<long long> pipeline(std::size_t capacity, int count)
+{
+    Crotine::AsyncChannel<int> numbers(capacity);
+    Crotine::AsyncChannel<long long> squares(capacity);
+    auto [produced, squared, sum] = co_await Crotine::when_all(produce(numbers, count), square_stage(numbers, squares), consume(squares));
+    co_return sum;
+}
+
+Crotine::Task<long long> fan_in(int producers, int per_producer)
+{
+    Crotine::AsyncChannel<long long> channel(8);
+    std::vector<Crotine::Task<long long>> consumers;
+    for (int i = 0; i < 4; ++i)
+    {
+        consumers.push_back(consume(channel));
+    }
+    // consumers run alongside, they stop once the producers are all done and the channel is closed
+    auto draining = [](std::vector<Crotine::Task<long long>> consumers) -> Crotine::Task<long long>
+    {
+        long long total = 0;
+        for (auto sum : co_await Crotine::when_all(std::move(consumers)))
+        {
+            total += sum;
+        }
+        co_return total;
+    }(std::move(consumers));
+    auto& pool = co_await Crotine::get_Execution_Context{};
+    draining.set_execution_ctx(pool);
+    draining.execute_async();
+
+    std::vector<Crotine::Task<void>> senders;
+    for (int p = 0; p < producers; ++p)
+    {
+        senders.push_back([](Crotine::AsyncChannel<long long>& out, int p, int count) -> Crotine::Task<void>
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                co_await out.send(static_cast<long long>(p) * count + i);
+            }
+        }(channel, p, per_producer));
+    }
+    co_await Crotine::when_all(std::move(senders));
+    channel.close();
+    co_return co_await draining;
+}
+
+// how far below the first stage the deepest one ran, a handed over value must not nest the stages on one stack
+struct StackProbe
+{
+    std::uintptr_t top = 0;
+    std::uintptr_t lowest = 0;
+    void mark()
+    {
+        char local = 0;
+        auto address = reinterpret_cast<std::uintptr_t>(&local);
+        top = top ? top : address;
+        lowest = lowest ? std::min(lowest, address) : address;
+    }
+    auto depth() const -> std::uintptr_t
+    {
+        return top > lowest ? top - lowest : 0;
+    }
+};
+
+Crotine::Task<void> relay(Crotine::AsyncChannel<int>& in, Crotine::AsyncChannel<int>& out, StackProbe& probe)
+{
+    while (auto value = co_await in.receive())
+    {
+        probe.mark();
+        co_await out.send(*value + 1);
+    }
+    out.close();
+}
+
+Crotine::Task<int> relay_chain(int stages, int values, StackProbe& probe)
+{
+    std::vector<std::unique_ptr<Crotine::AsyncChannel<int>>> channels;
+    for (int i = 0; i <= stages; ++i)
+    {
+        channels.push_back(std::make_unique<Crotine::AsyncChannel<int>>(0));
+    }
+    std::vector<Crotine::Task<void>> relays;
+    for (int i = 0; i < stages; ++i)
+    {
+        relays.push_back(relay(*channels[i], *channels[i + 1], probe));
+    }
+    relays.push_back(produce(*channels.front(), values));
+    int total = 0;
+    relays.push_back([](Crotine::AsyncChannel<int>& in, int& total) -> Crotine::Task<void>
+    {
+        while (auto value = co_await in.receive())
+        {
+            total += *value;
+        }
+    }(*channels.back(), total));
+    co_await Crotine::when_all(std::move(relays));
+    co_return total;
+}
+
+template <typename T>
+T run_on(Crotine::Executor& executor, Crotine::Task<T> task)
+{
+    task.set_execution_ctx(executor);
+    task.execute_async();
+    return task.getPromise().getWaitedValue();
+}
+
+int main()
+{
+    bool ok = true;
+    constexpr int Count = 20000;
+    long long expected = 0;
+    for (long long i = 0; i < Count; ++i)
+    {
+        expected += i * i;
+    }
+
+    // three stages on a single worker thread, no stage holds on to a thread while it waits
+    {
+        Crotine::Xecutor single(1);
+        for (auto capacity : { std::size_t(0), std::size_t(16), Crotine::AsyncChannel<int>::Unbounded })
+        {
+            auto sum = run_on(single, pipeline(capacity, Count));
+            std::cout << "pipeline with capacity " << (capacity == Crotine::AsyncChannel<int>::Unbounded ? std::string("unbounded") : std::to_string(capacity)) << ": " << sum << "\n";
+            ok = ok && sum == expected;
+        }
+    }
+
+    // a value passed down a long chain of rendezvous stages does not run every stage on top of the previous one
+    {
+        Crotine::Xecutor single(1);
+        constexpr int Stages = 2000;
+        constexpr int Values = 10;
+        StackProbe probe;
+        auto total = run_on(single, relay_chain(Stages, Values, probe));
+        std::cout << "relay chain of " << Stages << " stages: " << total << ", stack depth " << probe.depth() << " bytes\n";
+        ok = ok && total == Values * (Values - 1) / 2 + Values * Stages && probe.depth() < 64 * 1024;
+    }
+
+    // many producers and consumers over a small buffer on a real pool
+    {
+        Crotine::Xecutor pool(4);
+        constexpr int Producers = 8;
+        constexpr int PerProducer = 5000;
+        long long total = static_cast<long long>(Producers) * PerProducer;
+        auto sum = run_on(pool, fan_in(Producers, PerProducer));
+        std::cout << "fan in sum: " << sum << " (expected " << total * (total - 1) / 2 << ")\n";
+        ok = ok && sum == total * (total - 1) / 2;
+    }
+
+    // closing wakes a suspended receiver and a suspended sender
+    {
+        Crotine::Xecutor pool(2);
+        Crotine::AsyncChannel<int> empty(1);
+        Crotine::AsyncChannel<int> full(1);
+        full.try_send(1);
+        auto receiver = [](Crotine::AsyncChannel<int>& channel) -> Crotine::Task<bool>
+        {
+            co_return !(co_await channel.receive()).has_value();
+        }(empty);
+        auto sender = [](Crotine::AsyncChannel<int>& channel) -> Crotine::Task<bool>
+        {
+            co_return !co_await channel.send(2);
+        }(full);
+        receiver.set_execution_ctx(pool);
+        sender.set_execution_ctx(pool);
+        receiver.execute_async();
+        sender.execute_async();
+        std::this_thread::sleep_for(20ms);
+        empty.close();
+        full.close();
+        auto woken = receiver.getPromise().getWaitedValue() && sender.getPromise().getWaitedValue();
+        // the value buffered before close is still delivered
+        auto left = full.try_receive();
+        std::cout << "close wakes waiters: " << (woken ? "ok" : "wrong") << ", buffered value left: " << (left ? *left : -1) << "\n";
+        ok = ok && woken && left == 1 && !full.try_receive();
+    }
+
+    std::cout << (ok ? "AsyncChannel tests passed.\n" : "AsyncChannel tests FAILED.\n");
+    return ok ? 0 : 1;
+}
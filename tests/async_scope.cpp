@@ -0,0 +1,188 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/AsyncScope.hpp"
+#include "../include/TimerWheel.hpp"
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+Crotine::Task<void> count_up(std::atomic_int& counter)
+{
+    counter.fetch_add(1);
+    co_return;
+}
+
+Crotine::Task<int> sleepy(std::atomic_int& counter, std::chrono::milliseconds duration)
+{
+    co_await Crotine::sleep_for(duration);
+    counter.fetch_add(1);
+    co_return 0;
+}
+
+Crotine::Task<void> failing(std::atomic_int& counter, int index)
+{
+    co_await Crotine::sleep_for(1ms);
+    counter.fetch_add(1);
+    if (index % 10 == 0)
+    {
+        throw std::runtime_error("task " + std::to_string(index) + " failed");
+    }
+}
+
+// spawns a sibling on every level until depth runs out
+Crotine::Task<void> fan_out(Crotine::AsyncScope& scope, std::atomic_int& counter, int depth)
+{
+    counter.fetch_add(1);
+    if (depth > 0)
+    {
+        co_await Crotine::sleep_for(1ms);
+        scope.spawn(fan_out(scope, counter, depth - 1));
+        scope.spawn(fan_out(scope, counter, depth - 1));
+    }
+}
+
+Crotine::Task<int> spawn_and_join(Crotine::Executor& pool, int count)
+{
+    std::atomic_int counter = 0;
+    Crotine::AsyncScope scope(pool);
+    for (int i = 0; i < count; ++i)
+    {
+        scope.spawn(count_up(counter));
+    }
+    co_await scope.join();
+    co_return counter.load();
+}
+
+Crotine::Task<std::string> first_failure(Crotine::Executor& pool, std::atomic_int& counter)
+{
+    Crotine::AsyncScope scope(pool);
+    for (int i = 1; i <= 50; ++i)
+    {
+        scope.spawn(failing(counter, i));
+    }
+    try
+    {
+        co_await scope.join();
+    }
+    catch (const std::runtime_error& error)
+    {
+        co_return error.what();
+    }
+    co_return "no failure";
+}
+
+Crotine::Task<int> nested(Crotine::Executor& pool)
+{
+    std::atomic_int counter = 0;
+    Crotine::AsyncScope scope(pool);
+    scope.spawn(fan_out(scope, counter, 6));
+    co_await scope.join();
+    co_return counter.load();
+}
+
+template <typename T>
+T run(Crotine::Executor& executor, Crotine::Task<T> task)
+{
+    task.set_execution_ctx(executor);
+    task.execute_async();
+    return task.getPromise().getWaitedValue();
+}
+
+int main()
+{
+    bool ok = true;
+    Crotine::Xecutor pool(2);
+
+    // thousands of tasks, no handle kept for any of them
+    {
+        auto counted = run(pool, spawn_and_join(pool, 10000));
+        std::cout << "join after " << counted << " tasks\n";
+        ok = ok && counted == 10000;
+    }
+
+    // every task runs to the end, join reports the first failure
+    {
+        std::atomic_int counter = 0;
+        auto error = run(pool, first_failure(pool, counter));
+        std::cout << "first failure: " << error << ", " << counter.load() << " tasks ran\n";
+        ok = ok && error.starts_with("task ") && error.ends_with("0 failed") && counter == 50;
+    }
+
+    // tasks spawn siblings while the scope is being joined
+    {
+        auto counted = run(pool, nested(pool));
+        std::cout << "nested spawns " << counted << "\n";
+        ok = ok && counted == 127;
+    }
+
+    // blocking wait from a plain thread
+    {
+        std::atomic_int counter = 0;
+        Crotine::AsyncScope scope(pool);
+        for (int i = 0; i < 100; ++i)
+        {
+            scope.spawn(sleepy(counter, 5ms));
+        }
+        ok = ok && scope.pending() > 0;
+        scope.wait();
+        std::cout << "wait after " << counter.load() << " sleepers, pending " << scope.pending() << "\n";
+        ok = ok && counter == 100 && scope.pending() == 0;
+        bool refused = false;
+        try
+        {
+            scope.spawn(count_up(counter));
+        }
+        catch (const std::logic_error&)
+        {
+            refused = true;
+        }
+        ok = ok && refused;
+    }
+
+    // request_stop cancels what is still sleeping
+    {
+        std::atomic_int counter = 0;
+        Crotine::AsyncScope scope(pool);
+        for (int i = 0; i < 100; ++i)
+        {
+            scope.spawn(sleepy(counter, 10s));
+        }
+        auto start = Clock::now();
+        scope.request_stop();
+        bool cancelled = false;
+        try
+        {
+            scope.wait();
+        }
+        catch (const Crotine::OperationCancelled&)
+        {
+            cancelled = true;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+        std::cout << "stopped scope after " << elapsed.count() << "ms\n";
+        ok = ok && cancelled && counter == 0 && elapsed < 2s;
+    }
+
+    // the destructor waits for whatever is still running
+    {
+        std::atomic_int counter = 0;
+        {
+            Crotine::AsyncScope scope(pool);
+            for (int i = 0; i < 20; ++i)
+            {
+                scope.spawn(sleepy(counter, 10ms));
+            }
+        }
+        std::cout << "scope destroyed after " << counter.load() << " tasks\n";
+        ok = ok && counter == 20;
+    }
+
+    std::cout << (ok ? "AsyncScope tests passed.\n" : "AsyncScope tests FAILED.\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <iostream>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/WaitGroup.hpp"
+#include "../include/AsyncMutex.hpp"
+#include "../include/AsyncEvent.hpp"
+#include "../include/TimerWheel.hpp"
+#include "../include/Combinators.hpp"
+#include "../include/AsyncSemaphore.hpp"
+
+using namespace std::chrono_literals;
+
+Crotine::Task<void> increment(Crotine::AsyncMutex& mutex, long long& counter, std::atomic_int& inside, std::atomic_bool& overlap, int times)
+{
+    for (int i = 0; i < times; ++i)
+    {
+        auto guard = co_await mutex.scoped_lock();
+        if (inside.fetch_add(1) != 0)
+        {
+            overlap = true;
+        }
+        ++counter;
+        inside.fetch_sub(1);
+    }
+}
+
+Crotine::Task<void> limited(Crotine::AsyncSemaphore& semaphore, std::atomic_int& active, std::atomic_int& peak)
+{
+    co_await semaphore.acquire();
+    auto now = active.fetch_add(1) + 1;
+    auto seen = peak.load();
+    while (now > seen && !peak.compare_exchange_weak(seen, now))
+    {}
+    co_await Crotine::sleep_for(2ms);
+    active.fetch_sub(1);
+    semaphore.release();
+}
+
+Crotine::Task<int> wait_event(Crotine::AsyncEvent& event, std::atomic_int& woken)
+{
+    co_await event;
+    woken.fetch_add(1);
+    co_return 1;
+}
+
+template <typename T>
+T run_on(Crotine::Executor& executor, Crotine::Task<T> task)
+{
+    task.set_execution_ctx(executor);
+    task.execute_async();
+    return task.getPromise().getWaitedValue();
+}
+
+int main()
+{
+    bool ok = true;
+    Crotine::Xecutor pool(4);
+
+    // many coroutines bumping one counter, the mutex keeps them from overlapping
+    {
+        constexpr int Workers = 16;
+        constexpr int Times = 5000;
+        Crotine::AsyncMutex mutex;
+        long long counter = 0;
+        std::atomic_int inside = 0;
+        std::atomic_bool overlap = false;
+        std::vector<Crotine::Task<void>> workers;
+        for (int i = 0; i < Workers; ++i)
+        {
+            workers.push_back(increment(mutex, counter, inside, overlap, Times));
+        }
+        run_on(pool, [](std::vector<Crotine::Task<void>> workers) -> Crotine::Task<int>
+        {
+            co_await Crotine::when_all(std::move(workers));
+            co_return 0;
+        }(std::move(workers)));
+        std::cout << "mutex counter: " << counter << " (expected " << Workers * Times << ")" << (overlap ? ", critical sections overlapped" : "") << "\n";
+        ok = ok && counter == Workers * Times && !overlap && mutex.try_lock();
+        mutex.unlock();
+    }
+
+    // a semaphore of 3 never lets more than 3 coroutines in at once
+    {
+        constexpr int Permits = 3;
+        Crotine::AsyncSemaphore semaphore(Permits);
+        std::atomic_int active = 0;
+        std::atomic_int peak = 0;
+        std::vector<Crotine::Task<void>> tasks;
+        for (int i = 0; i < 64; ++i)
+        {
+            tasks.push_back(limited(semaphore, active, peak));
+        }
+        run_on(pool, [](std::vector<Crotine::Task<void>> tasks) -> Crotine::Task<int>
+        {
+            co_await Crotine::when_all(std::move(tasks));
+            co_return 0;
+        }(std::move(tasks)));
+        std::cout << "semaphore peak concurrency: " << peak.load() << ", permits left: " << semaphore.available() << "\n";
+        ok = ok && peak.load() == Permits && semaphore.available() == Permits;
+    }
+
+    // set() releases every waiter, a reset event suspends again
+    {
+        Crotine::AsyncEvent event;
+        std::atomic_int woken = 0;
+        std::vector<Crotine::Task<int>> waiters;
+        for (int i = 0; i < 8; ++i)
+        {
+            waiters.push_back(wait_event(event, woken));
+        }
+        auto all = [](std::vector<Crotine::Task<int>> waiters) -> Crotine::Task<int>
+        {
+            int sum = 0;
+            for (auto value : co_await Crotine::when_all(std::move(waiters)))
+            {
+                sum += value;
+            }
+            co_return sum;
+        }(std::move(waiters));
+        all.set_execution_ctx(pool);
+        all.execute_async();
+        std::this_thread::sleep_for(20ms);
+        auto early = woken.load();
+        event.set();
+        auto sum = all.getPromise().getWaitedValue();
+        bool was_set = event.isSet();
+        event.reset();
+        std::cout << "event woke " << sum << " waiters (" << early << " before set)\n";
+        ok = ok && early == 0 && sum == 8 && was_set && !event.isSet();
+    }
+
+    // a coroutine waits for a WaitGroup without blocking a worker, and may own the group
+    {
+        constexpr int Children = 32;
+        std::atomic_int finished = 0;
+        auto parent = [](std::atomic_int& finished) -> Crotine::Task<int>
+        {
+            Crotine::WaitGroup group;
+            group.add(Children);
+            for (int i = 0; i < Children; ++i)
+            {
+                auto child = [](Crotine::WaitGroup& group, std::atomic_int& finished, int i) -> Crotine::Task<void>
+                {
+                    co_await Crotine::sleep_for(std::chrono::milliseconds(1 + i % 5));
+                    finished.fetch_add(1);
+                    group.done();
+                }(group, finished, i);
+                child.execute_detached();
+            }
+            co_await group.wait_async();
+            // already at zero, does not suspend
+            co_await group.wait_async();
+            co_return finished.load();
+        }(finished);
+        auto seen = run_on(pool, std::move(parent));
+        std::cout << "wait_async saw " << seen << " of " << Children << " children done\n";
+        ok = ok && seen == Children;
+    }
+
+    std::cout << (ok ? "Async synchronization tests passed.\n" : "Async synchronization tests FAILED.\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+#include <iostream>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+
+// every level awaits the next one, completion travels back up the chain
+// through symmetric transfer instead of one executor round trip per level
+Crotine::Task<int> chain(Crotine::Executor& executor, int depth)
+{
+    if (depth == 0)
+    {
+        co_return 0;
+    }
+    auto child = chain(executor, depth - 1);
+    child.set_execution_ctx(executor);
+    child.execute_async();
+    co_return co_await child + 1;
+}
+
+int main()
+{
+    constexpr int Depth = 10000;
+    Crotine::Xecutor pool(1);
+    auto task = chain(pool, Depth);
+    task.set_execution_ctx(pool);
+    task.execute_async();
+    auto result = task.getPromise().getWaitedValue();
+    std::cout << "Chain of " << Depth << " awaits returned " << result << "\n";
+    return result == Depth ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+#include <atomic>
+#include <vector>
+#include <iostream>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/TaskRunner.hpp"
+#include "../include/IoExecutor.hpp"
+#include "../include/RingChannel.hpp"
+#include "../include/Combinators.hpp"
+#include "../include/StealingXecutor.hpp"
+#include "../include/utils/Function.hpp"
+
+// every job of the batch runs exactly once
+bool batch_runs_all(Crotine::Executor& executor, const char* name, int count)
+{
+    std::atomic_int done = 0;
+    std::atomic_llong sum = 0;
+    std::vector<Crotine::Job> jobs;
+    for (int i = 0; i < count; ++i)
+    {
+        jobs.push_back([&done, &sum, i, count]()
+        {
+            sum.fetch_add(i);
+            if (done.fetch_add(1) + 1 == count)
+            {
+                done.notify_all();
+            }
+        });
+    }
+    executor.execute_batch(jobs);
+    for (auto current = done.load(); current != count; current = done.load())
+    {
+        done.wait(current);
+    }
+    bool ok = sum.load() == static_cast<long long>(count) * (count - 1) / 2;
+    std::cout << name << " batch of " << count << ": " << (ok ? "ok" : "wrong sum") << "\n";
+    return ok;
+}
+
+Crotine::Task<long long> spawn_many(int count)
+{
+    std::vector<Crotine::Task<int>> children;
+    for (int i = 0; i < count; ++i)
+    {
+        children.push_back(Crotine::CreateTask([](int i) -> Crotine::Task<int> { co_return i; }, i));
+    }
+    long long sum = 0;
+    for (auto value : co_await Crotine::when_all(std::move(children)))
+    {
+        sum += value;
+    }
+    co_return sum;
+}
+
+int main()
+{
+    bool ok = true;
+    Crotine::Xecutor pool(4);
+    {
+        Crotine::BasicXecutor<Crotine::RingChannel<Crotine::QueuedJob>> ring_pool(4);
+        Crotine::StealingXecutor stealing(4);
+        Crotine::IoExecutor io;
+        // the base class falls back to one execute() per job
+        Crotine::Executor threads;
+        ok = batch_runs_all(pool, "Xecutor", 10000) && ok;
+        ok = batch_runs_all(ring_pool, "RingChannel Xecutor", 10000) && ok;
+        ok = batch_runs_all(stealing, "StealingXecutor", 10000) && ok;
+        ok = batch_runs_all(io, "IoExecutor", 10000) && ok;
+        ok = batch_runs_all(threads, "Executor", 16) && ok;
+        ok = batch_runs_all(pool, "Xecutor empty", 0) && ok;
+    }
+
+    // plain callables are moved into their tasks, the vector may go away before they run
+    {
+        std::vector<std::function<int()>> functions;
+        for (int i = 0; i < 1000; ++i)
+        {
+            functions.push_back([i]() { return i * 2; });
+        }
+        auto tasks = Crotine::RunTasks(pool, std::move(functions));
+        long long sum = 0;
+        for (auto& task : tasks)
+        {
+            sum += task.getPromise().getWaitedValue();
+        }
+        std::cout << "RunTasks with plain callables: " << sum << "\n";
+        ok = ok && sum == 999LL * 1000;
+    }
+
+    // coroutine callables, started through a TaskRunner
+    {
+        Crotine::TaskRunner runner(pool);
+        std::vector<Crotine::Task<int>(*)()> functions(100, []() -> Crotine::Task<int> { co_return 3; });
+        auto tasks = runner.RunAll(functions);
+        int sum = 0;
+        for (auto& task : tasks)
+        {
+            sum += task.getPromise().getWaitedValue();
+        }
+        std::cout << "RunAll with coroutine callables: " << sum << "\n";
+        ok = ok && sum == 300;
+    }
+
+    // when_all over a vector hands its children to the executor as one batch
+    {
+        auto task = spawn_many(10000);
+        task.set_execution_ctx(pool);
+        task.execute_async();
+        auto sum = task.getPromise().getWaitedValue();
+        std::cout << "when_all over 10000 children: " << sum << "\n";
+        ok = ok && sum == 9999LL * 10000 / 2;
+    }
+
+    std::cout << (ok ? "Batch submission tests passed.\n" : "Batch submission tests FAILED.\n");
+    return ok ? 0 : 1;
+}
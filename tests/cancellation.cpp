@@ -0,0 +1,282 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <iostream>
+#include <stop_token>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/TimerWheel.hpp"
+#include "../include/AsyncChannel.hpp"
+#include "../include/Cancellation.hpp"
+#include "../include/Combinators.hpp"
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+Crotine::Xecutor pool(2);
+
+// how the coroutine ended: "done", "cancelled" or "failed"
+Crotine::Task<std::string> long_sleep()
+{
+    try
+    {
+        co_await Crotine::sleep_for(10s);
+        co_return "done";
+    }
+    catch (const Crotine::OperationCancelled&)
+    {
+        co_return "cancelled";
+    }
+}
+
+Crotine::Task<void> sleeping_child()
+{
+    co_await Crotine::sleep_for(10s);
+}
+
+// the child is started by co_await and inherits our stop token, its cancellation surfaces here
+Crotine::Task<std::string> await_child()
+{
+    try
+    {
+        co_await sleeping_child();
+        co_return "done";
+    }
+    catch (const Crotine::OperationCancelled&)
+    {
+        co_return "cancelled";
+    }
+}
+
+Crotine::Task<std::string> when_all_children()
+{
+    try
+    {
+        co_await Crotine::when_all(sleeping_child(), sleeping_child());
+        co_return "done";
+    }
+    catch (const Crotine::OperationCancelled&)
+    {
+        co_return "cancelled";
+    }
+}
+
+Crotine::Task<std::string> receive_until_stopped(Crotine::AsyncChannel<int>& channel)
+{
+    try
+    {
+        auto item = co_await channel.receive();
+        co_return item ? std::to_string(*item) : "closed";
+    }
+    catch (const Crotine::OperationCancelled&)
+    {
+        co_return "cancelled";
+    }
+}
+
+Crotine::Task<std::string> send_until_stopped(Crotine::AsyncChannel<int>& channel)
+{
+    try
+    {
+        co_await channel.send(1);
+        // the second send finds the single slot taken
+        co_await channel.send(2);
+        co_return "done";
+    }
+    catch (const Crotine::OperationCancelled&)
+    {
+        co_return "cancelled";
+    }
+}
+
+// plain computation, it only notices a stop where it checks for one
+Crotine::Task<long> spin(std::atomic_bool& running)
+{
+    long rounds = 0;
+    try
+    {
+        while (true)
+        {
+            co_await Crotine::throw_if_cancelled{};
+            running = true;
+            ++rounds;
+        }
+    }
+    catch (const Crotine::OperationCancelled&)
+    {
+        co_return rounds;
+    }
+}
+
+Crotine::Task<bool> sees_stop()
+{
+    auto& token = co_await Crotine::get_stop_token{};
+    co_return token.stop_requested();
+}
+
+Crotine::Task<int> quick()
+{
+    co_await Crotine::sleep_for(1ms);
+    co_return 1;
+}
+
+Crotine::Task<int> slow(std::atomic_int& outcome)
+{
+    try
+    {
+        co_await Crotine::sleep_for(10s);
+        outcome = 1;
+    }
+    catch (const Crotine::OperationCancelled&)
+    {
+        outcome = 2;
+    }
+    co_return 2;
+}
+
+Crotine::Task<std::size_t> race(std::atomic_int& outcome)
+{
+    auto [index, value] = co_await Crotine::when_any(quick(), slow(outcome));
+    co_return index;
+}
+
+Crotine::Task<bool> time_out(std::atomic_int& outcome)
+{
+    try
+    {
+        co_await Crotine::with_timeout(slow(outcome), 20ms);
+    }
+    catch (const Crotine::TimeoutError&)
+    {
+        co_return true;
+    }
+    co_return false;
+}
+
+template <typename T>
+T run(Crotine::Task<T> task, std::stop_source* stop = nullptr, std::chrono::milliseconds stop_after = 20ms)
+{
+    task.set_execution_ctx(pool);
+    if (stop)
+    {
+        task.set_stop_token(stop->get_token());
+    }
+    task.execute_async();
+    if (stop)
+    {
+        std::this_thread::sleep_for(stop_after);
+        stop->request_stop();
+    }
+    return task.getPromise().getWaitedValue();
+}
+
+bool wait_for(std::atomic_int& outcome, int expected)
+{
+    for (int i = 0; i < 500 && outcome.load() != expected; ++i)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+    return outcome.load() == expected;
+}
+
+int main()
+{
+    bool ok = true;
+
+    // a stop request ends a ten second sleep right away
+    {
+        std::stop_source stop;
+        auto start = Clock::now();
+        auto outcome = run(long_sleep(), &stop);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+        std::cout << "sleep " << outcome << " after " << elapsed.count() << "ms\n";
+        ok = ok && outcome == "cancelled" && elapsed < 2s;
+    }
+
+    // children inherit the token, awaited ones as well as combinator children
+    {
+        std::stop_source stop;
+        auto awaited = run(await_child(), &stop);
+        std::stop_source all_stop;
+        auto combined = run(when_all_children(), &all_stop);
+        std::cout << "awaited child " << awaited << ", when_all children " << combined << "\n";
+        ok = ok && awaited == "cancelled" && combined == "cancelled";
+    }
+
+    // a waiting receiver or sender leaves the channel, the channel keeps working
+    {
+        Crotine::AsyncChannel<int> channel;
+        std::stop_source stop;
+        auto received = run(receive_until_stopped(channel), &stop);
+        channel.try_send(7);
+        auto buffered = channel.try_receive();
+
+        Crotine::AsyncChannel<int> bounded(1);
+        std::stop_source send_stop;
+        auto sent = run(send_until_stopped(bounded), &send_stop);
+        auto first = bounded.try_receive();
+        auto second = bounded.try_receive();
+        std::cout << "receive " << received << ", send " << sent << "\n";
+        ok = ok && received == "cancelled" && buffered == 7;
+        ok = ok && sent == "cancelled" && first == 1 && !second;
+    }
+
+    // the explicit check
+    {
+        std::atomic_bool running = false;
+        std::stop_source stop;
+        auto task = spin(running);
+        task.set_execution_ctx(pool);
+        task.set_stop_token(stop.get_token());
+        task.execute_async();
+        while (!running)
+        {
+            std::this_thread::yield();
+        }
+        stop.request_stop();
+        auto rounds = task.getPromise().getWaitedValue();
+        auto unstopped = run(sees_stop());
+        std::cout << "spin stopped after " << rounds << " rounds\n";
+        ok = ok && rounds > 0 && !unstopped;
+    }
+
+    // a task stopped before it ever ran fails without running its body
+    {
+        std::stop_source stop;
+        stop.request_stop();
+        std::atomic_int outcome = 0;
+        auto task = slow(outcome);
+        task.set_execution_ctx(pool);
+        task.set_stop_token(stop.get_token());
+        task.execute_async();
+        bool thrown = false;
+        try
+        {
+            task.getPromise().getWaitedValue();
+        }
+        catch (const Crotine::OperationCancelled&)
+        {
+            thrown = true;
+        }
+        std::cout << "stopped before start " << (thrown ? "threw" : "ran") << "\n";
+        ok = ok && thrown && outcome == 0;
+    }
+
+    // the loser of a when_any and a timed out task are told to stop
+    {
+        std::atomic_int loser = 0;
+        auto winner = run(race(loser));
+        auto loser_stopped = wait_for(loser, 2);
+        std::atomic_int timed_out_task = 0;
+        auto timed_out = run(time_out(timed_out_task));
+        auto task_stopped = wait_for(timed_out_task, 2);
+        std::cout << "when_any loser " << (loser_stopped ? "stopped" : "still running")
+            << ", timed out task " << (task_stopped ? "stopped" : "still running") << "\n";
+        ok = ok && winner == 0 && loser_stopped && timed_out && task_stopped;
+    }
+
+    std::cout << (ok ? "Cancellation tests passed.\n" : "Cancellation tests FAILED.\n");
+    return ok ? 0 : 1;
+}
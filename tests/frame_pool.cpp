@@ -0,0 +1,99 @@
+#include <new>
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+#include <optional>
+#include <iostream>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/utils/FramePool.hpp"
+
+// live global allocations, a block that never makes it back to ::operator delete stays counted
+std::atomic_long live_allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    if (auto* ptr = std::malloc(size ? size : 1); ptr)
+    {
+        live_allocations.fetch_add(1);
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr)
+    {
+        live_allocations.fetch_sub(1);
+        std::free(ptr);
+    }
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+Crotine::Task<int> leaf(int value)
+{
+    co_return value;
+}
+
+Crotine::Task<long long> sum(Crotine::Executor& executor, int count)
+{
+    long long total = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        // each child frame is released before the next one is created, so it gets recycled
+        auto child = leaf(i);
+        child.set_execution_ctx(executor);
+        child.execute_async();
+        total += co_await child;
+    }
+    co_return total;
+}
+
+// destroyed after the frame pool's cache of its thread, since it was constructed first
+struct LateOwner
+{
+    std::optional<Crotine::Task<int>> task;
+    ~LateOwner()
+    {
+        task.reset();
+        // a frame created and freed while the thread is being torn down
+        auto late = leaf(2);
+    }
+};
+
+void frames_outliving_the_cache()
+{
+    std::thread([]()
+    {
+        thread_local LateOwner owner;
+        owner.task.emplace(leaf(1));
+    }).join();
+}
+
+int main()
+{
+    constexpr int Count = 10000;
+    Crotine::Xecutor pool(2);
+    auto task = sum(pool, Count);
+    task.set_execution_ctx(pool);
+    task.execute_async();
+    auto result = task.getPromise().getWaitedValue();
+
+    // the first round grows the registry of thread caches, the second must give back everything it took
+    frames_outliving_the_cache();
+    auto before = live_allocations.load();
+    frames_outliving_the_cache();
+    auto leaked = live_allocations.load() - before;
+    std::cout << "Blocks left behind by a thread exit: " << leaked << "\n";
+
+    auto stats = Crotine::FramePool::stats();
+    std::cout << "Sum: " << result << "\n";
+    std::cout << "Frame pool hits: " << stats.hits << " misses: " << stats.misses << " bytes cached: " << stats.bytes_cached << "\n";
+    return (result == static_cast<long long>(Count) * (Count - 1) / 2 && stats.hits > stats.misses && leaked == 0) ? 0 : 1;
+}
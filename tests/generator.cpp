@@ -0,0 +1,264 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/Generator.hpp"
+#include "../include/TimerWheel.hpp"
+#include "../include/AsyncGenerator.hpp"
+#include "../include/utils/Context.hpp"
+
+using namespace std::chrono_literals;
+
+struct Tracker
+{
+    int& alive;
+    Tracker(int& alive) : alive(alive) { ++alive; }
+    ~Tracker() { --alive; }
+};
+
+Crotine::Generator<int> counter(int limit, int& produced, int& alive)
+{
+    Tracker tracker(alive);
+    for (int i = 0; i < limit; ++i)
+    {
+        ++produced;
+        co_yield i;
+    }
+}
+
+// walks a container the caller owns, every element is handed out by reference
+Crotine::Generator<const std::string&> walk(const std::vector<std::string>& lines)
+{
+    for (auto& line : lines)
+    {
+        co_yield line;
+    }
+}
+
+Crotine::Generator<int> failing()
+{
+    co_yield 1;
+    throw std::runtime_error("scan failed");
+}
+
+Crotine::Task<int> slow_square(int value)
+{
+    co_await Crotine::sleep_for(1ms);
+    co_return value * value;
+}
+
+// the body awaits timers and child tasks between elements
+Crotine::AsyncGenerator<int> squares(int count, Crotine::Executor*& body_executor)
+{
+    for (int i = 1; i <= count; ++i)
+    {
+        auto child = slow_square(i);
+        child.set_execution_ctx(co_await Crotine::get_Execution_Context{});
+        child.execute_async();
+        auto value = co_await child;
+        body_executor = Crotine::Executor::getCurrentExecutor();
+        co_yield value;
+    }
+}
+
+Crotine::AsyncGenerator<const std::string&> async_walk(const std::vector<std::string>& lines)
+{
+    for (auto& line : lines)
+    {
+        co_await Crotine::sleep_for(100us);
+        co_yield line;
+    }
+}
+
+Crotine::AsyncGenerator<int> async_failing()
+{
+    co_yield 1;
+    co_await Crotine::sleep_for(1ms);
+    throw std::runtime_error("stream broke");
+}
+
+Crotine::AsyncGenerator<int> endless(int& alive)
+{
+    Tracker tracker(alive);
+    for (int i = 0;; ++i)
+    {
+        co_yield i;
+    }
+}
+
+Crotine::Task<int> sum_squares(int count, Crotine::Executor*& body_executor)
+{
+    auto stream = squares(count, body_executor);
+    int sum = 0;
+    while (auto* value = co_await stream.next())
+    {
+        sum += *value;
+    }
+    co_return sum;
+}
+
+Crotine::Task<bool> same_addresses(const std::vector<std::string>& lines)
+{
+    auto stream = async_walk(lines);
+    std::size_t index = 0;
+    bool same = true;
+    while (auto* line = co_await stream.next())
+    {
+        same = same && line == &lines[index++];
+    }
+    co_return same && index == lines.size();
+}
+
+Crotine::Task<std::string> catch_failure()
+{
+    auto stream = async_failing();
+    std::string seen;
+    try
+    {
+        while (auto* value = co_await stream.next())
+        {
+            seen += std::to_string(*value);
+        }
+    }
+    catch (const std::runtime_error& error)
+    {
+        seen += error.what();
+    }
+    co_return seen;
+}
+
+Crotine::Task<int> take_three(int& alive)
+{
+    auto stream = endless(alive);
+    int sum = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        sum += *co_await stream.next();
+    }
+    co_return sum;
+}
+
+Crotine::Task<int> consume_elsewhere(Crotine::Executor& producer_pool, Crotine::Executor*& body_executor)
+{
+    auto stream = squares(3, body_executor);
+    stream.set_execution_ctx(producer_pool);
+    int sum = 0;
+    while (auto* value = co_await stream.next())
+    {
+        sum += *value;
+    }
+    co_return sum;
+}
+
+template <typename T>
+T run(Crotine::Executor& executor, Crotine::Task<T> task)
+{
+    task.set_execution_ctx(executor);
+    task.execute_async();
+    return task.getPromise().getWaitedValue();
+}
+
+int main()
+{
+    bool ok = true;
+
+    // lazy: nothing runs before begin(), breaking out early stops production and frees the frame
+    {
+        int produced = 0;
+        int alive = 0;
+        {
+            auto numbers = counter(1000000, produced, alive);
+            ok = ok && produced == 0 && alive == 0;
+            int sum = 0;
+            for (int value : numbers)
+            {
+                if (value == 5)
+                {
+                    break;
+                }
+                sum += value;
+            }
+            std::cout << "generator sum " << sum << ", produced " << produced << "\n";
+            ok = ok && sum == 10 && produced == 6 && alive == 1;
+        }
+        ok = ok && alive == 0;
+    }
+
+    // references pass through untouched
+    {
+        std::vector<std::string> lines = {"alpha", "beta", "gamma"};
+        std::size_t index = 0;
+        bool same = true;
+        for (const auto& line : walk(lines))
+        {
+            same = same && &line == &lines[index++];
+        }
+        std::cout << "generator references " << (same ? "preserved" : "copied") << "\n";
+        ok = ok && same && index == 3;
+    }
+
+    // the body's exception surfaces at the iteration that hit it
+    {
+        std::string seen;
+        try
+        {
+            for (int value : failing())
+            {
+                seen += std::to_string(value);
+            }
+        }
+        catch (const std::runtime_error& error)
+        {
+            seen += error.what();
+        }
+        std::cout << "generator exception: " << seen << "\n";
+        ok = ok && seen == "1scan failed";
+    }
+
+    Crotine::Xecutor pool(2);
+    Crotine::Xecutor producer_pool(1);
+
+    // the body awaits timers and tasks and inherits the consumer's executor
+    {
+        Crotine::Executor* body_executor = nullptr;
+        auto sum = run(pool, sum_squares(10, body_executor));
+        std::cout << "async generator sum of squares " << sum << "\n";
+        ok = ok && sum == 385 && body_executor == &pool;
+    }
+
+    // an explicitly placed body runs on its own executor
+    {
+        Crotine::Executor* body_executor = nullptr;
+        auto sum = run(pool, consume_elsewhere(producer_pool, body_executor));
+        std::cout << "async generator on its own pool " << sum << "\n";
+        ok = ok && sum == 14 && body_executor == &producer_pool;
+    }
+
+    {
+        std::vector<std::string> lines = {"one", "two", "three", "four"};
+        auto same = run(pool, same_addresses(lines));
+        std::cout << "async generator references " << (same ? "preserved" : "copied") << "\n";
+        ok = ok && same;
+    }
+
+    {
+        auto seen = run(pool, catch_failure());
+        std::cout << "async generator exception: " << seen << "\n";
+        ok = ok && seen == "1stream broke";
+    }
+
+    // abandoning an endless stream destroys its frame
+    {
+        int alive = 0;
+        auto sum = run(pool, take_three(alive));
+        std::cout << "endless stream sum " << sum << ", frames alive " << alive << "\n";
+        ok = ok && sum == 3 && alive == 0;
+    }
+
+    std::cout << (ok ? "Generator tests passed.\n" : "Generator tests FAILED.\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,272 @@
+#include <cerrno>
+#include <cstddef>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stop_token>
+
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/IoExecutor.hpp"
+
+auto as_bytes(const std::string& text)
+{
+    return std::as_bytes(std::span(text.data(), text.size()));
+}
+
+Crotine::Task<std::string> pipe_round_trip(Crotine::IoExecutor& io)
+{
+    int fds[2];
+    ::pipe(fds);
+    std::string message = "through a pipe";
+    co_await io.write(fds[1], as_bytes(message));
+    std::string received(message.size(), '\0');
+    auto count = co_await io.read(fds[0], std::as_writable_bytes(std::span(received)));
+    ::close(fds[0]);
+    ::close(fds[1]);
+    received.resize(count < 0 ? 0 : count);
+    co_return received;
+}
+
+Crotine::Task<std::string> socketpair_round_trip(Crotine::IoExecutor& io)
+{
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    std::string message = "through a socketpair";
+    std::string received(message.size(), '\0');
+    co_await io.send(fds[0], as_bytes(message));
+    auto count = co_await io.recv(fds[1], std::as_writable_bytes(std::span(received)));
+    ::close(fds[0]);
+    ::close(fds[1]);
+    received.resize(count < 0 ? 0 : count);
+    co_return received;
+}
+
+Crotine::Task<long> serve_one(Crotine::IoExecutor& io, int listener)
+{
+    auto client = co_await io.accept(listener);
+    if (client < 0)
+    {
+        co_return client;
+    }
+    char buffer[64];
+    auto count = co_await io.recv(client, std::as_writable_bytes(std::span(buffer)));
+    if (count > 0)
+    {
+        co_await io.send(client, std::as_bytes(std::span(buffer, count)));
+    }
+    ::close(client);
+    co_return count;
+}
+
+Crotine::Task<std::string> tcp_round_trip(Crotine::IoExecutor& io, Crotine::Executor& pool)
+{
+    int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    ::listen(listener, 8);
+    socklen_t length = sizeof(address);
+    ::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+
+    // the server side runs on the pool, the client side on the I/O loop itself
+    auto server = serve_one(io, listener);
+    server.set_execution_ctx(pool);
+    server.execute_async();
+
+    int client = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    std::string received;
+    if (co_await io.connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+    {
+        std::string message = "through loopback tcp";
+        co_await io.send(client, as_bytes(message));
+        received.resize(message.size());
+        auto count = co_await io.recv(client, std::as_writable_bytes(std::span(received)), MSG_WAITALL);
+        received.resize(count < 0 ? 0 : count);
+    }
+    co_await server;
+    ::close(client);
+    ::close(listener);
+    co_return received;
+}
+
+// a regular file can not be polled, epoll reads it right away instead of waiting for readiness that never comes
+Crotine::Task<std::string> file_round_trip(Crotine::IoExecutor& io)
+{
+    char path[] = "/tmp/crotine-io-test-XXXXXX";
+    int fd = ::mkstemp(path);
+    ::unlink(path);
+    std::string message = "through a regular file";
+    auto written = co_await io.write(fd, as_bytes(message));
+    ::lseek(fd, 0, SEEK_SET);
+    std::string received(message.size(), '\0');
+    auto count = co_await io.read(fd, std::as_writable_bytes(std::span(received)));
+    ::close(fd);
+    received.resize(count < 0 || written != static_cast<long>(message.size()) ? 0 : count);
+    co_return received;
+}
+
+// an AF_UNIX connect finishes at once, epoll resumes the coroutine while draining and its send must not wait for a wake
+Crotine::Task<std::string> unix_connect_then_send(Crotine::IoExecutor& io)
+{
+    int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    // abstract namespace, nothing left behind on the filesystem
+    auto name = "crotine-io-test-" + std::to_string(::getpid());
+    std::memcpy(address.sun_path + 1, name.data(), name.size());
+    auto length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + name.size());
+    ::bind(listener, reinterpret_cast<sockaddr*>(&address), length);
+    ::listen(listener, 8);
+
+    int client = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    std::string received;
+    if (co_await io.connect(client, reinterpret_cast<sockaddr*>(&address), length) == 0)
+    {
+        std::string message = "through a unix socket";
+        auto sent = co_await io.send(client, as_bytes(message));
+        int server = ::accept(listener, nullptr, nullptr);
+        received.resize(message.size());
+        auto count = sent > 0 ? ::recv(server, received.data(), received.size(), MSG_WAITALL) : 0;
+        received.resize(count < 0 ? 0 : count);
+        ::close(server);
+    }
+    ::close(client);
+    ::close(listener);
+    co_return received;
+}
+
+// nothing is ever written to the pipe, only a stop request ends the read
+Crotine::Task<long> read_until_stopped(Crotine::IoExecutor& io, int fd)
+{
+    char buffer[16];
+    co_return co_await io.read(fd, std::as_writable_bytes(std::span(buffer)));
+}
+
+long cancelled_read(Crotine::IoExecutor& io, Crotine::Executor& pool, bool stop_first)
+{
+    int fds[2];
+    ::pipe(fds);
+    std::stop_source stop;
+    if (stop_first)
+    {
+        stop.request_stop();
+    }
+    auto reader = read_until_stopped(io, fds[0]);
+    reader.set_execution_ctx(pool);
+    reader.set_stop_token(stop.get_token());
+    reader.execute_async();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stop.request_stop();
+    long result = 0;
+    try
+    {
+        result = reader.getPromise().getWaitedValue();
+    }
+    catch (const Crotine::OperationCancelled&)
+    {
+        // stopped before the task even started
+        result = -ECANCELED;
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return result;
+}
+
+// more than a blocking pipe holds, epoll writes what fits instead of blocking the loop until a reader shows up
+Crotine::Task<long> oversized_write(Crotine::IoExecutor& io)
+{
+    int fds[2];
+    ::pipe(fds);
+    std::string payload(1 << 20, 'x');
+    auto written = co_await io.write(fds[1], as_bytes(payload));
+    // the loop is still free for other operations on it
+    std::string received(16, '\0');
+    auto count = co_await io.read(fds[0], std::as_writable_bytes(std::span(received)));
+    ::close(fds[0]);
+    ::close(fds[1]);
+    co_return count == 16 ? written : -1;
+}
+
+bool run_backend(Crotine::IoExecutor::Backend backend, const char* name)
+{
+    Crotine::Xecutor pool(2);
+    Crotine::IoExecutor io(backend);
+
+    auto on_pool = pipe_round_trip(io);
+    on_pool.set_execution_ctx(pool);
+    on_pool.execute_async();
+    auto pipe_result = on_pool.getPromise().getWaitedValue();
+
+    auto on_loop = socketpair_round_trip(io);
+    on_loop.set_execution_ctx(io);
+    on_loop.execute_async();
+    auto socketpair_result = on_loop.getPromise().getWaitedValue();
+
+    auto tcp = tcp_round_trip(io, pool);
+    tcp.set_execution_ctx(io);
+    tcp.execute_async();
+    auto tcp_result = tcp.getPromise().getWaitedValue();
+
+    auto on_file = file_round_trip(io);
+    on_file.set_execution_ctx(pool);
+    on_file.execute_async();
+    auto file_result = on_file.getPromise().getWaitedValue();
+
+    std::string unix_result;
+    for (int round = 0; round < 30; ++round)
+    {
+        auto unix_connect = unix_connect_then_send(io);
+        unix_connect.set_execution_ctx(io);
+        unix_connect.execute_async();
+        unix_result = unix_connect.getPromise().getWaitedValue();
+        if (unix_result != "through a unix socket")
+        {
+            break;
+        }
+    }
+
+    auto stopped_while_pending = cancelled_read(io, pool, false);
+    auto stopped_before = cancelled_read(io, pool, true);
+
+    bool short_write = true;
+    if (backend == Crotine::IoExecutor::Backend::Epoll)
+    {
+        auto writer = oversized_write(io);
+        writer.set_execution_ctx(pool);
+        writer.execute_async();
+        auto written = writer.getPromise().getWaitedValue();
+        std::cout << name << ": 1 MiB write to a blocking pipe wrote " << written << " bytes\n";
+        short_write = written > 0 && written < (1 << 20);
+    }
+
+    std::cout << name << ": " << pipe_result << " / " << socketpair_result << " / " << tcp_result << " / " << unix_result << " / " << file_result
+        << " / cancelled reads " << stopped_while_pending << " " << stopped_before << "\n";
+    return pipe_result == "through a pipe" && socketpair_result == "through a socketpair" && tcp_result == "through loopback tcp"
+        && unix_result == "through a unix socket" && file_result == "through a regular file"
+        && stopped_while_pending == -ECANCELED && stopped_before == -ECANCELED && short_write;
+}
+
+int main()
+{
+    bool ok = run_backend(Crotine::IoExecutor::Backend::Epoll, "epoll");
+    Crotine::IoExecutor probe;
+    if (probe.backend() == Crotine::IoExecutor::Backend::IoUring)
+    {
+        ok = run_backend(Crotine::IoExecutor::Backend::IoUring, "io_uring") && ok;
+    }
+    else
+    {
+        std::cout << "io_uring not available, skipped\n";
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#define CROTINE_ENABLE_METRICS
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#include "../include/Xecutor.hpp"
+#include "../include/RingChannel.hpp"
+#include "../include/StealingXecutor.hpp"
+
+using namespace std::chrono_literals;
+
+template <typename Pool>
+void run_jobs(Pool& pool, int jobs)
+{
+    std::atomic_int done = 0;
+    for (int i = 0; i < jobs; ++i)
+    {
+        pool.execute([&done, jobs]()
+        {
+            std::this_thread::sleep_for(10us);
+            if (done.fetch_add(1) + 1 == jobs)
+            {
+                done.notify_all();
+            }
+        });
+    }
+    for (auto current = done.load(); current != jobs; current = done.load())
+    {
+        done.wait(current);
+    }
+}
+
+// a worker counts a job after it returned, so the last few may still be in flight when run_jobs is done
+template <typename Pool>
+auto settled(Pool& pool, std::uint64_t executed) -> Crotine::ExecutorMetricsSnapshot
+{
+    auto snapshot = pool.getMetrics();
+    for (int i = 0; i < 1000 && snapshot.total().tasks_executed < executed; ++i)
+    {
+        std::this_thread::sleep_for(1ms);
+        snapshot = pool.getMetrics();
+    }
+    return snapshot;
+}
+
+void print(const char* name, const Crotine::ExecutorMetricsSnapshot& snapshot)
+{
+    auto total = snapshot.total();
+    std::cout << name << ": " << total.tasks_executed << " tasks, " << total.steals << " steals, " << total.parks << " parks, "
+              << snapshot.threads_created << " threads created, " << snapshot.threads_expired << " expired\n";
+    std::cout << "    queue wait p50 <= " << total.queue_wait.percentile(0.5).count() << "ns p99 <= " << total.queue_wait.percentile(0.99).count()
+              << "ns, run time mean " << total.run_time.mean().count() << "ns\n";
+}
+
+int main()
+{
+    bool ok = true;
+    constexpr int Jobs = 2000;
+
+    // short timeout, the workers expire while we sleep and come back for the second round
+    {
+        Crotine::Xecutor pool(4, 20ms);
+        run_jobs(pool, Jobs);
+        std::this_thread::sleep_for(200ms);
+        auto idle = settled(pool, Jobs);
+        run_jobs(pool, Jobs);
+        auto snapshot = settled(pool, 2 * Jobs);
+        print("Xecutor", snapshot);
+        auto total = snapshot.total();
+        ok = ok && snapshot.enabled && snapshot.workers.size() == 4 && total.tasks_executed == 2 * Jobs;
+        ok = ok && total.queue_wait.count == 2 * Jobs && total.run_time.count == 2 * Jobs && total.run_time.mean() >= 10us;
+        ok = ok && idle.live_threads == 0 && idle.threads_expired == idle.threads_created && snapshot.threads_created > idle.threads_created;
+        ok = ok && snapshot.queue_depth == 0;
+    }
+
+    {
+        Crotine::StealingXecutor pool(4);
+        run_jobs(pool, Jobs);
+        auto snapshot = settled(pool, Jobs);
+        print("StealingXecutor", snapshot);
+        ok = ok && snapshot.enabled && snapshot.total().tasks_executed == Jobs && snapshot.threads_created == 4 && snapshot.live_threads == 4;
+    }
+
+    // the stamp travels in the channel entry, batches and custom channels record the wait too
+    {
+        Crotine::BasicXecutor<Crotine::RingChannel<Crotine::QueuedJob>> pool(2);
+        std::atomic_int done = 0;
+        std::vector<Crotine::Job> jobs;
+        for (int i = 0; i < Jobs; ++i)
+        {
+            jobs.emplace_back([&done]() { done.fetch_add(1); });
+        }
+        pool.execute_batch(jobs);
+        auto snapshot = settled(pool, Jobs);
+        print("ring backed Xecutor, one batch", snapshot);
+        ok = ok && done.load() == Jobs && snapshot.total().queue_wait.count == Jobs;
+    }
+
+    // the histogram buckets are powers of two
+    {
+        Crotine::Histogram histogram;
+        histogram.buckets[10] = 99;
+        histogram.buckets[20] = 1;
+        histogram.count = 100;
+        ok = ok && histogram.percentile(0.5) == 1024ns && histogram.percentile(1.0) == 1048576ns;
+    }
+
+    std::cout << (ok ? "Metrics tests passed.\n" : "Metrics tests FAILED.\n");
+    return ok ? 0 : 1;
+}
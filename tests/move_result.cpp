@@ -0,0 +1,183 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/TimerWheel.hpp"
+#include "../include/Combinators.hpp"
+
+using namespace std::chrono_literals;
+
+// counts how often the payload is copied and moved on its way through the tasks
+struct Payload
+{
+    inline static int copies = 0;
+    inline static int moves = 0;
+    std::vector<int> data;
+    Payload(std::size_t size) : data(size, 7) {}
+    Payload(const Payload& other) : data(other.data) { ++copies; }
+    Payload(Payload&& other) noexcept : data(std::move(other.data)) { ++moves; }
+    static void reset() { copies = 0; moves = 0; }
+};
+
+// children run on the pool the test drives everything on
+Crotine::Xecutor pool(2);
+
+template <typename T>
+Crotine::Task<T> started(Crotine::Task<T> task)
+{
+    task.set_execution_ctx(pool);
+    task.execute_async();
+    return task;
+}
+
+Crotine::Task<Payload> produce(std::size_t size)
+{
+    Payload payload(size);
+    co_return payload;
+}
+
+// every hop hands the payload on without copying it
+Crotine::Task<Payload> forward(std::size_t size, int hops)
+{
+    if (hops == 0)
+    {
+        co_return co_await started(produce(size));
+    }
+    auto child = started(forward(size, hops - 1));
+    auto payload = co_await std::move(child);
+    co_return payload;
+}
+
+Crotine::Task<std::unique_ptr<std::string>> make_unique_name()
+{
+    co_await Crotine::sleep_for(1ms);
+    co_return std::make_unique<std::string>("unique");
+}
+
+Crotine::Task<std::size_t> use_unique()
+{
+    auto name = co_await started(make_unique_name());
+    co_return name->size();
+}
+
+struct Registry
+{
+    std::string name = "registry";
+    int hits = 0;
+};
+
+// hands out a reference to an object that outlives the task
+Crotine::Task<Registry&> lookup(Registry& registry)
+{
+    co_await Crotine::sleep_for(1ms);
+    co_return registry;
+}
+
+Crotine::Task<bool> bump(Registry& registry)
+{
+    auto& found = co_await started(lookup(registry));
+    found.hits += 1;
+    auto task = started(lookup(registry));
+    // awaiting an lvalue task reads the result in place, here the reference itself
+    Registry& again = co_await task;
+    again.hits += 1;
+    co_return &found == &registry && &again == &registry;
+}
+
+// with_timeout hands the reference on as well, and move-only values leave it by moving
+Crotine::Task<bool> timed_lookup(Registry& registry)
+{
+    auto& found = co_await Crotine::with_timeout(lookup(registry), 1s);
+    found.hits += 1;
+    auto name = co_await Crotine::with_timeout(make_unique_name(), 1s);
+    co_return &found == &registry && *name == "unique";
+}
+
+Crotine::Task<std::size_t> sum_unique()
+{
+    std::vector<Crotine::Task<std::unique_ptr<std::string>>> tasks;
+    tasks.push_back(make_unique_name());
+    tasks.push_back(make_unique_name());
+    auto names = co_await Crotine::when_all(std::move(tasks));
+    auto [first, second] = co_await Crotine::when_all(make_unique_name(), make_unique_name());
+    co_return names[0]->size() + names[1]->size() + first->size() + second->size();
+}
+
+// several coroutines may await the same task, each reads the result in place
+Crotine::Task<std::size_t> read_shared(Crotine::Task<Payload>& shared)
+{
+    const auto& payload = co_await shared;
+    co_return payload.data.size();
+}
+
+Crotine::Task<bool> shared_readers()
+{
+    auto shared = started(produce(64));
+    auto [a, b] = co_await Crotine::when_all(read_shared(shared), read_shared(shared));
+    co_return a == 64 && b == 64;
+}
+
+template <typename Task>
+decltype(auto) run(Task& task)
+{
+    task.set_execution_ctx(pool);
+    task.execute_async();
+    return task.getPromise().getWaitedValue();
+}
+
+int main()
+{
+    bool ok = true;
+
+    // a payload passed through five tasks is moved at every hop and never copied
+    {
+        Payload::reset();
+        auto task = forward(1 << 20, 4);
+        auto& payload = run(task);
+        std::cout << "payload of " << payload.data.size() << " ints: " << Payload::copies << " copies, " << Payload::moves << " moves\n";
+        ok = ok && payload.data.size() == (1 << 20) && Payload::copies == 0;
+    }
+
+    // move-only results
+    {
+        auto task = use_unique();
+        auto size = run(task);
+        auto direct = make_unique_name();
+        auto name = std::move(run(direct));
+        std::cout << "unique_ptr results: " << size << " and " << *name << "\n";
+        ok = ok && size == 6 && *name == "unique";
+    }
+
+    // references pass through without copies
+    {
+        Registry registry;
+        auto task = bump(registry);
+        auto same = run(task);
+        std::cout << "reference results " << (same ? "point at the original" : "are copies") << ", hits " << registry.hits << "\n";
+        ok = ok && same && registry.hits == 2;
+        auto timed = timed_lookup(registry);
+        auto timed_same = run(timed);
+        std::cout << "with_timeout reference " << (timed_same ? "points at the original" : "is a copy") << "\n";
+        ok = ok && timed_same && registry.hits == 3;
+    }
+
+    {
+        auto task = sum_unique();
+        auto total = run(task);
+        std::cout << "when_all over move-only results: " << total << "\n";
+        ok = ok && total == 24;
+    }
+
+    {
+        auto task = shared_readers();
+        auto shared = run(task);
+        ok = ok && shared;
+    }
+
+    std::cout << (ok ? "Move result tests passed.\n" : "Move result tests FAILED.\n");
+    return ok ? 0 : 1;
+}
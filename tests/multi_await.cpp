@@ -0,0 +1,71 @@
+#include <atomic>
+#include <iostream>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+
+Crotine::Task<int> produce()
+{
+    co_return 21;
+}
+
+Crotine::Task<int> counted(std::atomic_int& runs)
+{
+    runs.fetch_add(1);
+    co_return 21;
+}
+
+Crotine::Task<int> twice(Crotine::Task<int>& source)
+{
+    co_return co_await source * 2;
+}
+
+int main()
+{
+    Crotine::Xecutor pool(4);
+    std::atomic_int callbacks = 0;
+
+    auto source = produce();
+    source.set_execution_ctx(pool);
+    source.getPromise().chainOnResolved([&callbacks](const int& value) { callbacks.fetch_add(value); });
+
+    // both awaiters register before the source runs, one of them on a different executor
+    auto first = twice(source);
+    first.set_execution_ctx(pool);
+    first.execute_async();
+    auto second = twice(source);
+    second.execute_async();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    source.execute_async();
+    auto a = first.getPromise().getWaitedValue();
+    auto b = second.getPromise().getWaitedValue();
+
+    // registering after completion runs the callback right away
+    source.getPromise().chainOnResolved([&callbacks]() { callbacks.fetch_add(100); });
+
+    std::cout << "Awaiter results: " << a << " and " << b << ", callbacks: " << callbacks.load() << "\n";
+    bool ok = a == 42 && b == 42 && callbacks.load() == 121;
+
+    // awaiters on pool threads racing the explicit start, whoever comes first starts the source exactly once
+    std::atomic_int runs = 0;
+    constexpr int Rounds = 500;
+    bool results = true;
+    for (int round = 0; round < Rounds; ++round)
+    {
+        auto racy = counted(runs);
+        racy.set_execution_ctx(pool);
+        auto left = twice(racy);
+        left.set_execution_ctx(pool);
+        auto right = twice(racy);
+        right.set_execution_ctx(pool);
+        left.execute_async();
+        right.execute_async();
+        racy.execute_async();
+        racy.execute_async();
+        results = results && left.getPromise().getWaitedValue() == 42 && right.getPromise().getWaitedValue() == 42;
+    }
+    std::cout << "Raced starts: source ran " << runs.load() << " times in " << Rounds << " rounds\n";
+    ok = ok && results && runs.load() == Rounds;
+    return ok ? 0 : 1;
+}
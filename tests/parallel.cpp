@@ -0,0 +1,174 @@
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <numeric>
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+#include <unordered_set>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/Parallel.hpp"
+
+Crotine::Task<long> sum_squares(Crotine::Executor& pool, const std::vector<int>& values)
+{
+    co_return co_await Crotine::parallel_reduce(pool, values, 0L, std::plus<>{}, [](int value) { return long{value} * value; });
+}
+
+Crotine::Task<void> double_all(Crotine::Executor& pool, std::vector<int>& values)
+{
+    co_await Crotine::parallel_for(pool, values, [](int& value) { value *= 2; });
+}
+
+Crotine::Task<std::string> failing_loop(Crotine::Executor& pool, std::atomic_int& visited)
+{
+    try
+    {
+        co_await Crotine::parallel_for(pool, std::views::iota(0, 100000), [&visited](int value)
+        {
+            visited.fetch_add(1);
+            if (value == 500)
+            {
+                throw std::runtime_error("element 500");
+            }
+        }, 16);
+    }
+    catch (const std::runtime_error& error)
+    {
+        co_return error.what();
+    }
+    co_return "no failure";
+}
+
+template <typename T>
+T run(Crotine::Executor& executor, Crotine::Task<T> task)
+{
+    task.set_execution_ctx(executor);
+    task.execute_async();
+    return task.getPromise().getWaitedValue();
+}
+
+int main()
+{
+    bool ok = true;
+    Crotine::Xecutor pool(4);
+
+    std::vector<int> values(100000);
+    std::iota(values.begin(), values.end(), 0);
+    long expected = 0;
+    for (auto value : values)
+    {
+        expected += long{value} * value;
+    }
+
+    // awaited from a coroutine
+    {
+        auto sum = run(pool, sum_squares(pool, values));
+        auto copy = values;
+        run(pool, double_all(pool, copy));
+        bool doubled = true;
+        for (std::size_t i = 0; i < copy.size(); ++i)
+        {
+            doubled = doubled && copy[i] == values[i] * 2;
+        }
+        std::cout << "awaited reduce " << sum << ", for_each " << (doubled ? "doubled" : "missed elements") << "\n";
+        ok = ok && sum == expected && doubled;
+    }
+
+    // blocking from a plain thread, which works on the range itself
+    {
+        std::mutex mutex;
+        std::unordered_set<std::thread::id> threads;
+        auto sum = Crotine::parallel_reduce(pool, values, 0L, std::plus<>{}, [&](int value)
+        {
+            if (value % 1000 == 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            return long{value} * value;
+        }, 1000).get();
+        std::vector<std::string> output(values.size());
+        Crotine::parallel_transform(pool, values, output, [](int value) { return std::to_string(value); }).get();
+        bool transformed = true;
+        for (std::size_t i = 0; i < output.size(); ++i)
+        {
+            transformed = transformed && output[i] == std::to_string(values[i]);
+        }
+        std::cout << "blocking reduce " << sum << " on " << threads.size() << " threads, transform "
+            << (transformed ? "matches" : "differs") << "\n";
+        ok = ok && sum == expected && transformed && threads.size() >= 1;
+    }
+
+    // every element is visited exactly once, whatever the grain
+    for (std::size_t grain : {0, 1, 7, 100000, 1000000})
+    {
+        std::vector<std::atomic_int> hits(12345);
+        Crotine::parallel_for(pool, hits, [](std::atomic_int& hit) { hit.fetch_add(1); }, grain).get();
+        bool once = true;
+        for (auto& hit : hits)
+        {
+            once = once && hit.load() == 1;
+        }
+        ok = ok && once;
+        if (!once)
+        {
+            std::cout << "grain " << grain << " missed or repeated elements\n";
+        }
+    }
+
+    // empty and single element ranges, non commutative but associative op over a view
+    {
+        std::vector<int> empty;
+        auto nothing = Crotine::parallel_reduce(pool, empty, 42, std::plus<>{}).get();
+        auto single = Crotine::parallel_reduce(pool, std::vector<int>{5}, 1, std::multiplies<>{}).get();
+        auto count = Crotine::parallel_reduce(pool, std::views::iota(0, 1000), std::size_t{0}, std::plus<>{}, [](int) { return std::size_t{1}; }).get();
+        std::cout << "empty " << nothing << ", single " << single << ", iota count " << count << "\n";
+        ok = ok && nothing == 42 && single == 5 && count == 1000;
+    }
+
+    // a throwing element stops the loop early and surfaces in the caller
+    {
+        std::atomic_int visited = 0;
+        auto error = run(pool, failing_loop(pool, visited));
+        bool blocked = false;
+        try
+        {
+            Crotine::parallel_for(pool, values, [](int value)
+            {
+                if (value == 99999)
+                {
+                    throw std::runtime_error("last element");
+                }
+            }).get();
+        }
+        catch (const std::runtime_error&)
+        {
+            blocked = true;
+        }
+        std::cout << "failure " << error << " after " << visited.load() << " elements, blocking failure "
+            << (blocked ? "rethrown" : "lost") << "\n";
+        ok = ok && error == "element 500" && visited.load() < 100000 && blocked;
+    }
+
+    // shorter output is refused before anything runs
+    {
+        std::vector<int> output(10);
+        bool refused = false;
+        try
+        {
+            Crotine::parallel_transform(pool, values, output, [](int value) { return value; }).get();
+        }
+        catch (const std::invalid_argument&)
+        {
+            refused = true;
+        }
+        ok = ok && refused;
+    }
+
+    std::cout << (ok ? "Parallel tests passed.\n" : "Parallel tests FAILED.\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iostream>
+
+#include "../include/Xecutor.hpp"
+#include "../include/RingChannel.hpp"
+
+using namespace std::chrono_literals;
+
+// runs a burst of jobs and collects the threads that ran them
+template <typename Pool>
+std::set<std::thread::id> burst(Pool& pool, int jobs)
+{
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::atomic_int done = 0;
+    for (int i = 0; i < jobs; ++i)
+    {
+        pool.execute([&]()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            // long enough that every worker gets a share of the burst
+            std::this_thread::sleep_for(50us);
+            if (done.fetch_add(1) + 1 == jobs)
+            {
+                done.notify_all();
+            }
+        });
+    }
+    for (auto current = done.load(); current != jobs; current = done.load())
+    {
+        done.wait(current);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    return threads;
+}
+
+template <typename Pool>
+bool survives_idle(Pool& pool, const char* name)
+{
+    // the persistent workers sit parked well past the timeout, later bursts still land on them
+    auto first = burst(pool, 400);
+    std::this_thread::sleep_for(100ms);
+    bool reused = true;
+    for (int round = 0; round < 5; ++round)
+    {
+        for (auto& id : burst(pool, 200))
+        {
+            reused = reused && first.count(id) == 1;
+        }
+        std::this_thread::sleep_for(30ms);
+    }
+    std::cout << name << ": " << first.size() << " threads, " << (reused ? "no new threads after idling" : "threads were recreated") << "\n";
+    return reused && first.size() == pool.getWorkerCount();
+}
+
+int main()
+{
+    bool ok = true;
+    {
+        Crotine::Xecutor pool(4, 10ms, 4);
+        ok = survives_idle(pool, "Xecutor persistent") && ok;
+    }
+    {
+        Crotine::BasicXecutor<Crotine::RingChannel<Crotine::QueuedJob>> pool(4, 10ms, 4);
+        ok = survives_idle(pool, "RingChannel Xecutor persistent") && ok;
+    }
+
+    // expiring workers still come back, and a mixed pool keeps running jobs through idle phases
+    {
+        Crotine::Xecutor pool(8, 5ms, 2);
+        long long ran = 0;
+        for (int round = 0; round < 20; ++round)
+        {
+            ran += burst(pool, 300).empty() ? 0 : 300;
+            std::this_thread::sleep_for(round % 2 ? 1ms : 15ms);
+        }
+        std::cout << "mixed pool ran " << ran << " jobs over 20 bursts\n";
+        ok = ok && ran == 20 * 300;
+    }
+
+    // a job put while the only worker times out is either taken by that worker or gets a thread of its own
+    {
+        std::atomic_int ran = 0;
+        Crotine::Xecutor pool(1, 1ms);
+        int stranded = 0;
+        for (int i = 0; i < 1000 && stranded == 0; ++i)
+        {
+            pool.execute([&ran]() { ran.fetch_add(1); });
+            auto deadline = std::chrono::steady_clock::now() + 1s;
+            while (ran.load() != i + 1 && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(20us);
+            }
+            stranded = ran.load() == i + 1 ? 0 : 1;
+            // land around the worker's timeout
+            std::this_thread::sleep_for(std::chrono::microseconds(900 + i % 7 * 50));
+        }
+        std::cout << "expiring worker: " << ran.load() << " jobs ran, " << (stranded ? "a job was stranded" : "none stranded") << "\n";
+        ok = ok && stranded == 0;
+    }
+
+    // parked workers are woken by the destructor
+    {
+        Crotine::Xecutor pool(4, 1000ms, 2);
+        burst(pool, 10);
+        std::this_thread::sleep_for(20ms);
+    }
+
+    std::cout << (ok ? "Persistent pool tests passed.\n" : "Persistent pool tests FAILED.\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/TimerWheel.hpp"
+#include "../include/Combinators.hpp"
+
+using namespace std::chrono_literals;
+
+// occupies the only worker until released, so everything posted meanwhile queues up
+struct Gate
+{
+    std::atomic_bool running = false;
+    std::atomic_bool open = false;
+    void hold(Crotine::Executor& executor)
+    {
+        executor.execute([this]()
+        {
+            running = true;
+            running.notify_all();
+            open.wait(false);
+        });
+        running.wait(false);
+    }
+    void release()
+    {
+        open = true;
+        open.notify_all();
+    }
+};
+
+struct Recorder
+{
+    std::mutex mutex;
+    std::string order;
+    void post(Crotine::Executor& executor, char mark, Crotine::Priority priority)
+    {
+        executor.execute_with_priority([this, mark]()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(mark);
+        }, priority);
+    }
+    std::string wait_for(std::size_t count)
+    {
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (order.size() == count)
+                {
+                    return order;
+                }
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+};
+
+Crotine::Task<int> critical_work()
+{
+    co_await Crotine::sleep_for(5ms);
+    co_return 7;
+}
+
+Crotine::Task<int> quick_work()
+{
+    co_return 1;
+}
+
+Crotine::Task<int> background_work()
+{
+    co_return 2;
+}
+
+Crotine::Task<int> mixed_children(bool as_vector)
+{
+    auto background = background_work();
+    background.set_priority(Crotine::Priority::Background);
+    if (as_vector)
+    {
+        std::vector<Crotine::Task<int>> tasks;
+        tasks.push_back(std::move(background));
+        tasks.push_back(quick_work());
+        auto values = co_await Crotine::when_all(std::move(tasks));
+        co_return values[0] + values[1];
+    }
+    auto [first, second] = co_await Crotine::when_all(std::move(background), quick_work());
+    co_return first + second;
+}
+
+int main()
+{
+    bool ok = true;
+
+    // higher lanes run first, FIFO within a lane
+    {
+        Crotine::Xecutor pool(1, 5000ms, 1);
+        Gate gate;
+        Recorder recorder;
+        gate.hold(pool);
+        for (int i = 0; i < 3; ++i)
+        {
+            recorder.post(pool, 'b', Crotine::Priority::Background);
+            recorder.post(pool, 'n', Crotine::Priority::Normal);
+            recorder.post(pool, 'c', Crotine::Priority::Critical);
+        }
+        auto background = pool.getLaneStats(Crotine::Priority::Background);
+        gate.release();
+        auto order = recorder.wait_for(9);
+        std::cout << "run order: " << order << ", background depth before release: " << background.depth << "\n";
+        ok = ok && order == "cccnnnbbb" && background.depth == 3 && background.peak_depth == 3;
+    }
+
+    // a flood of critical work does not starve the background lane
+    {
+        Crotine::Xecutor pool(1, 5000ms, 1);
+        Gate gate;
+        Recorder recorder;
+        gate.hold(pool);
+        recorder.post(pool, 'b', Crotine::Priority::Background);
+        for (int i = 0; i < 200; ++i)
+        {
+            recorder.post(pool, 'c', Crotine::Priority::Critical);
+        }
+        gate.release();
+        auto order = recorder.wait_for(201);
+        auto position = order.find('b');
+        std::cout << "background job ran at position " << position << " of 201\n";
+        ok = ok && position < 20;
+        auto critical = pool.getLaneStats(Crotine::Priority::Critical);
+        ok = ok && critical.taken == 200 && critical.depth == 0 && critical.peak_depth == 200;
+    }
+
+    // a task's priority covers its start and every resumption
+    {
+        Crotine::Xecutor pool(2);
+        auto task = critical_work();
+        task.set_execution_ctx(pool);
+        task.set_priority(Crotine::Priority::Critical);
+        task.execute_async();
+        auto value = task.getPromise().getWaitedValue();
+        auto critical = pool.getLaneStats(Crotine::Priority::Critical);
+        auto normal = pool.getLaneStats(Crotine::Priority::Normal);
+        std::cout << "critical task returned " << value << ", critical lane took " << critical.taken << " jobs, normal lane " << normal.taken << "\n";
+        ok = ok && value == 7 && critical.taken == 2 && normal.taken == 0;
+    }
+
+    // a combinator child keeps its own lane, only children in the parent's lane run inline on the parent's thread
+    for (bool as_vector : {false, true})
+    {
+        Crotine::Xecutor pool(2);
+        auto task = mixed_children(as_vector);
+        task.set_execution_ctx(pool);
+        task.set_priority(Crotine::Priority::Critical);
+        task.execute_async();
+        auto value = task.getPromise().getWaitedValue();
+        auto background = pool.getLaneStats(Crotine::Priority::Background);
+        std::cout << (as_vector ? "when_all(vector)" : "when_all(a, b)") << " background lane took " << background.taken << " jobs\n";
+        ok = ok && value == 3 && background.taken == 1;
+    }
+
+    std::cout << (ok ? "Priority lane tests passed.\n" : "Priority lane tests FAILED.\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+#include <vector>
+#include <thread>
+#include <iostream>
+
+#include "../include/Xecutor.hpp"
+#include "../include/RingChannel.hpp"
+
+int main()
+{
+    constexpr int Producers = 4;
+    constexpr int Consumers = 4;
+    constexpr long long PerProducer = 100000;
+
+    // small capacity so producers regularly hit a full ring
+    Crotine::RingChannel<long long, 64> channel;
+    std::atomic_llong sum = 0;
+    std::atomic_llong received = 0;
+
+    std::vector<std::thread> consumers;
+    for(int i = 0; i < Consumers; ++i)
+    {
+        consumers.emplace_back([&]()
+        {
+            while(auto item = channel.take())
+            {
+                sum.fetch_add(*item);
+                received.fetch_add(1);
+            }
+        });
+    }
+    std::vector<std::thread> producers;
+    for(int i = 0; i < Producers; ++i)
+    {
+        producers.emplace_back([&]()
+        {
+            for(long long value = 1; value <= PerProducer; ++value)
+            {
+                channel.put(value);
+            }
+        });
+    }
+    for(auto& producer : producers)
+    {
+        producer.join();
+    }
+    while(received.load() != Producers * PerProducer)
+    {
+        std::this_thread::yield();
+    }
+    // drained but still open, a timed take has to give up empty handed
+    auto timed = channel.try_take_for(std::chrono::milliseconds(10));
+    std::cout << "Timed take on empty ring returned " << (timed ? "a value" : "nothing") << "\n";
+    channel.close();
+    for(auto& consumer : consumers)
+    {
+        consumer.join();
+    }
+
+    auto expected = Producers * PerProducer * (PerProducer + 1) / 2;
+    std::cout << "Ring channel sum: " << sum.load() << " expected: " << expected << "\n";
+
+    // Xecutor fed by the ring instead of the mutex guarded queue
+    std::atomic_int executed = 0;
+    {
+        Crotine::BasicXecutor<Crotine::RingChannel<Crotine::QueuedJob>> pool(4);
+        for(int i = 0; i < 1000; ++i)
+        {
+            pool.execute([&executed]() { executed.fetch_add(1); });
+        }
+        while(executed.load() != 1000)
+        {
+            std::this_thread::yield();
+        }
+    }
+    std::cout << "Ring backed Xecutor executed " << executed.load() << " tasks\n";
+
+    // the only worker posts far more than the ring holds, the rest spills over instead of spinning forever
+    std::atomic_int spilled = 0;
+    {
+        Crotine::BasicXecutor<Crotine::RingChannel<Crotine::QueuedJob, 64>> pool(1, std::chrono::milliseconds(5000), 1);
+        pool.execute([&pool, &spilled]()
+        {
+            for(int i = 0; i < 1000; ++i)
+            {
+                pool.execute([&spilled]() { spilled.fetch_add(1); });
+            }
+        });
+        while(spilled.load() != 1000)
+        {
+            std::this_thread::yield();
+        }
+    }
+    std::cout << "Full ring spilled over, worker executed " << spilled.load() << " tasks\n";
+    return (sum.load() == expected && !timed && executed.load() == 1000 && spilled.load() == 1000) ? 0 : 1;
+}
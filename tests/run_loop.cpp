@@ -0,0 +1,166 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+#include <coroutine>
+
+#include "../include/Task.hpp"
+#include "../include/RunLoop.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/TimerWheel.hpp"
+#include "../include/Combinators.hpp"
+
+using namespace std::chrono_literals;
+
+// goes to the back of the executor's queue, on a RunLoop that interleaves coroutines in a fixed order
+struct Reschedule
+{
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+        Crotine::PromiseBase::resume_on_ctx(handle);
+    }
+    void await_resume() const noexcept {}
+};
+
+Crotine::Task<int> leaf(std::vector<std::thread::id>& threads, int value)
+{
+    threads.push_back(std::this_thread::get_id());
+    co_return value;
+}
+
+Crotine::Task<int> chain(std::vector<std::thread::id>& threads)
+{
+    threads.push_back(std::this_thread::get_id());
+    auto first = co_await leaf(threads, 1);
+    auto second = co_await leaf(threads, 2);
+    co_await Crotine::sleep_for(2ms);
+    threads.push_back(std::this_thread::get_id());
+    co_return first + second;
+}
+
+Crotine::Task<void> ticker(std::string& log, char name, int rounds)
+{
+    for (int i = 0; i < rounds; ++i)
+    {
+        log += name;
+        log += std::to_string(i);
+        co_await Reschedule{};
+    }
+}
+
+Crotine::Task<std::string> interleaved()
+{
+    std::string log;
+    co_await Crotine::when_all(ticker(log, 'a', 3), ticker(log, 'b', 3));
+    co_return log;
+}
+
+Crotine::Task<std::string> text()
+{
+    co_return std::string(100, 'x');
+}
+
+Crotine::Task<int&> reference(int& value)
+{
+    co_return value;
+}
+
+Crotine::Task<void> failing()
+{
+    co_await Reschedule{};
+    throw std::runtime_error("failed on the loop");
+}
+
+Crotine::Task<bool> on_pool()
+{
+    co_await Crotine::sleep_for(1ms);
+    co_return Crotine::Executor::getCurrentWorkerIndex() != Crotine::Executor::NoWorker;
+}
+
+int main()
+{
+    bool ok = true;
+
+    // the task, its awaited children and its resumption after a timer all run on the calling thread
+    {
+        std::vector<std::thread::id> threads;
+        auto result = Crotine::sync_wait(chain(threads));
+        bool here = threads.size() == 4;
+        for (auto id : threads)
+        {
+            here = here && id == std::this_thread::get_id();
+        }
+        std::cout << "sync_wait " << result << " on the calling thread " << (here ? "only" : "and others") << "\n";
+        ok = ok && result == 3 && here;
+    }
+
+    // FIFO scheduling makes the interleaving reproducible
+    {
+        auto first = Crotine::sync_wait(interleaved());
+        auto second = Crotine::sync_wait(interleaved());
+        std::cout << "interleaving " << first << "\n";
+        ok = ok && first == "a0b0a1b1a2b2" && first == second;
+    }
+
+    // results are moved out, references stay references, exceptions are rethrown
+    {
+        auto moved = Crotine::sync_wait(text());
+        int value = 1;
+        auto& referred = Crotine::sync_wait(reference(value));
+        bool thrown = false;
+        try
+        {
+            Crotine::sync_wait(failing());
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        ok = ok && moved.size() == 100 && &referred == &value && thrown;
+    }
+
+    // stepping by hand, jobs posted by jobs run after the ones already queued
+    {
+        Crotine::RunLoop loop;
+        std::string log;
+        loop.execute([&]()
+        {
+            log += "1";
+            loop.execute([&]() { log += "3"; });
+        });
+        loop.execute([&]() { log += "2"; });
+        bool stepped = loop.run_one() && log == "1";
+        auto ran = loop.poll();
+        bool bound = false;
+        loop.execute([&]() { bound = Crotine::Executor::getCurrentExecutor() == &loop; });
+        loop.run_one();
+        std::cout << "manual steps " << log << ", then " << ran << " more\n";
+        ok = ok && stepped && log == "123" && ran == 2 && !loop.run_one() && bound;
+    }
+
+    // finish() from another thread ends run(), a task placed on a pool runs there while the caller waits
+    {
+        Crotine::RunLoop loop;
+        std::thread stopper([&loop]()
+        {
+            std::this_thread::sleep_for(5ms);
+            loop.finish();
+        });
+        loop.run();
+        stopper.join();
+        Crotine::Xecutor pool(2);
+        auto task = on_pool();
+        task.set_execution_ctx(pool);
+        auto pooled = Crotine::sync_wait(loop, std::move(task));
+        ok = ok && pooled;
+    }
+
+    std::cout << (ok ? "RunLoop tests passed.\n" : "RunLoop tests FAILED.\n");
+    return ok ? 0 : 1;
+}
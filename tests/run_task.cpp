@@ -1,6 +1,7 @@
 #include "../include/Task.hpp"
 #include "../include/Xecutor.hpp"
 #include "../include/TaskRunner.hpp"
+#include "../include/TimerWheel.hpp"
 #include "../include/utils/Function.hpp"
 
 #include <iostream>
@@ -8,7 +9,7 @@
 auto coro_task() -> Crotine::Task<int>
 {
     std::cout << "Coroutine task started\n";
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    co_await Crotine::sleep_for(std::chrono::seconds(1));
     co_return 42;
 }
 
@@ -22,7 +23,7 @@ auto non_coro_task() -> int
 auto coro_param_task(int a, int b) -> Crotine::Task<int>
 {
     std::cout << "Coroutine task with parameters started\n";
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    co_await Crotine::sleep_for(std::chrono::seconds(1));
     co_return a + b;
 }
 
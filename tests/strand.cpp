@@ -0,0 +1,173 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <coroutine>
+
+#include "../include/Task.hpp"
+#include "../include/Strand.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/TimerWheel.hpp"
+#include "../include/Combinators.hpp"
+
+using namespace std::chrono_literals;
+
+// state owned by a strand, nothing but the strand serializes access to it
+struct Session
+{
+    long counter = 0;
+    std::atomic_int inside = 0;
+    std::atomic_bool overlapped = false;
+
+    void enter()
+    {
+        if (inside.fetch_add(1) != 0)
+        {
+            overlapped = true;
+        }
+    }
+    void leave()
+    {
+        inside.fetch_sub(1);
+    }
+};
+
+struct Reschedule
+{
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+        Crotine::PromiseBase::resume_on_ctx(handle);
+    }
+    void await_resume() const noexcept {}
+};
+
+Crotine::Task<void> actor_step(Session& session, Crotine::Strand& strand, std::atomic_int& foreign, int rounds)
+{
+    for (int i = 0; i < rounds; ++i)
+    {
+        session.enter();
+        if (!strand.running_in_this_thread())
+        {
+            foreign.fetch_add(1);
+        }
+        ++session.counter;
+        session.leave();
+        if (i % 8 == 0)
+        {
+            co_await Crotine::sleep_for(1ms);
+        }
+        else
+        {
+            co_await Reschedule{};
+        }
+    }
+}
+
+Crotine::Task<void> actors(Session& session, Crotine::Strand& strand, std::atomic_int& foreign)
+{
+    std::vector<Crotine::Task<void>> steps;
+    for (int i = 0; i < 16; ++i)
+    {
+        steps.push_back(actor_step(session, strand, foreign, 100));
+    }
+    co_await Crotine::when_all(std::move(steps));
+}
+
+int main()
+{
+    bool ok = true;
+    Crotine::Xecutor pool(4);
+
+    // plain jobs from several threads: serialized, nothing lost, FIFO per producer
+    {
+        Crotine::Strand strand(pool);
+        Session session;
+        constexpr int Producers = 4;
+        constexpr int PerProducer = 20000;
+        std::vector<int> last(Producers, -1);
+        bool ordered = true;
+        std::vector<std::thread> producers;
+        for (int p = 0; p < Producers; ++p)
+        {
+            producers.emplace_back([&, p]()
+            {
+                for (int i = 0; i < PerProducer; ++i)
+                {
+                    strand.execute([&, p, i]()
+                    {
+                        session.enter();
+                        ++session.counter;
+                        ordered = ordered && last[p] == i - 1;
+                        last[p] = i;
+                        session.leave();
+                    });
+                }
+            });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        std::atomic_bool drained = false;
+        strand.execute([&drained]()
+        {
+            drained = true;
+            drained.notify_one();
+        });
+        drained.wait(false);
+        std::cout << "strand ran " << session.counter << " jobs, " << (session.overlapped ? "overlapping" : "one at a time")
+            << ", " << (ordered ? "in order" : "out of order") << "\n";
+        ok = ok && session.counter == Producers * PerProducer && !session.overlapped && ordered;
+    }
+
+    // coroutines on a strand share state without a lock, their children inherit the strand
+    {
+        Crotine::Strand strand(pool);
+        Session session;
+        std::atomic_int foreign = 0;
+        auto task = actors(session, strand, foreign);
+        task.set_execution_ctx(strand);
+        task.execute_async();
+        task.getPromise().Wait();
+        std::cout << "actors counted " << session.counter << ", " << foreign.load() << " steps off the strand\n";
+        ok = ok && session.counter == 1600 && !session.overlapped && foreign == 0;
+    }
+
+    // two strands on one pool still run in parallel with each other
+    {
+        Crotine::Strand first(pool);
+        Crotine::Strand second(pool);
+        std::atomic_int arrived = 0;
+        std::atomic_bool both = false;
+        auto meet = [&]()
+        {
+            arrived.fetch_add(1);
+            auto deadline = std::chrono::steady_clock::now() + 2s;
+            while (arrived.load() < 2 && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::yield();
+            }
+            if (arrived.load() == 2)
+            {
+                both = true;
+            }
+        };
+        std::atomic_int done = 0;
+        first.execute([&]() { meet(); done.fetch_add(1); });
+        second.execute([&]() { meet(); done.fetch_add(1); });
+        while (done.load() != 2)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+        std::cout << "two strands " << (both ? "ran side by side" : "were serialized") << "\n";
+        ok = ok && both;
+    }
+
+    std::cout << (ok ? "Strand tests passed.\n" : "Strand tests FAILED.\n");
+    return ok ? 0 : 1;
+}
@@ -1,16 +1,17 @@
 #include <string>
 #include <iostream>
 #include "../include/Task.hpp"
+#include "../include/TimerWheel.hpp"
 
 Crotine::Task<int> produceValue()
 {
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    co_await Crotine::sleep_for(std::chrono::seconds(2));
     co_return 42;
 }
 
 Crotine::Task<std::string> produceStrValue()
 {
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    co_await Crotine::sleep_for(std::chrono::seconds(1));
     std::cout << "Producing string value...\n";
     co_return "Hello, Crotine!";
 }
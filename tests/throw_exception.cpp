@@ -1,6 +1,8 @@
 #include "../include/Task.hpp"
 #include "../include/utils/Function.hpp"
 
+#include <iostream>
+
 Crotine::Task<void> Use_op(Crotine::Task<int> task)
 {
     try
@@ -0,0 +1,166 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <iostream>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/TimerWheel.hpp"
+
+using namespace std::chrono_literals;
+
+Crotine::Task<void> nap(std::chrono::milliseconds duration, std::atomic_int& woken)
+{
+    co_await Crotine::sleep_for(duration);
+    woken.fetch_add(1);
+}
+
+Crotine::Task<int> slow_value(std::chrono::milliseconds duration, int value)
+{
+    co_await Crotine::sleep_for(duration);
+    co_return value;
+}
+
+Crotine::Task<int> guarded(std::chrono::milliseconds work, std::chrono::milliseconds timeout)
+{
+    try
+    {
+        co_return co_await Crotine::with_timeout(slow_value(work, 7), timeout);
+    }
+    catch (const Crotine::TimeoutError&)
+    {
+        co_return -1;
+    }
+}
+
+// how many of rounds sleeps returned before the requested duration passed
+Crotine::Task<int> count_early(std::chrono::microseconds duration, int rounds)
+{
+    int early = 0;
+    for (int i = 0; i < rounds; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        co_await Crotine::sleep_for(duration);
+        if (std::chrono::steady_clock::now() - start < duration)
+        {
+            ++early;
+        }
+    }
+    co_return early;
+}
+
+template <typename T>
+T run_on(Crotine::Executor& executor, Crotine::Task<T> task)
+{
+    task.set_execution_ctx(executor);
+    task.execute_async();
+    return task.getPromise().getWaitedValue();
+}
+
+int main()
+{
+    bool ok = true;
+    Crotine::Xecutor pool(4);
+
+    // a single sleep never wakes up early
+    {
+        std::atomic_int woken = 0;
+        auto start = std::chrono::steady_clock::now();
+        run_on(pool, nap(30ms, woken));
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "sleep_for(30ms) took " << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << "ms\n";
+        ok = ok && elapsed >= 30ms && woken.load() == 1;
+    }
+
+    // concurrent sleepers wake the timer thread mid-tick, none of them may fire before its own deadline
+    {
+        auto sleeper = count_early(2500us, 200);
+        auto disturber = count_early(1300us, 400);
+        sleeper.set_execution_ctx(pool);
+        disturber.set_execution_ctx(pool);
+        sleeper.execute_async();
+        disturber.execute_async();
+        auto early = sleeper.getPromise().getWaitedValue();
+        auto disturber_early = disturber.getPromise().getWaitedValue();
+        std::cout << "concurrent sleepers woken early: " << early << " / " << disturber_early << "\n";
+        ok = ok && early == 0 && disturber_early == 0;
+    }
+
+    // tens of thousands of sleepers on four threads, none of them holds a thread while pending
+    {
+        constexpr int Count = 20000;
+        std::atomic_int woken = 0;
+        std::vector<Crotine::Task<void>> tasks;
+        tasks.reserve(Count);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < Count; ++i)
+        {
+            tasks.push_back(nap(std::chrono::milliseconds(300 + i % 100), woken));
+            tasks.back().set_execution_ctx(pool);
+            tasks.back().execute_async();
+        }
+        std::this_thread::sleep_for(20ms);
+        auto pending = Crotine::TimerWheel::getDefaultTimer().getPendingCount();
+        for (auto& task : tasks)
+        {
+            task.getPromise().Wait();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << Count << " sleepers, " << pending << " pending at once, all woken after "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << "ms\n";
+        ok = ok && woken.load() == Count && pending > Count / 2 && elapsed < 3s;
+    }
+
+    // sleep_until with a deadline in the past completes right away
+    {
+        auto task = []() -> Crotine::Task<int>
+        {
+            co_await Crotine::sleep_until(std::chrono::steady_clock::now() - 1s);
+            co_return 1;
+        }();
+        ok = ok && run_on(pool, std::move(task)) == 1;
+    }
+
+    // with_timeout lets a fast task through and cuts off a slow one
+    {
+        auto fast = run_on(pool, guarded(10ms, 500ms));
+        auto slow = run_on(pool, guarded(500ms, 20ms));
+        std::cout << "with_timeout: fast task -> " << fast << ", slow task -> " << slow << "\n";
+        ok = ok && fast == 7 && slow == -1;
+    }
+
+    // void tasks propagate their exception instead of a value
+    {
+        auto failing = []() -> Crotine::Task<int>
+        {
+            try
+            {
+                co_await Crotine::with_timeout([]() -> Crotine::Task<void>
+                {
+                    co_await Crotine::sleep_for(1ms);
+                    throw std::runtime_error("boom");
+                }(), 500ms);
+            }
+            catch (const std::runtime_error& error)
+            {
+                co_return std::string(error.what()) == "boom" ? 1 : 0;
+            }
+            co_return 0;
+        }();
+        ok = ok && run_on(pool, std::move(failing)) == 1;
+    }
+
+    // a task that finished in time disarms its timer
+    {
+        run_on(pool, guarded(1ms, 10s));
+        auto pending = Crotine::TimerWheel::getDefaultTimer().getPendingCount();
+        std::cout << "timers left after an early finish: " << pending << "\n";
+        // only the slow task cut off above may still be sleeping
+        ok = ok && pending <= 1;
+    }
+
+    std::cout << (ok ? "Timer tests passed.\n" : "Timer tests FAILED.\n");
+    return ok ? 0 : 1;
+}
@@ -4,16 +4,17 @@
 #include "../include/Task.hpp"
 #include "../include/Xecutor.hpp"
 #include "../include/utils/Context.hpp"
+#include "../include/TimerWheel.hpp"
 
 Crotine::Task<int> computeSquare(int num)
 {
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    co_await Crotine::sleep_for(std::chrono::seconds(1));
     co_return num * num;
 }
 
 Crotine::Task<int> computeCube(int num)
 {
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    co_await Crotine::sleep_for(std::chrono::seconds(2));
     co_return num * num * num;
 }
 
@@ -1,33 +1,36 @@
 #include <string>
 #include <iostream>
 #include "../include/Task.hpp"
+#include "../include/TimerWheel.hpp"
 
 int main()
 {
     int x = 10;
+    int returned = 0;
 
-
+    // named, the coroutines keep using the captures long after they were created
     auto task1 = [&]() -> Crotine::Task<int>
     {
         std::cout << "Task 1 started with x = " << x << "\n";
         ++x;
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        co_await Crotine::sleep_for(std::chrono::seconds(1));
         std::cout << "Task 1 completed with x = " << x << "\n";
         co_return x;
     };
 
-    auto task2 = [&]() -> Crotine::Task<void>
+    auto body = [&]() -> Crotine::Task<void>
     {
         auto tsk = task1();
         tsk.execute_async();
-        std::cout << "Task 2 started with x = " << x << "\n";
-        auto val = co_await tsk;
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        std::cout << "Task 2 started\n";
+        returned = co_await tsk;
+        co_await Crotine::sleep_for(std::chrono::seconds(1));
         std::cout << "Task completed with x = " << x << "\n";
-    }();
+    };
 
+    auto task2 = body();
     task2.execute_async();
-    task2.getPromise().Wait();
+    task2.getPromise().getWaitedValue();
     std::cout << "Main thread continues with x = " << x << "\n";
-    return 0;
-}
\ No newline at end of file
+    return returned == 11 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/TimerWheel.hpp"
+#include "../include/Combinators.hpp"
+
+using namespace std::chrono_literals;
+
+Crotine::Task<int> square(int num, std::chrono::milliseconds delay)
+{
+    co_await Crotine::sleep_for(delay);
+    co_return num * num;
+}
+
+Crotine::Task<std::string> label(std::string text)
+{
+    co_return text;
+}
+
+Crotine::Task<void> nothing()
+{
+    co_return;
+}
+
+Crotine::Task<void> fail()
+{
+    co_await Crotine::sleep_for(5ms);
+    throw std::runtime_error("child failed");
+}
+
+Crotine::Task<bool> all_of_mixed()
+{
+    auto [a, b, none] = co_await Crotine::when_all(square(3, 20ms), label("nine"), nothing());
+    co_return none == std::monostate{} && a == 9 && b == "nine";
+}
+
+Crotine::Task<int> all_of_range(int count)
+{
+    std::vector<Crotine::Task<int>> tasks;
+    for (int i = 0; i < count; ++i)
+    {
+        tasks.push_back(square(i, std::chrono::milliseconds(i % 3)));
+    }
+    auto values = co_await Crotine::when_all(std::move(tasks));
+    int sum = 0;
+    for (auto value : values)
+    {
+        sum += value;
+    }
+    co_return sum;
+}
+
+Crotine::Task<bool> all_of_failing()
+{
+    try
+    {
+        co_await Crotine::when_all(square(2, 1ms), fail());
+    }
+    catch (const std::runtime_error& error)
+    {
+        co_return std::string(error.what()) == "child failed";
+    }
+    co_return false;
+}
+
+Crotine::Task<std::size_t> first_of(std::chrono::milliseconds slow)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto [index, value] = co_await Crotine::when_any(square(5, slow), square(6, 5ms), square(7, slow));
+    // the losers are still sleeping, the parent went on without them
+    if (std::chrono::steady_clock::now() - start >= slow || value != 36)
+    {
+        co_return 99;
+    }
+    co_return index;
+}
+
+template <typename T>
+T run_on(Crotine::Executor& executor, Crotine::Task<T> task)
+{
+    task.set_execution_ctx(executor);
+    task.execute_async();
+    return task.getPromise().getWaitedValue();
+}
+
+int main()
+{
+    bool ok = true;
+    Crotine::Xecutor pool(4);
+
+    auto mixed = run_on(pool, all_of_mixed());
+    std::cout << "when_all over mixed tasks: " << (mixed ? "ok" : "wrong") << "\n";
+    ok = ok && mixed;
+
+    constexpr int Count = 1000;
+    int expected = 0;
+    for (int i = 0; i < Count; ++i)
+    {
+        expected += i * i;
+    }
+    auto sum = run_on(pool, all_of_range(Count));
+    std::cout << "when_all over " << Count << " tasks: " << sum << " (expected " << expected << ")\n";
+    ok = ok && sum == expected;
+
+    auto failed = run_on(pool, all_of_failing());
+    std::cout << "when_all rethrows a child's exception: " << (failed ? "ok" : "wrong") << "\n";
+    ok = ok && failed;
+
+    auto winner = run_on(pool, first_of(300ms));
+    std::cout << "when_any winner: " << winner << "\n";
+    ok = ok && winner == 1;
+
+    // the losers of a when_any over a range outlive the parent and clean up after themselves
+    auto range_winner = run_on(pool, []() -> Crotine::Task<std::size_t>
+    {
+        std::vector<Crotine::Task<int>> tasks;
+        tasks.push_back(square(1, 50ms));
+        tasks.push_back(square(2, 1ms));
+        auto [index, value] = co_await Crotine::when_any(std::move(tasks));
+        co_return value == 4 ? index : 99;
+    }());
+    std::cout << "when_any over a range winner: " << range_winner << "\n";
+    ok = ok && range_winner == 1;
+    std::this_thread::sleep_for(400ms);
+
+    std::cout << (ok ? "Combinator tests passed.\n" : "Combinator tests FAILED.\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include <vector>
+#include <iostream>
+
+#include "../include/Task.hpp"
+#include "../include/Xecutor.hpp"
+#include "../include/StealingXecutor.hpp"
+#include "../include/utils/Context.hpp"
+
+Crotine::Task<bool> same_context(Crotine::Executor& expected)
+{
+    auto& ctx = co_await Crotine::get_Execution_Context{};
+    co_return &ctx == &expected && Crotine::Executor::getCurrentExecutor() == &expected;
+}
+
+// per worker counters indexed by the worker slot, no locking needed
+template <typename Pool>
+bool shard(Pool& pool, int jobs)
+{
+    std::vector<long long> shards(pool.getWorkerCount(), 0);
+    std::atomic_int done = 0;
+    std::atomic_bool in_range = true;
+    for (int i = 0; i < jobs; ++i)
+    {
+        pool.execute([&]()
+        {
+            auto index = Crotine::Executor::getCurrentWorkerIndex();
+            if (index >= shards.size())
+            {
+                in_range.store(false);
+            }
+            else
+            {
+                ++shards[index];
+            }
+            done.fetch_add(1);
+        });
+    }
+    while (done.load() != jobs)
+    {
+        std::this_thread::yield();
+    }
+    long long total = 0;
+    for (auto count : shards)
+    {
+        total += count;
+    }
+    return in_range.load() && total == jobs;
+}
+
+int main()
+{
+    Crotine::Xecutor pool(4);
+    Crotine::StealingXecutor stealing(4);
+
+    auto task = same_context(pool);
+    task.set_execution_ctx(pool);
+    task.execute_async();
+    auto context_ok = task.getPromise().getWaitedValue();
+
+    auto xecutor_ok = shard(pool, 10000);
+    auto stealing_ok = shard(stealing, 10000);
+    auto outside = Crotine::Executor::getCurrentExecutor() == nullptr && Crotine::Executor::getCurrentWorkerIndex() == Crotine::Executor::NoWorker;
+
+    std::cout << "Context lookup: " << context_ok << ", Xecutor shards: " << xecutor_ok << ", StealingXecutor shards: " << stealing_ok << ", main thread unbound: " << outside << "\n";
+    return (context_ok && xecutor_ok && stealing_ok && outside) ? 0 : 1;
+}